@@ -12,7 +12,10 @@
 #include "sensors/sensor_manager.h"
 #include "voice_command_parser.h"
 
+#include <algorithm>
 #include <cstring>
+#include <ctime>
+#include <mbedtls/base64.h>
 #include <esp_log.h>
 #include <cJSON.h>
 #include <driver/gpio.h>
@@ -21,6 +24,10 @@
 
 #define TAG "Application"
 
+// Retry delay after failed telemetry uploads, doubled on every failure in a row
+#define TELEMETRY_RETRY_MIN_S 30
+#define TELEMETRY_RETRY_MAX_S (30 * 60)
+
 
 Application::Application() {
     event_group_ = xEventGroupCreate();
@@ -38,6 +45,7 @@ Application::Application() {
     esp_timer_create_args_t clock_timer_args = {
         .callback = [](void* arg) {
             Application* app = (Application*)arg;
+            app->clock_tick_time_ = esp_timer_get_time();
             xEventGroupSetBits(app->event_group_, MAIN_EVENT_CLOCK_TICK);
         },
         .arg = this,
@@ -133,6 +141,22 @@ void Application::Initialize() {
             ESP_LOGI(TAG, "I2C bus created successfully");
             // Initialize sensor manager
             auto& sensor_manager = SensorManager::GetInstance();
+            // 传感器规则在采样任务中评估，触发后切换到主任务执行动作
+            sensor_manager.GetRules().OnRuleTriggered([this](const SensorRuleInfo& rule) {
+                Schedule([this, rule]() {
+                    switch (rule.action) {
+                    case kSensorRuleActionAlert:
+                        Alert("传感器提醒", rule.message.c_str(), "bell", Lang::Sounds::OGG_EXCLAMATION);
+                        break;
+                    case kSensorRuleActionSound:
+                        audio_service_.PlaySound(Lang::Sounds::OGG_EXCLAMATION);
+                        break;
+                    case kSensorRuleActionReminder:
+                        reminder_timer_.SetReminder(1, rule.message);
+                        break;
+                    }
+                });
+            });
             if (!sensor_manager.Initialize(i2c_bus)) {
                 ESP_LOGE(TAG, "Failed to initialize sensor manager");
             } else {
@@ -240,6 +264,7 @@ void Application::Initialize() {
 }
 
 void Application::Run() {
+    main_task_handle_ = xTaskGetCurrentTaskHandle();
     // Set the priority of the main task to 10
     vTaskPrioritySet(nullptr, 10);
 
@@ -324,6 +349,11 @@ void Application::Run() {
 
         if (bits & MAIN_EVENT_CLOCK_TICK) {
             clock_ticks_++;
+            // Time from the clock timer firing to the main loop handling it
+            int latency_us = (int)(esp_timer_get_time() - clock_tick_time_);
+            if (latency_us > max_clock_tick_latency_us_) {
+                max_clock_tick_latency_us_ = latency_us;
+            }
             auto display = Board::GetInstance().GetDisplay();
             display->UpdateStatusBar();
         
@@ -331,15 +361,81 @@ void Application::Run() {
             if (GetDeviceState() == kDeviceStateIdle) {
                 display->UpdateStandbyScreen();
             }
+
+#ifdef CONFIG_SENSOR_TELEMETRY
+            UploadTelemetry(false);
+#endif
         
             // Print debug info every 10 seconds
             if (clock_ticks_ % 10 == 0) {
                 SystemInfo::PrintHeapStats();
+                ESP_LOGI(TAG, "Main loop clock tick latency: max %d us", max_clock_tick_latency_us_);
+                max_clock_tick_latency_us_ = 0;
+                // Redraw cost, e.g. of the standby screen while idle (state changes restart clock_ticks_)
+                uint32_t flushed_pixels = display->GetFlushedPixels();
+                int64_t now_us = esp_timer_get_time();
+                if (last_flushed_pixels_time_ != 0) {
+                    unsigned long long pixels = flushed_pixels - last_flushed_pixels_;
+                    ESP_LOGI(TAG, "Display flushed %llu px/s", pixels * 1000000 / (now_us - last_flushed_pixels_time_));
+                }
+                last_flushed_pixels_ = flushed_pixels;
+                last_flushed_pixels_time_ = now_us;
             }
         }
     }
 }
 
+void Application::SetPowerSaveLevel(PowerSaveLevel level) {
+    Board::GetInstance().SetPowerSaveLevel(level);
+    SensorManager::GetInstance().SetPowerSaveLevel(level);
+}
+
+#ifdef CONFIG_SENSOR_TELEMETRY
+void Application::UploadTelemetry(bool opportunistic) {
+    auto telemetry = SensorManager::GetInstance().GetTelemetry();
+    if (telemetry == nullptr || !protocol_) {
+        return;
+    }
+    if (opportunistic ? telemetry->pending() == 0 : !telemetry->IsFlushDue(time(nullptr))) {
+        return;
+    }
+    // After a failed send the clock tick waits out the backoff; a newly opened audio channel
+    // shows the link is up again and may try right away
+    if (!opportunistic && esp_timer_get_time() < telemetry_retry_time_) {
+        return;
+    }
+    // Never open a connection just for telemetry, wait for one that is already up
+    if (!protocol_->IsConnected()) {
+        return;
+    }
+
+    std::string batch;
+    uint32_t last_sequence = 0;
+    size_t count = telemetry->EncodeBatch(batch, last_sequence);
+    size_t encoded_size = 0;
+    mbedtls_base64_encode(nullptr, 0, &encoded_size, (const unsigned char*)batch.data(), batch.size());
+    std::string encoded(encoded_size, '\0');
+    if (mbedtls_base64_encode((unsigned char*)encoded.data(), encoded.size(), &encoded_size,
+            (const unsigned char*)batch.data(), batch.size()) != 0) {
+        ESP_LOGE(TAG, "Failed to encode telemetry batch");
+        return;
+    }
+    encoded.resize(encoded_size);
+
+    if (protocol_->SendTelemetry(encoded, count)) {
+        telemetry->Commit(last_sequence, count, batch.size());
+        telemetry_failures_ = 0;
+        telemetry_retry_time_ = 0;
+    } else {
+        // 30 s, 1 min, 2 min ... up to 30 min between attempts
+        int64_t delay_s = std::min<int64_t>(TELEMETRY_RETRY_MAX_S, (int64_t)TELEMETRY_RETRY_MIN_S << std::min(telemetry_failures_, 6));
+        telemetry_failures_++;
+        telemetry_retry_time_ = esp_timer_get_time() + delay_s * 1000000;
+        ESP_LOGW(TAG, "Telemetry upload failed %d times, retrying in %d s", telemetry_failures_, (int)delay_s);
+    }
+}
+#endif
+
 void Application::HandleNetworkConnectedEvent() {
     ESP_LOGI(TAG, "Network connected");
     auto state = GetDeviceState();
@@ -393,8 +489,7 @@ void Application::HandleActivationDoneEvent() {
 
     // Release OTA object after activation is complete
     ota_.reset();
-    auto& board = Board::GetInstance();
-    board.SetPowerSaveLevel(PowerSaveLevel::LOW_POWER);
+    SetPowerSaveLevel(PowerSaveLevel::LOW_POWER);
 
     Schedule([this]() {
         // Play the success sound to indicate the device is ready
@@ -449,7 +544,7 @@ void Application::CheckAssetsVersion() {
         // Wait for the audio service to be idle for 3 seconds
         vTaskDelay(pdMS_TO_TICKS(3000));
         SetDeviceState(kDeviceStateUpgrading);
-        board.SetPowerSaveLevel(PowerSaveLevel::PERFORMANCE);
+        SetPowerSaveLevel(PowerSaveLevel::PERFORMANCE);
         display->SetChatMessage("system", Lang::Strings::PLEASE_WAIT);
 
         bool success = assets.Download(download_url, [this, display](int progress, size_t speed) -> void {
@@ -460,7 +555,7 @@ void Application::CheckAssetsVersion() {
             });
         });
 
-        board.SetPowerSaveLevel(PowerSaveLevel::LOW_POWER);
+        SetPowerSaveLevel(PowerSaveLevel::LOW_POWER);
         vTaskDelay(pdMS_TO_TICKS(1000));
 
         if (!success) {
@@ -586,16 +681,24 @@ void Application::InitializeProtocol() {
         }
     });
     
-    protocol_->OnAudioChannelOpened([this, codec, &board]() {
-        board.SetPowerSaveLevel(PowerSaveLevel::PERFORMANCE);
+    protocol_->OnAudioChannelOpened([this, codec]() {
+        SetPowerSaveLevel(PowerSaveLevel::PERFORMANCE);
+#ifdef CONFIG_SENSOR_TELEMETRY
+        // The radio is awake for the session anyway, send whatever telemetry is pending
+        Schedule([this]() {
+            UploadTelemetry(true);
+        });
+#endif
         if (protocol_->server_sample_rate() != codec->output_sample_rate()) {
             ESP_LOGW(TAG, "Server sample rate %d does not match device output sample rate %d, resampling may cause distortion",
                 protocol_->server_sample_rate(), codec->output_sample_rate());
         }
     });
     
-    protocol_->OnAudioChannelClosed([this, &board]() {
-        board.SetPowerSaveLevel(PowerSaveLevel::LOW_POWER);
+    protocol_->OnAudioChannelClosed([this]() {
+        SetPowerSaveLevel(PowerSaveLevel::LOW_POWER);
+        // The MCP session ends with the audio channel, results of pending tool calls are useless
+        McpServer::GetInstance().CancelToolCalls();
         Schedule([this]() {
             auto display = Board::GetInstance().GetDisplay();
             display->SetChatMessage("system", "");
@@ -743,7 +846,7 @@ void Application::InitializeProtocol() {
             }
         } else if (strcmp(type->valuestring, "mcp") == 0) {
             auto payload = cJSON_GetObjectItem(root, "payload");
-            if (cJSON_IsObject(payload)) {
+            if (cJSON_IsObject(payload) || cJSON_IsArray(payload)) {
                 McpServer::GetInstance().ParseMessage(payload);
             }
         } else if (strcmp(type->valuestring, "system") == 0) {
@@ -1187,7 +1290,7 @@ bool Application::UpgradeFirmware(const std::string& url, const std::string& ver
     std::string message = std::string(Lang::Strings::NEW_VERSION) + version_info;
     display->SetChatMessage("system", message.c_str());
 
-    board.SetPowerSaveLevel(PowerSaveLevel::PERFORMANCE);
+    SetPowerSaveLevel(PowerSaveLevel::PERFORMANCE);
     audio_service_.Stop();
     vTaskDelay(pdMS_TO_TICKS(1000));
 
@@ -1203,7 +1306,7 @@ bool Application::UpgradeFirmware(const std::string& url, const std::string& ver
         // Upgrade failed, restart audio service and continue running
         ESP_LOGE(TAG, "Firmware upgrade failed, restarting audio service and continuing operation...");
         audio_service_.Start(); // Restart audio service
-        board.SetPowerSaveLevel(PowerSaveLevel::LOW_POWER); // Restore power save level
+        SetPowerSaveLevel(PowerSaveLevel::LOW_POWER); // Restore power save level
         Alert(Lang::Strings::ERROR, Lang::Strings::UPGRADE_FAILED, "circle_xmark", Lang::Sounds::OGG_EXCLAMATION);
         vTaskDelay(pdMS_TO_TICKS(3000));
         return false;
@@ -11,6 +11,7 @@
 #include <mutex>
 #include <deque>
 #include <memory>
+#include <atomic>
 
 #include "protocol.h"
 #include "ota.h"
@@ -68,6 +69,7 @@ public:
 
     DeviceState GetDeviceState() const { return state_machine_.GetState(); }
     bool IsVoiceDetected() const { return audio_service_.IsVoiceDetected(); }
+    bool IsMainTask() const { return xTaskGetCurrentTaskHandle() == main_task_handle_; }
     
     /**
      * Request state transition
@@ -163,7 +165,16 @@ private:
     bool reminder_tts_active_ = false;     // Flag to track if reminder TTS is playing
     esp_timer_handle_t reminder_tts_timer_ = nullptr;  // Timer for TTS timeout handling
     int clock_ticks_ = 0;
+    std::atomic<int64_t> clock_tick_time_ = 0;
+    int max_clock_tick_latency_us_ = 0;
+    uint32_t last_flushed_pixels_ = 0;
+    int64_t last_flushed_pixels_time_ = 0;
     TaskHandle_t activation_task_handle_ = nullptr;
+    TaskHandle_t main_task_handle_ = nullptr;
+#ifdef CONFIG_SENSOR_TELEMETRY
+    int telemetry_failures_ = 0;        // Failed uploads in a row, for the retry backoff
+    int64_t telemetry_retry_time_ = 0;  // esp_timer time before which scheduled uploads wait
+#endif
 
 
     // Event handlers
@@ -186,6 +197,11 @@ private:
     void CheckNewVersion();
     void InitializeProtocol();
     void ShowActivationCode(const std::string& code, const std::string& message);
+#ifdef CONFIG_SENSOR_TELEMETRY
+    void UploadTelemetry(bool opportunistic);
+#endif
+    // Board radio/CPU power save level, also bounds how slowly the sensors are sampled
+    void SetPowerSaveLevel(PowerSaveLevel level);
     void SetListeningMode(ListeningMode mode);
     ListeningMode GetDefaultListeningMode() const;
     
@@ -23,17 +23,42 @@ I2cDevice::I2cDevice(i2c_master_bus_handle_t i2c_bus, uint8_t addr) {
     assert(i2c_device_ != NULL);
 }
 
+I2cDevice::I2cDevice(I2cTransport* transport) : transport_(transport) {
+    assert(transport_ != nullptr);
+}
+
+esp_err_t I2cDevice::Transmit(const uint8_t* data, size_t length, int timeout_ms) {
+    if (transport_ != nullptr) {
+        return transport_->Transmit(data, length, timeout_ms);
+    }
+    return i2c_master_transmit(i2c_device_, data, length, timeout_ms);
+}
+
+esp_err_t I2cDevice::Receive(uint8_t* buffer, size_t length, int timeout_ms) {
+    if (transport_ != nullptr) {
+        return transport_->Receive(buffer, length, timeout_ms);
+    }
+    return i2c_master_receive(i2c_device_, buffer, length, timeout_ms);
+}
+
+esp_err_t I2cDevice::TransmitReceive(const uint8_t* data, size_t length, uint8_t* buffer, size_t buffer_length, int timeout_ms) {
+    if (transport_ != nullptr) {
+        return transport_->TransmitReceive(data, length, buffer, buffer_length, timeout_ms);
+    }
+    return i2c_master_transmit_receive(i2c_device_, data, length, buffer, buffer_length, timeout_ms);
+}
+
 void I2cDevice::WriteReg(uint8_t reg, uint8_t value) {
     uint8_t buffer[2] = {reg, value};
-    ESP_ERROR_CHECK(i2c_master_transmit(i2c_device_, buffer, 2, 100));
+    ESP_ERROR_CHECK(Transmit(buffer, 2));
 }
 
 uint8_t I2cDevice::ReadReg(uint8_t reg) {
     uint8_t buffer[1];
-    ESP_ERROR_CHECK(i2c_master_transmit_receive(i2c_device_, &reg, 1, buffer, 1, 100));
+    ESP_ERROR_CHECK(TransmitReceive(&reg, 1, buffer, 1));
     return buffer[0];
 }
 
 void I2cDevice::ReadRegs(uint8_t reg, uint8_t* buffer, size_t length) {
-    ESP_ERROR_CHECK(i2c_master_transmit_receive(i2c_device_, &reg, 1, buffer, length, 100));
+    ESP_ERROR_CHECK(TransmitReceive(&reg, 1, buffer, length));
 }
\ No newline at end of file
@@ -3,12 +3,28 @@
 
 #include <driver/i2c_master.h>
 
+// Byte-level I2C transactions of one device; implemented by the I2C master driver or a simulator
+class I2cTransport {
+public:
+    virtual ~I2cTransport() = default;
+    virtual esp_err_t Transmit(const uint8_t* data, size_t length, int timeout_ms) = 0;
+    virtual esp_err_t Receive(uint8_t* buffer, size_t length, int timeout_ms) = 0;
+    virtual esp_err_t TransmitReceive(const uint8_t* data, size_t length, uint8_t* buffer, size_t buffer_length, int timeout_ms) = 0;
+};
+
 class I2cDevice {
 public:
     I2cDevice(i2c_master_bus_handle_t i2c_bus, uint8_t addr);
+    // Routes all transactions through the transport instead of the I2C master driver
+    I2cDevice(I2cTransport* transport);
 
 protected:
-    i2c_master_dev_handle_t i2c_device_;
+    i2c_master_dev_handle_t i2c_device_ = nullptr;
+    I2cTransport* transport_ = nullptr;
+
+    esp_err_t Transmit(const uint8_t* data, size_t length, int timeout_ms = 100);
+    esp_err_t Receive(uint8_t* buffer, size_t length, int timeout_ms = 100);
+    esp_err_t TransmitReceive(const uint8_t* data, size_t length, uint8_t* buffer, size_t buffer_length, int timeout_ms = 100);
 
     void WriteReg(uint8_t reg, uint8_t value);
     uint8_t ReadReg(uint8_t reg);
@@ -2,6 +2,7 @@
 
 #include "audio_codec.h"
 #include "display.h"
+#include "sensors/sensor_manager.h"
 
 #include <esp_log.h>
 #include <esp_timer.h>
@@ -262,6 +263,22 @@ std::string Ml307Board::GetDeviceStatusJson() {
     }
     cJSON_AddItemToObject(root, "network", network);
 
+    // DHT20 sensor temperature and humidity
+    try {
+        auto& sensor_manager = SensorManager::GetInstance();
+        // Follow-up questions in this conversation should see fresh readings
+        sensor_manager.RequestSamplePeriod(CONFIG_DHT20_SAMPLE_INTERVAL_MS, 5 * 60 * 1000);
+        float temperature, humidity;
+        if (sensor_manager.ReadTemperatureHumidity(temperature, humidity)) {
+            auto sensor = cJSON_CreateObject();
+            cJSON_AddNumberToObject(sensor, "temperature", temperature);
+            cJSON_AddNumberToObject(sensor, "humidity", humidity);
+            cJSON_AddItemToObject(root, "sensor", sensor);
+        }
+    } catch (...) {
+        // Sensor manager not initialized
+    }
+
     auto json_str = cJSON_PrintUnformatted(root);
     std::string json(json_str);
     cJSON_free(json_str);
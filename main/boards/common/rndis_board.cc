@@ -4,6 +4,7 @@
 #include "system_info.h"
 #include "settings.h"
 #include "assets/lang_config.h"
+#include "sensors/sensor_manager.h"
 
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
@@ -238,6 +239,22 @@ std::string RndisBoard::GetDeviceStatusJson() {
         cJSON_AddItemToObject(root, "chip", chip);
     }
 
+    // DHT20 sensor temperature and humidity
+    try {
+        auto& sensor_manager = SensorManager::GetInstance();
+        // Follow-up questions in this conversation should see fresh readings
+        sensor_manager.RequestSamplePeriod(CONFIG_DHT20_SAMPLE_INTERVAL_MS, 5 * 60 * 1000);
+        float temperature, humidity;
+        if (sensor_manager.ReadTemperatureHumidity(temperature, humidity)) {
+            auto sensor = cJSON_CreateObject();
+            cJSON_AddNumberToObject(sensor, "temperature", temperature);
+            cJSON_AddNumberToObject(sensor, "humidity", humidity);
+            cJSON_AddItemToObject(root, "sensor", sensor);
+        }
+    } catch (...) {
+        // Sensor manager not initialized
+    }
+
     auto str = cJSON_PrintUnformatted(root);
     std::string result(str);
     cJSON_free(str);
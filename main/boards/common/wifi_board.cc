@@ -354,6 +354,8 @@ std::string WifiBoard::GetDeviceStatusJson() {
     // DHT20 sensor temperature and humidity
     try {
         auto& sensor_manager = SensorManager::GetInstance();
+        // Follow-up questions in this conversation should see fresh readings
+        sensor_manager.RequestSamplePeriod(CONFIG_DHT20_SAMPLE_INTERVAL_MS, 5 * 60 * 1000);
         float temperature, humidity;
         if (sensor_manager.ReadTemperatureHumidity(temperature, humidity)) {
             auto sensor = cJSON_CreateObject();
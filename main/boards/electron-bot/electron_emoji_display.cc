@@ -57,6 +57,9 @@ void ElectronEmojiDisplay::SetupChatLabel() {
 
 LV_FONT_DECLARE(OTTO_ICON_FONT);
 void ElectronEmojiDisplay::SetStatus(const char* status) {
+    if (ui_queue_.Defer(kUiCommandStatus, status)) {
+        return;
+    }
     auto lvgl_theme = static_cast<LvglTheme*>(current_theme_);
     auto text_font = lvgl_theme->text_font()->font();
     DisplayLockGuard lock(this);
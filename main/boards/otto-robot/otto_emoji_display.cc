@@ -53,6 +53,9 @@ void OttoEmojiDisplay::InitializeOttoEmojis() {
 
 LV_FONT_DECLARE(OTTO_ICON_FONT);
 void OttoEmojiDisplay::SetStatus(const char* status) {
+    if (ui_queue_.Defer(kUiCommandStatus, status)) {
+        return;
+    }
     auto lvgl_theme = static_cast<LvglTheme*>(current_theme_);
     auto text_font = lvgl_theme->text_font()->font();
     DisplayLockGuard lock(this);
@@ -95,6 +98,7 @@ void OttoEmojiDisplay::SetStatus(const char* status) {
 
 void OttoEmojiDisplay::SetPreviewImage(std::unique_ptr<LvglImage> image) {
     DisplayLockGuard lock(this);
+    ui_queue_.Flush();
     if (preview_image_ == nullptr) {
         ESP_LOGE(TAG, "Preview image is not initialized");
         return;
@@ -1,12 +1,17 @@
 #include "dht20.h"
 #include <esp_log.h>
+#include <esp_timer.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 
 #define TAG "DHT20"
 
 DHT20::DHT20(i2c_master_bus_handle_t i2c_bus)
-    : I2cDevice(i2c_bus, DHT20_ADDR), temperature_offset_(0.0f), humidity_offset_(0.0f) {
+    : I2cDevice(i2c_bus, DHT20_ADDR) {
+}
+
+DHT20::DHT20(I2cTransport* transport)
+    : I2cDevice(transport) {
 }
 
 DHT20::~DHT20() {
@@ -34,7 +39,7 @@ bool DHT20::Initialize() {
 
 bool DHT20::Reset() {
     uint8_t cmd = DHT20_CMD_SOFT_RESET;
-    esp_err_t err = i2c_master_transmit(i2c_device_, &cmd, 1, 100);
+    esp_err_t err = Transmit(&cmd, 1);
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "Failed to send reset command: %d", err);
         return false;
@@ -44,7 +49,7 @@ bool DHT20::Reset() {
 
 bool DHT20::ReadStatus() {
     uint8_t status;
-    esp_err_t err = i2c_master_receive(i2c_device_, &status, 1, 100);
+    esp_err_t err = Receive(&status, 1);
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "Failed to read status: %d", err);
         return false;
@@ -53,48 +58,70 @@ bool DHT20::ReadStatus() {
     return true;
 }
 
-bool DHT20::WaitForReady() {
-    for (int i = 0; i < 10; i++) {
-        uint8_t status;
-        esp_err_t err = i2c_master_receive(i2c_device_, &status, 1, 100);
-        if (err == ESP_OK && !(status & 0x80)) {
-            return true;
+uint8_t DHT20::Crc8(const uint8_t* data, size_t length) {
+    // CRC-8/NRSC-5 as specified by the datasheet: polynomial 0x31, initial value 0xFF
+    uint8_t crc = 0xFF;
+    for (size_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x80) ? (crc << 1) ^ 0x31 : (crc << 1);
         }
-        vTaskDelay(pdMS_TO_TICKS(10));
     }
-    ESP_LOGE(TAG, "Sensor not ready");
-    return false;
+    return crc;
 }
 
-bool DHT20::ReadData(float& temperature, float& humidity) {
+bool DHT20::StartMeasurement() {
     if (!initialized_) {
         ESP_LOGE(TAG, "Sensor not initialized");
         return false;
     }
 
-    // Send read command
     uint8_t cmd[] = {DHT20_CMD_READ, 0x33, 0x00};
-    esp_err_t err = i2c_master_transmit(i2c_device_, cmd, 3, -1);
+    esp_err_t err = Transmit(cmd, sizeof(cmd));
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "Failed to send read command: %d", err);
+        measuring_ = false;
         return false;
     }
 
-    // Wait for measurement (80ms)
-    vTaskDelay(pdMS_TO_TICKS(80));
+    measuring_ = true;
+    measurement_start_us_ = esp_timer_get_time();
+    return true;
+}
 
-    // Read data
+SensorStatus DHT20::PollResult(float* values) {
+    return PollResult(values[0], values[1]);
+}
+
+SensorStatus DHT20::PollResult(float& temperature, float& humidity) {
+    if (!measuring_) {
+        return kSensorStatusError;
+    }
+
+    // The status byte leads the frame, so one read both polls the busy bit and fetches the result
     uint8_t data[7] = {0};
-    err = i2c_master_receive(i2c_device_, data, 7, -1);
+    esp_err_t err = Receive(data, sizeof(data));
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "Failed to read data: %d", err);
-        return false;
+        measuring_ = false;
+        return kSensorStatusError;
     }
 
-    // Check status bit (bit 7 of first byte should be 0 when ready)
-    if (data[0] & 0x80) {
-        ESP_LOGE(TAG, "Measurement not ready");
-        return false;
+    int64_t elapsed_us = esp_timer_get_time() - measurement_start_us_;
+    if (data[0] & DHT20_STATUS_BUSY) {
+        if (elapsed_us > DHT20_MEASUREMENT_TIMEOUT_MS * 1000) {
+            ESP_LOGE(TAG, "Measurement timed out after %d ms", (int)(elapsed_us / 1000));
+            measuring_ = false;
+            return kSensorStatusError;
+        }
+        return kSensorStatusBusy;
+    }
+    measuring_ = false;
+
+    uint8_t crc = Crc8(data, 6);
+    if (crc != data[6]) {
+        ESP_LOGW(TAG, "CRC mismatch: expected 0x%02X, got 0x%02X", crc, data[6]);
+        return kSensorStatusError;
     }
 
     // Parse data (same as reference project)
@@ -105,20 +132,25 @@ bool DHT20::ReadData(float& temperature, float& humidity) {
     humidity = (raw_humidity * 100.0f) / 1048576.0f + humidity_offset_;
     temperature = (raw_temperature * 200.0f) / 1048576.0f - 50.0f + temperature_offset_;
 
-    ESP_LOGI(TAG, "Temperature: %.2f°C, Humidity: %.2f%%", temperature, humidity);
-    return true;
+    ESP_LOGD(TAG, "Temperature: %.2f°C, Humidity: %.2f%% (ready in %d ms)",
+        temperature, humidity, (int)(elapsed_us / 1000));
+    return kSensorStatusReady;
 }
 
-std::string DHT20::GetJsonData() {
-    float temperature, humidity;
-    if (ReadData(temperature, humidity)) {
-        char json[100];
-        snprintf(json, sizeof(json), 
-                 "{\"temperature\": %.2f, \"humidity\": %.2f}", 
-                 temperature, humidity);
-        return std::string(json);
+bool DHT20::ReadData(float& temperature, float& humidity) {
+    if (!StartMeasurement()) {
+        return false;
+    }
+
+    // Sleep through most of the conversion, then poll the busy bit for early completion
+    vTaskDelay(pdMS_TO_TICKS(DHT20_MEASUREMENT_TIME_MS - 20));
+    while (true) {
+        SensorStatus status = PollResult(temperature, humidity);
+        if (status != kSensorStatusBusy) {
+            return status == kSensorStatusReady;
+        }
+        vTaskDelay(pdMS_TO_TICKS(10));
     }
-    return "{\"error\": \"Failed to read DHT20\"}";
 }
 
 void DHT20::SetTemperatureOffset(float offset) {
@@ -2,35 +2,54 @@
 #define DHT20_H
 
 #include "boards/common/i2c_device.h"
+#include "sensors/sensor.h"
+#include <atomic>
 #include <cstdint>
 #include <string>
 
-class DHT20 : public I2cDevice {
+class DHT20 : public I2cDevice, public Sensor {
 public:
+    static constexpr uint8_t DHT20_ADDR = 0x38;
+    static constexpr uint8_t DHT20_CMD_READ = 0xAC;
+    static constexpr uint8_t DHT20_CMD_SOFT_RESET = 0xBA;
+    static constexpr uint8_t DHT20_STATUS_BUSY = 0x80;
+    // Typical conversion time from the datasheet, and the point where we give up
+    static constexpr int DHT20_MEASUREMENT_TIME_MS = 80;
+    static constexpr int DHT20_MEASUREMENT_TIMEOUT_MS = 250;
+
     DHT20(i2c_master_bus_handle_t i2c_bus);
+    // For a simulated sensor, see dht20_simulator.h
+    DHT20(I2cTransport* transport);
     ~DHT20();
 
     bool Initialize();
     bool ReadData(float& temperature, float& humidity);
+    // Split-phase measurement: trigger a conversion, then poll until it is ready
+    bool StartMeasurement() override;
+    SensorStatus PollResult(float* values) override;
+    SensorStatus PollResult(float& temperature, float& humidity);
+    const char* GetName() const override { return "DHT20"; }
+    int GetChannelCount() const override { return 2; }
+    const char* GetChannelName(int channel) const override { return channel == 0 ? "temperature" : "humidity"; }
+    int GetConversionTimeMs() const override { return DHT20_MEASUREMENT_TIME_MS; }
     std::string GetSensorInfo();
-    std::string GetJsonData();
     void SetTemperatureOffset(float offset);
     void SetHumidityOffset(float offset);
     float GetTemperatureOffset() const { return temperature_offset_; }
     float GetHumidityOffset() const { return humidity_offset_; }
+    // CRC of the result frame, polynomial 0x31 and initial value 0xFF
+    static uint8_t Crc8(const uint8_t* data, size_t length);
 
 private:
-    static constexpr uint8_t DHT20_ADDR = 0x38;
-    static constexpr uint8_t DHT20_CMD_READ = 0xAC;
-    static constexpr uint8_t DHT20_CMD_SOFT_RESET = 0xBA;
-
     bool initialized_ = false;
-    float temperature_offset_ = 0.0f;
-    float humidity_offset_ = 0.0f;
+    bool measuring_ = false;
+    int64_t measurement_start_us_ = 0;
+    // Written by calibration, read by the bus scheduler task
+    std::atomic<float> temperature_offset_ = 0.0f;
+    std::atomic<float> humidity_offset_ = 0.0f;
 
     bool Reset();
     bool ReadStatus();
-    bool WaitForReady();
 };
 
 #endif // DHT20_H
@@ -0,0 +1,146 @@
+#include "dht20_simulator.h"
+#include "dht20.h"
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <algorithm>
+#include <cstring>
+
+#define TAG "DHT20Simulator"
+
+// Calibrated and in normal mode, as read from a healthy sensor
+#define DHT20_SIMULATOR_STATUS_IDLE 0x18
+
+DHT20Simulator::DHT20Simulator()
+    : conversion_time_ms_(DHT20::DHT20_MEASUREMENT_TIME_MS) {
+}
+
+void DHT20Simulator::SetEnvironment(float temperature, float humidity) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    temperature_ = temperature;
+    humidity_ = humidity;
+}
+
+void DHT20Simulator::SetScript(EnvironmentScript script) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    script_ = script;
+}
+
+void DHT20Simulator::SetConversionTimeMs(int conversion_time_ms) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    conversion_time_ms_ = conversion_time_ms;
+}
+
+void DHT20Simulator::InjectFault(Dht20SimulatorFault fault, int count) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    fault_ = fault;
+    fault_count_ = fault == kDht20FaultNone ? 0 : count;
+    ESP_LOGI(TAG, "Injecting fault %d, count %d", fault, count);
+}
+
+Dht20SimulatorStats DHT20Simulator::GetStats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+bool DHT20Simulator::TakeFault(Dht20SimulatorFault fault) {
+    if (fault_ != fault || fault_count_ == 0) {
+        return false;
+    }
+    if (fault_count_ > 0 && --fault_count_ == 0) {
+        fault_ = kDht20FaultNone;
+    }
+    stats_.faults++;
+    return true;
+}
+
+Dht20SimulatorFault DHT20Simulator::TakeBusFault() {
+    stats_.transactions++;
+    if (TakeFault(kDht20FaultNack)) {
+        return kDht20FaultNack;
+    }
+    if (TakeFault(kDht20FaultTimeout)) {
+        return kDht20FaultTimeout;
+    }
+    return kDht20FaultNone;
+}
+
+esp_err_t DHT20Simulator::FailTransaction(Dht20SimulatorFault fault, int timeout_ms) {
+    if (fault == kDht20FaultTimeout) {
+        // The driver waits out the whole timeout while the bus is held
+        vTaskDelay(pdMS_TO_TICKS(timeout_ms));
+        return ESP_ERR_TIMEOUT;
+    }
+    return ESP_FAIL;
+}
+
+void DHT20Simulator::Convert() {
+    if (script_) {
+        script_(esp_timer_get_time(), temperature_, humidity_);
+    }
+
+    // Inverse of the conversion in DHT20::PollResult, 20 bits per value
+    uint32_t raw_humidity = (uint32_t)std::clamp(humidity_ / 100.0f * 1048576.0f, 0.0f, 1048575.0f);
+    uint32_t raw_temperature = (uint32_t)std::clamp((temperature_ + 50.0f) / 200.0f * 1048576.0f, 0.0f, 1048575.0f);
+    frame_[0] = DHT20_SIMULATOR_STATUS_IDLE;
+    frame_[1] = raw_humidity >> 12;
+    frame_[2] = raw_humidity >> 4;
+    frame_[3] = ((raw_humidity & 0x0F) << 4) | (raw_temperature >> 16);
+    frame_[4] = raw_temperature >> 8;
+    frame_[5] = raw_temperature;
+    frame_[6] = DHT20::Crc8(frame_, 6);
+
+    converting_ = true;
+    conversion_done_us_ = esp_timer_get_time() + conversion_time_ms_ * 1000;
+    stats_.conversions++;
+}
+
+esp_err_t DHT20Simulator::Transmit(const uint8_t* data, size_t length, int timeout_ms) {
+    Dht20SimulatorFault fault;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        fault = TakeBusFault();
+        if (fault == kDht20FaultNone && length > 0) {
+            if (data[0] == DHT20::DHT20_CMD_SOFT_RESET) {
+                converting_ = false;
+            } else if (data[0] == DHT20::DHT20_CMD_READ && length == 3 && data[1] == 0x33 && data[2] == 0x00) {
+                Convert();
+            }
+            // Other commands are acknowledged and ignored, like the real sensor
+        }
+    }
+    return fault == kDht20FaultNone ? ESP_OK : FailTransaction(fault, timeout_ms);
+}
+
+esp_err_t DHT20Simulator::Receive(uint8_t* buffer, size_t length, int timeout_ms) {
+    Dht20SimulatorFault fault;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        fault = TakeBusFault();
+        if (fault == kDht20FaultNone && length > 0) {
+            // Reads always start with the status byte; the data bytes hold the last result
+            memcpy(buffer, frame_, std::min(length, sizeof(frame_)));
+            buffer[0] = DHT20_SIMULATOR_STATUS_IDLE;
+            if (converting_ && (esp_timer_get_time() < conversion_done_us_ || TakeFault(kDht20FaultStuckBusy))) {
+                buffer[0] |= DHT20::DHT20_STATUS_BUSY;
+                stats_.busy_reads++;
+            } else {
+                converting_ = false;
+                if (length >= sizeof(frame_) && TakeFault(kDht20FaultBadCrc)) {
+                    buffer[6] ^= 0x5A;
+                }
+            }
+        }
+    }
+    return fault == kDht20FaultNone ? ESP_OK : FailTransaction(fault, timeout_ms);
+}
+
+esp_err_t DHT20Simulator::TransmitReceive(const uint8_t* data, size_t length, uint8_t* buffer, size_t buffer_length, int timeout_ms) {
+    esp_err_t err = Transmit(data, length, timeout_ms);
+    if (err != ESP_OK) {
+        return err;
+    }
+    return Receive(buffer, buffer_length, timeout_ms);
+}
@@ -0,0 +1,68 @@
+#ifndef DHT20_SIMULATOR_H
+#define DHT20_SIMULATOR_H
+
+#include "boards/common/i2c_device.h"
+#include <cstdint>
+#include <functional>
+#include <mutex>
+
+enum Dht20SimulatorFault {
+    kDht20FaultNone,
+    kDht20FaultNack,        // Transactions fail as if nothing answers at the address
+    kDht20FaultTimeout,     // Transactions block for their timeout, then fail (SCL held low)
+    kDht20FaultStuckBusy,   // The busy bit never clears
+    kDht20FaultBadCrc,      // Result frames carry a wrong CRC
+};
+
+struct Dht20SimulatorStats {
+    uint32_t transactions = 0;
+    uint32_t conversions = 0;
+    uint32_t busy_reads = 0;
+    uint32_t faults = 0;
+};
+
+/*
+ * Models a DHT20 behind the I2cTransport seam, so the driver, the bus scheduler and
+ * everything above them run without the sensor attached.
+ *
+ * Modelled: soft reset, the 0xAC trigger, the busy bit during the conversion time,
+ * the 7 byte result frame with CRC-8, and injected bus and sensor faults.
+ */
+class DHT20Simulator : public I2cTransport {
+public:
+    // Called at the start of every conversion with the esp_timer time
+    using EnvironmentScript = std::function<void(int64_t time_us, float& temperature, float& humidity)>;
+
+    DHT20Simulator();
+
+    void SetEnvironment(float temperature, float humidity);
+    void SetScript(EnvironmentScript script);
+    void SetConversionTimeMs(int conversion_time_ms);
+    // Applies the fault to the next `count` affected transactions, or until cleared if count < 0
+    void InjectFault(Dht20SimulatorFault fault, int count = -1);
+    Dht20SimulatorStats GetStats();
+
+    esp_err_t Transmit(const uint8_t* data, size_t length, int timeout_ms) override;
+    esp_err_t Receive(uint8_t* buffer, size_t length, int timeout_ms) override;
+    esp_err_t TransmitReceive(const uint8_t* data, size_t length, uint8_t* buffer, size_t buffer_length, int timeout_ms) override;
+
+private:
+    std::mutex mutex_;
+    EnvironmentScript script_;
+    float temperature_ = 22.5f;
+    float humidity_ = 45.0f;
+    int conversion_time_ms_;
+    bool converting_ = false;
+    int64_t conversion_done_us_ = 0;
+    uint8_t frame_[7] = {};
+    Dht20SimulatorFault fault_ = kDht20FaultNone;
+    int fault_count_ = 0;
+    Dht20SimulatorStats stats_;
+
+    bool TakeFault(Dht20SimulatorFault fault);
+    Dht20SimulatorFault TakeBusFault();
+    static esp_err_t FailTransaction(Dht20SimulatorFault fault, int timeout_ms);
+    void Convert();
+};
+
+#endif // DHT20_SIMULATOR_H
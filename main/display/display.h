@@ -46,6 +46,8 @@ public:
     virtual void ShowStandbyScreen() {}
     virtual void UpdateStandbyScreen() {}
     virtual void HideStandbyScreen() {}
+    // Pixels sent to the panel since boot, wraps around; 0 if the display does not count them
+    virtual uint32_t GetFlushedPixels() { return 0; }
 
     inline int width() const { return width_; }
     inline int height() const { return height_; }
@@ -61,14 +63,19 @@ protected:
     friend class DisplayLockGuard;
     virtual bool Lock(int timeout_ms = 0) = 0;
     virtual void Unlock() = 0;
+    // Called with the lock held, after waiting wait_us for it
+    virtual void RecordLockWait(uint32_t wait_us) {}
 };
 
 
 class DisplayLockGuard {
 public:
     DisplayLockGuard(Display *display) : display_(display) {
+        int64_t start_us = esp_timer_get_time();
         if (!display_->Lock(30000)) {
             ESP_LOGE("Display", "Failed to lock display");
+        } else {
+            display_->RecordLockWait(esp_timer_get_time() - start_us);
         }
     }
     ~DisplayLockGuard() {
@@ -12,6 +12,8 @@
 #include <esp_err.h>
 #include <esp_lvgl_port.h>
 #include <esp_psram.h>
+#include <esp_timer.h>
+#include <esp_heap_caps.h>
 #include <cstring>
 #include <src/misc/cache/lv_cache.h>
 #include <ctime>
@@ -167,6 +169,7 @@ SpiLcdDisplay::SpiLcdDisplay(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_h
         ESP_LOGE(TAG, "Failed to add display");
         return;
     }
+    OnDisplayCreated();
 
     if (offset_x != 0 || offset_y != 0) {
         lv_display_set_offset(display_, offset_x, offset_y);
@@ -228,6 +231,7 @@ RgbLcdDisplay::RgbLcdDisplay(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_h
         ESP_LOGE(TAG, "Failed to add RGB display");
         return;
     }
+    OnDisplayCreated();
     
     if (offset_x != 0 || offset_y != 0) {
         lv_display_set_offset(display_, offset_x, offset_y);
@@ -279,6 +283,7 @@ MipiLcdDisplay::MipiLcdDisplay(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel
         ESP_LOGE(TAG, "Failed to add display");
         return;
     }
+    OnDisplayCreated();
 
     if (offset_x != 0 || offset_y != 0) {
         lv_display_set_offset(display_, offset_x, offset_y);
@@ -293,6 +298,7 @@ LcdDisplay::~LcdDisplay() {
         gif_controller_->Stop();
         gif_controller_.reset();
     }
+    gif_cache_.Clear();
     
     if (preview_timer_ != nullptr) {
         esp_timer_stop(preview_timer_);
@@ -506,7 +512,72 @@ void LcdDisplay::SetupUI() {
 #else
 #define  MAX_MESSAGES 20
 #endif
+LcdDisplay::ChatBubble* LcdDisplay::AcquireChatBubble() {
+    for (;;) {
+        uint32_t child_count = lv_obj_get_child_cnt(content_);
+        lv_obj_t* first_child = lv_obj_get_child(content_, 0);
+        if (first_child == nullptr) {
+            break;
+        }
+        auto it = std::find_if(chat_bubbles_.begin(), chat_bubbles_.end(), [first_child](const ChatBubble& bubble) {
+            return bubble.container == first_child;
+        });
+        // The first child is the oldest message, or a bubble hidden by ClearChatMessages()
+        if (it != chat_bubbles_.end() && (child_count >= MAX_MESSAGES || lv_obj_has_flag(first_child, LV_OBJ_FLAG_HIDDEN))) {
+            lv_obj_move_to_index(first_child, -1);
+            lv_obj_remove_flag(first_child, LV_OBJ_FLAG_HIDDEN);
+            return &*it;
+        }
+        if (child_count < MAX_MESSAGES) {
+            break;
+        }
+        // Image previews are not pooled, drop the oldest one to make room
+        lv_obj_del(first_child);
+    }
+
+    if (chat_bubbles_.empty()) {
+        // Bubbles are referenced by pointer, the vector must never reallocate
+        chat_bubbles_.reserve(MAX_MESSAGES);
+    }
+    auto lvgl_theme = static_cast<LvglTheme*>(current_theme_);
+    ChatBubble bubble;
+
+    bubble.container = lv_obj_create(content_);
+    lv_obj_set_width(bubble.container, LV_HOR_RES);
+    lv_obj_set_height(bubble.container, LV_SIZE_CONTENT);
+    lv_obj_set_style_bg_opa(bubble.container, LV_OPA_TRANSP, 0);
+    lv_obj_set_style_border_width(bubble.container, 0, 0);
+    lv_obj_set_style_pad_all(bubble.container, 0, 0);
+
+    bubble.bubble = lv_obj_create(bubble.container);
+    lv_obj_set_style_radius(bubble.bubble, 8, 0);
+    lv_obj_set_scrollbar_mode(bubble.bubble, LV_SCROLLBAR_MODE_OFF);
+    lv_obj_set_style_border_width(bubble.bubble, 0, 0);
+    lv_obj_set_style_pad_all(bubble.bubble, lvgl_theme->spacing(4), 0);
+    lv_obj_set_style_bg_opa(bubble.bubble, LV_OPA_70, 0);
+    lv_obj_set_size(bubble.bubble, LV_SIZE_CONTENT, LV_SIZE_CONTENT);
+
+    bubble.label = lv_label_create(bubble.bubble);
+    lv_label_set_long_mode(bubble.label, LV_LABEL_LONG_WRAP);
+
+    chat_bubbles_.push_back(bubble);
+    return &chat_bubbles_.back();
+}
+
+bool LcdDisplay::HasVisibleChatMessages() {
+    uint32_t child_count = lv_obj_get_child_cnt(content_);
+    for (uint32_t i = 0; i < child_count; i++) {
+        if (!lv_obj_has_flag(lv_obj_get_child(content_, i), LV_OBJ_FLAG_HIDDEN)) {
+            return true;
+        }
+    }
+    return false;
+}
+
 void LcdDisplay::SetChatMessage(const char* role, const char* content) {
+    if (ui_queue_.Defer(kUiCommandChatMessage, content, role)) {
+        return;
+    }
     if (!setup_ui_called_) {
         ESP_LOGW(TAG, "SetChatMessage('%s', '%s') called before SetupUI() - message will be lost!", role, content);
     }
@@ -517,44 +588,29 @@ void LcdDisplay::SetChatMessage(const char* role, const char* content) {
         }
         return;
     }
-    
-    // Check if message count exceeds limit
-    uint32_t child_count = lv_obj_get_child_cnt(content_);
-    if (child_count >= MAX_MESSAGES) {
-        // Delete the oldest message (first child object)
-        lv_obj_t* first_child = lv_obj_get_child(content_, 0);
-        if (first_child != nullptr) {
-            lv_obj_del(first_child);
-            // Refresh child count after deletion
-            child_count = lv_obj_get_child_cnt(content_);
-        }
-        // Scroll to the last message immediately (get last_child after deletion)
-        if (child_count > 0) {
-            lv_obj_t* last_child = lv_obj_get_child(content_, child_count - 1);
-            if (last_child != nullptr && lv_obj_is_valid(last_child)) {
-                lv_obj_scroll_to_view_recursive(last_child, LV_ANIM_OFF);
-            }
-        }
-    }
-    
-    // Collapse system messages (if it's a system message, check if the last message is also a system message)
-    if (strcmp(role, "system") == 0) {
-        // Refresh child count to get accurate count after potential deletion above
-        child_count = lv_obj_get_child_cnt(content_);
-        if (child_count > 0) {
-            // Get the last message container
-            lv_obj_t* last_container = lv_obj_get_child(content_, child_count - 1);
-            if (last_container != nullptr && lv_obj_is_valid(last_container) && lv_obj_get_child_cnt(last_container) > 0) {
-                // Get the bubble inside the container
-                lv_obj_t* last_bubble = lv_obj_get_child(last_container, 0);
-                if (last_bubble != nullptr && lv_obj_is_valid(last_bubble)) {
-                    // Check if bubble type is system message
-                    void* bubble_type_ptr = lv_obj_get_user_data(last_bubble);
-                    if (bubble_type_ptr != nullptr && strcmp((const char*)bubble_type_ptr, "system") == 0) {
-                        // If the last message is also a system message, delete it
-                        lv_obj_del(last_container);
-                    }
-                }
+
+    int64_t start_time = esp_timer_get_time();
+    size_t free_heap = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+
+    // The bubble type is kept in the user data, it must point to a literal
+    const char* bubble_type = "assistant";
+    if (strcmp(role, "user") == 0) {
+        bubble_type = "user";
+    } else if (strcmp(role, "system") == 0) {
+        bubble_type = "system";
+    }
+
+    // Collapse system messages: a system message replaces the one right before it
+    ChatBubble* bubble = nullptr;
+    if (strcmp(bubble_type, "system") == 0) {
+        if (last_chat_bubble_ != nullptr && lv_obj_get_child(content_, -1) == last_chat_bubble_->container &&
+            !lv_obj_has_flag(last_chat_bubble_->container, LV_OBJ_FLAG_HIDDEN) &&
+            strcmp((const char*)lv_obj_get_user_data(last_chat_bubble_->bubble), "system") == 0) {
+            bubble = last_chat_bubble_;
+            if (strlen(content) == 0) {
+                lv_obj_add_flag(bubble->container, LV_OBJ_FLAG_HIDDEN);
+                last_chat_bubble_ = nullptr;
+                return;
             }
         }
     } else {
@@ -563,147 +619,59 @@ void LcdDisplay::SetChatMessage(const char* role, const char* content) {
     }
 
     // Avoid empty message boxes
-    if(strlen(content) == 0) {
+    if (strlen(content) == 0) {
         return;
     }
 
-    auto lvgl_theme = static_cast<LvglTheme*>(current_theme_);
+    if (bubble == nullptr) {
+        bubble = AcquireChatBubble();
+    }
 
-    // Create a message bubble
-    lv_obj_t* msg_bubble = lv_obj_create(content_);
-    lv_obj_set_style_radius(msg_bubble, 8, 0);
-    lv_obj_set_scrollbar_mode(msg_bubble, LV_SCROLLBAR_MODE_OFF);
-    lv_obj_set_style_border_width(msg_bubble, 0, 0);
-    lv_obj_set_style_pad_all(msg_bubble, lvgl_theme->spacing(4), 0);
+    auto lvgl_theme = static_cast<LvglTheme*>(current_theme_);
+    lv_obj_set_user_data(bubble->bubble, (void*)bubble_type);
+    if (strcmp(bubble_type, "user") == 0) {
+        lv_obj_set_style_bg_color(bubble->bubble, lvgl_theme->user_bubble_color(), 0);
+        lv_obj_set_style_text_color(bubble->label, lvgl_theme->text_color(), 0);
+    } else if (strcmp(bubble_type, "system") == 0) {
+        lv_obj_set_style_bg_color(bubble->bubble, lvgl_theme->system_bubble_color(), 0);
+        lv_obj_set_style_text_color(bubble->label, lvgl_theme->system_text_color(), 0);
+    } else {
+        lv_obj_set_style_bg_color(bubble->bubble, lvgl_theme->assistant_bubble_color(), 0);
+        lv_obj_set_style_text_color(bubble->label, lvgl_theme->text_color(), 0);
+    }
+    lv_label_set_text(bubble->label, content);
 
-    // Create the message text
-    lv_obj_t* msg_text = lv_label_create(msg_bubble);
-    lv_label_set_text(msg_text, content);
-    
-    // Calculate bubble width constraints
+    // Natural text width, measured directly instead of running a layout pass
     lv_coord_t max_width = LV_HOR_RES * 85 / 100 - 16;  // 85% of screen width
-    lv_coord_t min_width = 20;  
-    
-    // Let LVGL calculate the natural text width first
-    lv_obj_set_width(msg_text, LV_SIZE_CONTENT);
-    lv_obj_update_layout(msg_text);
-    lv_coord_t text_width = lv_obj_get_width(msg_text);
-    
-    // Ensure text width is not less than minimum width
-    if (text_width < min_width) {
-        text_width = min_width;
+    lv_coord_t min_width = 20;
+    lv_point_t text_size;
+    lv_text_get_size(&text_size, content, lv_obj_get_style_text_font(bubble->label, LV_PART_MAIN),
+        lv_obj_get_style_text_letter_space(bubble->label, LV_PART_MAIN), 0, LV_COORD_MAX, LV_TEXT_FLAG_NONE);
+    lv_obj_set_width(bubble->label, std::clamp<lv_coord_t>(text_size.x, min_width, max_width));
+
+    // User messages on the right, system messages centered, assistant messages on the left
+    if (strcmp(bubble_type, "user") == 0) {
+        lv_obj_align(bubble->bubble, LV_ALIGN_RIGHT_MID, -25, 0);
+    } else if (strcmp(bubble_type, "system") == 0) {
+        lv_obj_align(bubble->bubble, LV_ALIGN_CENTER, 0, 0);
+    } else {
+        lv_obj_align(bubble->bubble, LV_ALIGN_LEFT_MID, 0, 0);
     }
 
-    // Constrain to max width
-    lv_coord_t bubble_width = (text_width < max_width) ? text_width : max_width;
-    
-    // Set message text width
-    lv_obj_set_width(msg_text, bubble_width);
-    lv_label_set_long_mode(msg_text, LV_LABEL_LONG_WRAP);
-
-    // Set bubble width
-    lv_obj_set_width(msg_bubble, bubble_width);
-    lv_obj_set_height(msg_bubble, LV_SIZE_CONTENT);
-
-    // Set alignment and style based on message role
-    if (strcmp(role, "user") == 0) {
-        // User messages are right-aligned with green background
-        lv_obj_set_style_bg_color(msg_bubble, lvgl_theme->user_bubble_color(), 0);
-        lv_obj_set_style_bg_opa(msg_bubble, LV_OPA_70, 0);
-        // Set text color for contrast
-        lv_obj_set_style_text_color(msg_text, lvgl_theme->text_color(), 0);
-        
-        // Set custom attribute to mark bubble type
-        lv_obj_set_user_data(msg_bubble, (void*)"user");
-        
-        // Set appropriate width for content
-        lv_obj_set_width(msg_bubble, LV_SIZE_CONTENT);
-        lv_obj_set_height(msg_bubble, LV_SIZE_CONTENT);
-        
-        // Don't grow
-        lv_obj_set_style_flex_grow(msg_bubble, 0, 0);
-    } else if (strcmp(role, "assistant") == 0) {
-        // Assistant messages are left-aligned with white background
-        lv_obj_set_style_bg_color(msg_bubble, lvgl_theme->assistant_bubble_color(), 0);
-        lv_obj_set_style_bg_opa(msg_bubble, LV_OPA_70, 0);
-        // Set text color for contrast
-        lv_obj_set_style_text_color(msg_text, lvgl_theme->text_color(), 0);
-        
-        // Set custom attribute to mark bubble type
-        lv_obj_set_user_data(msg_bubble, (void*)"assistant");
-        
-        // Set appropriate width for content
-        lv_obj_set_width(msg_bubble, LV_SIZE_CONTENT);
-        lv_obj_set_height(msg_bubble, LV_SIZE_CONTENT);
-        
-        // Don't grow
-        lv_obj_set_style_flex_grow(msg_bubble, 0, 0);
-    } else if (strcmp(role, "system") == 0) {
-        // System messages are center-aligned with light gray background
-        lv_obj_set_style_bg_color(msg_bubble, lvgl_theme->system_bubble_color(), 0);
-        lv_obj_set_style_bg_opa(msg_bubble, LV_OPA_70, 0);
-        // Set text color for contrast
-        lv_obj_set_style_text_color(msg_text, lvgl_theme->system_text_color(), 0);
-        
-        // Set custom attribute to mark bubble type
-        lv_obj_set_user_data(msg_bubble, (void*)"system");
-        
-        // Set appropriate width for content
-        lv_obj_set_width(msg_bubble, LV_SIZE_CONTENT);
-        lv_obj_set_height(msg_bubble, LV_SIZE_CONTENT);
-        
-        // Don't grow
-        lv_obj_set_style_flex_grow(msg_bubble, 0, 0);
-    }
-    
-    // Create a full-width container for user messages to ensure right alignment
-    if (strcmp(role, "user") == 0) {
-        // Create a full-width container
-        lv_obj_t* container = lv_obj_create(content_);
-        lv_obj_set_width(container, LV_HOR_RES);
-        lv_obj_set_height(container, LV_SIZE_CONTENT);
-        
-        // Make container transparent and borderless
-        lv_obj_set_style_bg_opa(container, LV_OPA_TRANSP, 0);
-        lv_obj_set_style_border_width(container, 0, 0);
-        lv_obj_set_style_pad_all(container, 0, 0);
-        
-        // Move the message bubble into this container
-        lv_obj_set_parent(msg_bubble, container);
-        
-        // Right align the bubble in the container
-        lv_obj_align(msg_bubble, LV_ALIGN_RIGHT_MID, -25, 0);
-        
-        // Auto-scroll to this container
-        lv_obj_scroll_to_view_recursive(container, LV_ANIM_ON);
-    } else if (strcmp(role, "system") == 0) {
-        // Create full-width container for system messages to ensure center alignment
-        lv_obj_t* container = lv_obj_create(content_);
-        lv_obj_set_width(container, LV_HOR_RES);
-        lv_obj_set_height(container, LV_SIZE_CONTENT);
-        
-        lv_obj_set_style_bg_opa(container, LV_OPA_TRANSP, 0);
-        lv_obj_set_style_border_width(container, 0, 0);
-        lv_obj_set_style_pad_all(container, 0, 0);
-        
-        lv_obj_set_parent(msg_bubble, container);
-        lv_obj_align(msg_bubble, LV_ALIGN_CENTER, 0, 0);
-        lv_obj_scroll_to_view_recursive(container, LV_ANIM_ON);
-    } else {
-        // For assistant messages
-        // Left align assistant messages
-        lv_obj_align(msg_bubble, LV_ALIGN_LEFT_MID, 0, 0);
+    // Only the message list scrolls, its parents never need to
+    lv_obj_scroll_to_view(bubble->container, LV_ANIM_ON);
 
-        // Auto-scroll to the message bubble
-        lv_obj_scroll_to_view_recursive(msg_bubble, LV_ANIM_ON);
-    }
-    
     // Store reference to the latest message label
-    chat_message_label_ = msg_text;
+    chat_message_label_ = bubble->label;
+    last_chat_bubble_ = bubble;
+
+    perf_monitor_.RecordChatMessage(esp_timer_get_time() - start_time,
+        (int32_t)free_heap - (int32_t)heap_caps_get_free_size(MALLOC_CAP_8BIT));
 }
 
 void LcdDisplay::SetPreviewImage(std::unique_ptr<LvglImage> image) {
     DisplayLockGuard lock(this);
+    ui_queue_.Flush();
     if (content_ == nullptr) {
         return;
     }
@@ -786,17 +754,36 @@ void LcdDisplay::SetPreviewImage(std::unique_ptr<LvglImage> image) {
     lv_obj_scroll_to_view_recursive(img_bubble, LV_ANIM_ON);
 }
 
+void LcdDisplay::GetPreviewImageBox(int& width, int& height) {
+    // Same limits SetPreviewImage() zooms to
+    width = width_ * 70 / 100;
+    height = height_ * 50 / 100;
+}
+
 void LcdDisplay::ClearChatMessages() {
+    if (ui_queue_.Defer(kUiCommandClearChat)) {
+        return;
+    }
     DisplayLockGuard lock(this);
     if (content_ == nullptr) {
         return;
     }
     
-    // Use lv_obj_clean to delete all children of content_ (chat message bubbles)
-    lv_obj_clean(content_);
+    // Pooled bubbles are only hidden, image previews are deleted
+    for (int i = (int)lv_obj_get_child_cnt(content_) - 1; i >= 0; i--) {
+        lv_obj_t* child = lv_obj_get_child(content_, i);
+        bool pooled = std::any_of(chat_bubbles_.begin(), chat_bubbles_.end(), [child](const ChatBubble& bubble) {
+            return bubble.container == child;
+        });
+        if (pooled) {
+            lv_obj_add_flag(child, LV_OBJ_FLAG_HIDDEN);
+        } else {
+            lv_obj_del(child);
+        }
+    }
     
-    // Reset chat_message_label_ as it has been deleted
     chat_message_label_ = nullptr;
+    last_chat_bubble_ = nullptr;
     
     // Show the centered AI logo (emoji_label_) again
     if (emoji_label_ != nullptr) {
@@ -978,6 +965,7 @@ void LcdDisplay::SetupUI() {
 
 void LcdDisplay::SetPreviewImage(std::unique_ptr<LvglImage> image) {
     DisplayLockGuard lock(this);
+    ui_queue_.Flush();
     if (preview_image_ == nullptr) {
         ESP_LOGE(TAG, "Preview image is not initialized");
         return;
@@ -1012,7 +1000,16 @@ void LcdDisplay::SetPreviewImage(std::unique_ptr<LvglImage> image) {
     ESP_ERROR_CHECK(esp_timer_start_once(preview_timer_, PREVIEW_IMAGE_DURATION_MS * 1000));
 }
 
+void LcdDisplay::GetPreviewImageBox(int& width, int& height) {
+    // SetPreviewImage() zooms the image to half the screen width
+    width = width_ / 2;
+    height = height_;
+}
+
 void LcdDisplay::SetChatMessage(const char* role, const char* content) {
+    if (ui_queue_.Defer(kUiCommandChatMessage, content, role)) {
+        return;
+    }
     if (!setup_ui_called_) {
         ESP_LOGW(TAG, "SetChatMessage('%s', '%s') called before SetupUI() - message will be lost!", role, content);
     }
@@ -1027,6 +1024,9 @@ void LcdDisplay::SetChatMessage(const char* role, const char* content) {
 }
 
 void LcdDisplay::ClearChatMessages() {
+    if (ui_queue_.Defer(kUiCommandClearChat)) {
+        return;
+    }
     DisplayLockGuard lock(this);
     // In non-wechat mode, just clear the chat message label
     if (chat_message_label_ != nullptr) {
@@ -1075,12 +1075,17 @@ void LcdDisplay::SetupStandbyScreen() {
     lv_obj_align(weekday_label_, LV_ALIGN_TOP_MID, 0, 34);
 
     // Time label (center, scaled 4x)
+#if CONFIG_STANDBY_CLOCK_DIGIT_CELLS
+    time_label_ = time_field_.Create(standby_screen_, text_font, lvgl_theme->text_color(), "12:00:00");
+#else
     time_label_ = lv_label_create(standby_screen_);
     lv_obj_set_style_text_font(time_label_, text_font, 0);
     lv_obj_set_style_text_color(time_label_, lvgl_theme->text_color(), 0);
     lv_obj_set_style_text_align(time_label_, LV_TEXT_ALIGN_CENTER, 0);
-    lv_obj_set_style_transform_scale(time_label_, 400, 0);
     lv_label_set_text(time_label_, "12:00:00");
+    time_field_.Attach(time_label_);
+#endif
+    lv_obj_set_style_transform_scale(time_label_, 400, 0);
     lv_obj_align(time_label_, LV_ALIGN_CENTER, -20, 0);
 
     // Temperature (bottom left) - 2.5x scale
@@ -1112,9 +1117,18 @@ void LcdDisplay::SetupStandbyScreen() {
     lv_obj_set_style_text_color(humidity_label_, lvgl_theme->text_color(), 0);
     lv_obj_set_style_transform_scale(humidity_label_, 250, 0);
     lv_obj_align_to(humidity_label_, humidity_icon_, LV_ALIGN_OUT_LEFT_MID, -4, 0);
+
+    date_field_.Attach(date_label_);
+    weekday_field_.Attach(weekday_label_);
+    temperature_field_.Attach(temperature_label_);
+    humidity_field_.Attach(humidity_label_);
+    standby_day_ = -1;
 }
 
 void LcdDisplay::ShowStandbyScreen() {
+    if (ui_queue_.Defer(kUiCommandShowStandby)) {
+        return;
+    }
     DisplayLockGuard lock(this);
 
     if (standby_screen_ == nullptr) {
@@ -1162,6 +1176,9 @@ void LcdDisplay::ShowStandbyScreen() {
 }
 
 void LcdDisplay::HideStandbyScreen() {
+    if (ui_queue_.Defer(kUiCommandHideStandby)) {
+        return;
+    }
     DisplayLockGuard lock(this);
 
     if (standby_screen_ != nullptr) {
@@ -1205,6 +1222,9 @@ void LcdDisplay::HideStandbyScreen() {
 }
 
 void LcdDisplay::UpdateStandbyScreen() {
+    if (ui_queue_.Defer(kUiCommandUpdateStandby)) {
+        return;
+    }
     DisplayLockGuard lock(this);
 
     if (standby_screen_ == nullptr || lv_obj_has_flag(standby_screen_, LV_OBJ_FLAG_HIDDEN)) {
@@ -1217,50 +1237,47 @@ void LcdDisplay::UpdateStandbyScreen() {
     time(&now);
     localtime_r(&now, &timeinfo);
 
-    // Update date
-    char date_buf[16];
-    strftime(date_buf, sizeof(date_buf), "%Y-%m-%d", &timeinfo);
-    lv_label_set_text(date_label_, date_buf);
+    // Date and weekday only change at midnight, or when SNTP sets the clock. Keyed on the
+    // year and day of the year: the day of the month alone misses a sync on the 1st.
+    int day = timeinfo.tm_year * 1000 + timeinfo.tm_yday;
+    if (day != standby_day_) {
+        standby_day_ = day;
+        char date_buf[16];
+        strftime(date_buf, sizeof(date_buf), "%Y-%m-%d", &timeinfo);
+        date_field_.SetText(date_buf);
 
-    // Update weekday (Chinese short format)
-    const char* weekdays_cn[] = {"周日", "周一", "周二", "周三", "周四", "周五", "周六"};
-    lv_label_set_text(weekday_label_, weekdays_cn[timeinfo.tm_wday]);
+        // Update weekday (Chinese short format)
+        const char* weekdays_cn[] = {"周日", "周一", "周二", "周三", "周四", "周五", "周六"};
+        weekday_field_.SetText(weekdays_cn[timeinfo.tm_wday]);
+    }
 
-    // Update time (HH:MM:SS format)
+    // Update time (HH:MM:SS format), only the cells that changed are redrawn
     char time_buf[16];
     strftime(time_buf, sizeof(time_buf), "%H:%M:%S", &timeinfo);
-    lv_label_set_text(time_label_, time_buf);
+    time_field_.SetText(time_buf);
 
     // Update temperature and humidity
     try {
+        // Cached text, only re-formatted when the sampler published a new reading
         auto& sensor_manager = SensorManager::GetInstance();
-        float temperature, humidity;
-        if (sensor_manager.ReadTemperatureHumidity(temperature, humidity)) {
-            char temp_buf[16];
-            snprintf(temp_buf, sizeof(temp_buf), "%.1f°C", temperature);
-            lv_label_set_text(temperature_label_, temp_buf);
-            
-            char hum_buf[16];
-            snprintf(hum_buf, sizeof(hum_buf), "%.1f%%", humidity);
-            lv_label_set_text(humidity_label_, hum_buf);
+        SensorReadingText text;
+        if (sensor_manager.GetReadingText(text)) {
+            temperature_field_.SetText(text.temperature);
+            humidity_field_.SetText(text.humidity);
         }
     } catch (...) {
-        lv_label_set_text(temperature_label_, "--.-°C");
-        lv_label_set_text(humidity_label_, "--.-%");
+        temperature_field_.SetText("--.-°C");
+        humidity_field_.SetText("--.-%");
     }
 }
 
 void LcdDisplay::SetEmotion(const char* emotion) {
+    if (ui_queue_.Defer(kUiCommandEmotion, emotion)) {
+        return;
+    }
     if (!setup_ui_called_) {
         ESP_LOGW(TAG, "SetEmotion('%s') called before SetupUI() - emotion will not be displayed!", emotion);
     }
-    // Stop any running GIF animation
-    if (gif_controller_) {
-        DisplayLockGuard lock(this);
-        gif_controller_->Stop();
-        gif_controller_.reset();
-    }
-    
     if (emoji_image_ == nullptr) {
         if (setup_ui_called_) {
             ESP_LOGW(TAG, "SetEmotion('%s') failed: emoji_image_ is nullptr (SetupUI() was called but emoji image not created)", emotion);
@@ -1270,10 +1287,18 @@ void LcdDisplay::SetEmotion(const char* emotion) {
 
     auto emoji_collection = static_cast<LvglTheme*>(current_theme_)->emoji_collection();
     auto image = emoji_collection != nullptr ? emoji_collection->GetEmojiImage(emotion) : nullptr;
+
+    DisplayLockGuard lock(this);
+    // The same GIF keeps playing, any other one goes back to the cache
+    bool same_gif = image != nullptr && image->IsGif() && gif_controller_ &&
+        gif_controller_->source() == image->image_dsc()->data;
+    if (gif_controller_ && !same_gif) {
+        gif_cache_.Release(std::move(gif_controller_));
+    }
+
     if (image == nullptr) {
         const char* utf8 = font_awesome_get_utf8(emotion);
         if (utf8 != nullptr && emoji_label_ != nullptr) {
-            DisplayLockGuard lock(this);
             lv_label_set_text(emoji_label_, utf8);
             lv_obj_add_flag(emoji_image_, LV_OBJ_FLAG_HIDDEN);
             lv_obj_remove_flag(emoji_label_, LV_OBJ_FLAG_HIDDEN);
@@ -1281,12 +1306,16 @@ void LcdDisplay::SetEmotion(const char* emotion) {
         return;
     }
 
-    DisplayLockGuard lock(this);
-    if (image->IsGif()) {
-        // Create new GIF controller
-        gif_controller_ = std::make_unique<LvglGif>(image->image_dsc());
+    if (same_gif) {
+        lv_obj_add_flag(emoji_label_, LV_OBJ_FLAG_HIDDEN);
+        lv_obj_remove_flag(emoji_image_, LV_OBJ_FLAG_HIDDEN);
+    } else if (image->IsGif()) {
+        // Reuse the decoder if this GIF was shown recently
+        gif_controller_ = gif_cache_.Acquire(image->image_dsc());
         
         if (gif_controller_->IsLoaded()) {
+            gif_controller_->SetTarget(emoji_image_);
+
             // Set up frame update callback
             gif_controller_->SetFrameCallback([this]() {
                 lv_image_set_src(emoji_image_, gif_controller_->image_dsc());
@@ -1311,12 +1340,11 @@ void LcdDisplay::SetEmotion(const char* emotion) {
 
 #if CONFIG_USE_WECHAT_MESSAGE_STYLE
     // In WeChat message style, if emotion is neutral, don't display it
-    uint32_t child_count = lv_obj_get_child_cnt(content_);
-    if (strcmp(emotion, "neutral") == 0 && child_count > 0) {
+    // Bubbles hidden by ClearChatMessages() stay in the pool and don't count
+    if (strcmp(emotion, "neutral") == 0 && HasVisibleChatMessages()) {
         // Stop GIF animation if running
         if (gif_controller_) {
-            gif_controller_->Stop();
-            gif_controller_.reset();
+            gif_cache_.Release(std::move(gif_controller_));
         }
         
         lv_obj_add_flag(emoji_image_, LV_OBJ_FLAG_HIDDEN);
@@ -1325,8 +1353,15 @@ void LcdDisplay::SetEmotion(const char* emotion) {
 #endif
 }
 
+void LcdDisplay::AddRenderStats(cJSON* json, bool reset) {
+    cJSON_AddItemToObject(json, "gif", gif_cache_.ToJson(reset));
+}
+
 void LcdDisplay::SetTheme(Theme* theme) {
     DisplayLockGuard lock(this);
+    ui_queue_.Flush();
+    // The new theme may bring another emoji collection, cached decoders read the old data
+    gif_cache_.Clear();
     
     auto lvgl_theme = static_cast<LvglTheme*>(theme);
     
@@ -1469,6 +1504,7 @@ void LcdDisplay::SetTheme(Theme* theme) {
 
 void LcdDisplay::SetHideSubtitle(bool hide) {
     DisplayLockGuard lock(this);
+    ui_queue_.Flush();
     hide_subtitle_ = hide;
     
     // Immediately update UI visibility based on the setting
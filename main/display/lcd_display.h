@@ -3,6 +3,8 @@
 
 #include "lvgl_display.h"
 #include "gif/lvgl_gif.h"
+#include "gif/lvgl_gif_cache.h"
+#include "lvgl_text_field.h"
 
 #include <esp_lcd_panel_io.h>
 #include <esp_lcd_panel_ops.h>
@@ -10,6 +12,7 @@
 
 #include <atomic>
 #include <memory>
+#include <vector>
 
 #define PREVIEW_IMAGE_DURATION_MS 5000
 
@@ -30,6 +33,7 @@ protected:
     lv_obj_t* emoji_label_ = nullptr;
     lv_obj_t* emoji_image_ = nullptr;
     std::unique_ptr<LvglGif> gif_controller_ = nullptr;
+    LvglGifCache gif_cache_{CONFIG_EMOJI_GIF_CACHE_ENTRIES, CONFIG_EMOJI_GIF_FRAME_CACHE_KB * 1024};
     lv_obj_t* emoji_box_ = nullptr;
     lv_obj_t* chat_message_label_ = nullptr;
     esp_timer_handle_t preview_timer_ = nullptr;
@@ -47,10 +51,35 @@ protected:
     lv_obj_t* temp_icon_ = nullptr;
     lv_obj_t* humidity_icon_ = nullptr;
 
+    // Fields remember their text, one that did not change costs no redraw
+    LvglTextField date_field_;
+    LvglTextField weekday_field_;
+#if CONFIG_STANDBY_CLOCK_DIGIT_CELLS
+    LvglDigitField time_field_;
+#else
+    LvglTextField time_field_;
+#endif
+    LvglTextField temperature_field_;
+    LvglTextField humidity_field_;
+    int standby_day_ = -1;              // tm_year * 1000 + tm_yday the date and weekday were formatted for
+
+    // Chat bubbles are created up to MAX_MESSAGES and then recycled, oldest first
+    struct ChatBubble {
+        lv_obj_t* container = nullptr;  // Transparent full-width row that aligns the bubble
+        lv_obj_t* bubble = nullptr;
+        lv_obj_t* label = nullptr;
+    };
+    std::vector<ChatBubble> chat_bubbles_;
+    ChatBubble* last_chat_bubble_ = nullptr;
+
+    ChatBubble* AcquireChatBubble();
+    bool HasVisibleChatMessages();
+
     void InitializeLcdThemes();
     virtual bool Lock(int timeout_ms = 0) override;
     virtual void Unlock() override;
     void SetupStandbyScreen();
+    virtual void AddRenderStats(cJSON* json, bool reset) override;
 
 protected:
     // Add protected constructor
@@ -62,6 +91,7 @@ public:
     virtual void SetChatMessage(const char* role, const char* content) override;
     virtual void ClearChatMessages() override;
     virtual void SetPreviewImage(std::unique_ptr<LvglImage> image) override;
+    virtual void GetPreviewImageBox(int& width, int& height) override;
     virtual void SetupUI() override;
     // Add theme switching function
     virtual void SetTheme(Theme* theme) override;
@@ -36,6 +36,8 @@ static void f_gif_close(gd_GIF * gif);
 
 #if LV_USE_DRAW_SW_ASM == LV_DRAW_SW_ASM_HELIUM
     #include "gifdec_mve.h"
+#else
+    #include "gifdec_lut.h"
 #endif
 
 static uint16_t
@@ -150,7 +152,8 @@ static gd_GIF * gif_open(gd_GIF * gif_base)
     #endif
 
 #ifdef GIFDEC_FILL_BG
-    GIFDEC_FILL_BG(gif->canvas, gif->width * gif->height, 1, gif->width * gif->height, bgcolor, 0x00);
+    /* Fill row by row, w and h of the kernels are 16 bit and the pixel count of the canvas may not fit */
+    GIFDEC_FILL_BG(gif->canvas, gif->width, gif->height, gif->width, bgcolor, 0x00);
 #else
     for(int i = 0; i < gif->width * gif->height; i++) {
         gif->canvas[i * 4 + 0] = *(bgcolor + 2);
@@ -299,6 +302,7 @@ read_ext(gd_GIF * gif)
     }
 }
 
+#if LV_GIF_CACHE_DECODE_DATA
 static uint16_t
 get_key(gd_GIF *gif, int key_size, uint8_t *sub_len, uint8_t *shift, uint8_t *byte)
 {
@@ -328,7 +332,6 @@ get_key(gd_GIF *gif, int key_size, uint8_t *sub_len, uint8_t *shift, uint8_t *by
     return key;
 }
 
-#if LV_GIF_CACHE_DECODE_DATA
 /* Decompress image pixels.
  * Return 0 on success or -1 on out-of-memory (w.r.t. LZW code table) or parse error. */
 static int
@@ -526,15 +529,16 @@ interlaced_line_index(int h, int y)
 {
     int p; /* number of lines in current pass */
 
-    p = (h - 1) / 8 + 1;
+    /* Rounded up from 0, frames shorter than 5 lines have empty passes */
+    p = (h + 7) / 8;
     if(y < p)  /* pass 1 */
         return y * 8;
     y -= p;
-    p = (h - 5) / 8 + 1;
+    p = (h + 3) / 8;
     if(y < p)  /* pass 2 */
         return y * 8 + 4;
     y -= p;
-    p = (h - 3) / 4 + 1;
+    p = (h + 1) / 4;
     if(y < p)  /* pass 3 */
         return y * 4 + 2;
     y -= p;
@@ -542,12 +546,58 @@ interlaced_line_index(int h, int y)
     return y * 2 + 1;
 }
 
+/* LZW code reader: whole bytes go into a bit buffer, codes are taken from its low end */
+typedef struct BitReader {
+    uint32_t bits;
+    int nbits;
+    uint8_t sub_len;
+} BitReader;
+
+static inline uint8_t
+read_byte(gd_GIF * gif)
+{
+    uint8_t byte;
+    if(!gif->is_file) {
+        return (uint8_t) gif->data[gif->f_rw_p++];
+    }
+    f_gif_read(gif, &byte, 1);
+    return byte;
+}
+
+static inline uint16_t
+read_key(gd_GIF * gif, BitReader * reader, int key_size)
+{
+    uint16_t key;
+    while(reader->nbits < key_size) {
+        if(reader->sub_len == 0) {
+            reader->sub_len = read_byte(gif); /* Must be nonzero! */
+            if(reader->sub_len == 0) return 0x1000;
+        }
+        reader->bits |= (uint32_t) read_byte(gif) << reader->nbits;
+        reader->nbits += 8;
+        reader->sub_len--;
+    }
+    key = reader->bits & ((1 << key_size) - 1);
+    reader->bits >>= key_size;
+    reader->nbits -= key_size;
+    return key;
+}
+
+/* Start of frame row y, after interlacing */
+static inline uint8_t *
+frame_row(gd_GIF * gif, int interlace, int y)
+{
+    if(interlace)
+        y = interlaced_line_index((int) gif->fh, y);
+    return &gif->frame[(gif->fy + y) * gif->width + gif->fx];
+}
+
 /* Decompress image pixels.
  * Return 0 on success or -1 on out-of-memory (w.r.t. LZW code table) or parse error. */
 static int
 read_image_data(gd_GIF * gif, int interlace)
 {
-    uint8_t sub_len, shift, byte;
+    uint8_t byte;
     int init_key_size, key_size, table_is_full = 0;
     int frm_off, frm_size, str_len = 0, i, p, x, y;
     uint16_t key, clear, stop;
@@ -555,6 +605,8 @@ read_image_data(gd_GIF * gif, int interlace)
     Table * table;
     Entry entry = {0};
     size_t start, end;
+    BitReader reader = {0};
+    uint8_t * row;
 
     f_gif_read(gif, &byte, 1);
     key_size = (int) byte;
@@ -567,8 +619,7 @@ read_image_data(gd_GIF * gif, int interlace)
     table = new_table(key_size);
     key_size++;
     init_key_size = key_size;
-    sub_len = shift = 0;
-    key = get_key(gif, key_size, &sub_len, &shift, &byte); /* clear code */
+    key = read_key(gif, &reader, key_size); /* clear code */
     frm_off = 0;
     ret = 0;
     frm_size = gif->fw * gif->fh;
@@ -589,7 +640,7 @@ read_image_data(gd_GIF * gif, int interlace)
                 table_is_full = 1;
             }
         }
-        key = get_key(gif, key_size, &sub_len, &shift, &byte);
+        key = read_key(gif, &reader, key_size);
         if(key == clear) continue;
         if(key == stop || key == 0x1000) break;
         if(ret == 1) key_size++;
@@ -600,24 +651,28 @@ read_image_data(gd_GIF * gif, int interlace)
 		lv_free(table);
 		return -1;
 	}
+        /* The string is written backwards from its last pixel, one division per code */
+        p = frm_off + str_len - 1;
+        x = p % gif->fw;
+        y = p / gif->fw;
+        row = frame_row(gif, interlace, y);
         for(i = 0; i < str_len; i++) {
-            p = frm_off + entry.length - 1;
-            x = p % gif->fw;
-            y = p / gif->fw;
-            if(interlace)
-                y = interlaced_line_index((int) gif->fh, y);
-            gif->frame[(gif->fy + y) * gif->width + gif->fx + x] = entry.suffix;
+            row[x] = entry.suffix;
             if(entry.prefix == 0xFFF)
                 break;
-            else
-                entry = table->entries[entry.prefix];
+            entry = table->entries[entry.prefix];
+            if(x == 0) {
+                if(y == 0) break;
+                x = gif->fw;
+                row = frame_row(gif, interlace, --y);
+            }
+            x--;
         }
         frm_off += str_len;
         if(key < table->nentries - 1 && !table_is_full)
             table->entries[table->nentries - 1].suffix = entry.suffix;
     }
     lv_free(table);
-    if(key == stop) f_gif_read(gif, &sub_len, 1);  /* Must be zero! */
     f_gif_seek(gif, end, LV_FS_SEEK_SET);
     return 0;
 }
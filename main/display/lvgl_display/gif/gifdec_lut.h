@@ -0,0 +1,95 @@
+/**
+ * @file gifdec_lut.h
+ *
+ */
+
+#ifndef GIFDEC_LUT_H
+#define GIFDEC_LUT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*********************
+ *      INCLUDES
+ *********************/
+#include <stdint.h>
+
+/*********************
+ *      DEFINES
+ *********************/
+
+/* Word-wide kernels for targets without the Helium ones: the palette is expanded
+ * to ARGB8888 words once per frame, then every pixel is one table load and one
+ * 32-bit store instead of four byte stores. The canvas is little endian B,G,R,A. */
+
+#define GIFDEC_FILL_BG(dst, w, h, stride, color, opa) \
+    _gifdec_fill_bg_lut(dst, w, h, stride, color, opa)
+
+#define GIFDEC_RENDER_FRAME(dst, w, h, stride, frame, pattern, tindex) \
+    _gifdec_render_frame_lut(dst, w, h, stride, frame, pattern, tindex)
+
+/**********************
+ * GLOBAL PROTOTYPES
+ **********************/
+
+static inline uint32_t _gifdec_argb(const uint8_t * rgb, uint8_t opa)
+{
+    return ((uint32_t)opa << 24) | ((uint32_t)rgb[0] << 16) | ((uint32_t)rgb[1] << 8) | rgb[2];
+}
+
+static inline void _gifdec_fill_bg_lut(uint8_t * dst, uint16_t w, uint16_t h, uint16_t stride, uint8_t * color,
+                                       uint8_t opa)
+{
+    uint32_t c = _gifdec_argb(color, opa);
+    uint32_t * row = (uint32_t *)dst;
+
+    for(int y = 0; y < h; y++) {
+        for(int x = 0; x < w; x++) {
+            row[x] = c;
+        }
+        row += stride;
+    }
+}
+
+/* tindex is the transparent palette index, or 0x100 when the frame has none */
+static inline void _gifdec_render_frame_lut(uint8_t * dst, uint16_t w, uint16_t h, uint16_t stride, uint8_t * frame,
+                                            uint8_t * pattern, uint16_t tindex)
+{
+    uint32_t lut[256];
+    for(int i = 0; i < 256; i++) {
+        lut[i] = _gifdec_argb(&pattern[i * 3], 0xFF);
+    }
+
+    uint32_t * row = (uint32_t *)dst;
+    for(int y = 0; y < h; y++) {
+        const uint8_t * src = &frame[y * stride];
+        if(tindex > 0xFF) {
+            int x = 0;
+            for(; x + 4 <= w; x += 4) {
+                row[x + 0] = lut[src[x + 0]];
+                row[x + 1] = lut[src[x + 1]];
+                row[x + 2] = lut[src[x + 2]];
+                row[x + 3] = lut[src[x + 3]];
+            }
+            for(; x < w; x++) {
+                row[x] = lut[src[x]];
+            }
+        }
+        else {
+            for(int x = 0; x < w; x++) {
+                uint8_t index = src[x];
+                if(index != tindex) {
+                    row[x] = lut[index];
+                }
+            }
+        }
+        row += stride;
+    }
+}
+
+#ifdef __cplusplus
+} /*extern "C"*/
+#endif
+
+#endif /*GIFDEC_LUT_H*/
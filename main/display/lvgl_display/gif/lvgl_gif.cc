@@ -1,5 +1,9 @@
 #include "lvgl_gif.h"
+#include "lvgl_gif_cache.h"
+#include "lvgl_gif_worker.h"
 #include <esp_log.h>
+#include <esp_timer.h>
+#include <esp_heap_caps.h>
 #include <cstring>
 
 #define TAG "LvglGif"
@@ -12,11 +16,17 @@ LvglGif::LvglGif(const lv_img_dsc_t* img_dsc)
         return;
     }
 
+    source_ = img_dsc->data;
+    first_frame_from_us_ = esp_timer_get_time();
     gif_ = gd_open_gif_data(img_dsc->data);
     if (!gif_) {
         ESP_LOGE(TAG, "Failed to open GIF from image descriptor");
         return;
     }
+    decoder_ = std::make_shared<LvglGifDecoder>();
+    decoder_->gif = gif_;
+    decoder_->frame_size = (size_t)gif_->width * gif_->height * 4;
+    decoder_->buffers[0] = gif_->canvas;
 
     // Setup LVGL image descriptor
     memset(&img_dsc_, 0, sizeof(img_dsc_));
@@ -34,6 +44,11 @@ LvglGif::LvglGif(const lv_img_dsc_t* img_dsc)
         gd_render_frame(gif_, gif_->canvas);
     }
 
+#if CONFIG_EMOJI_GIF_DECODE_TASK
+    // The back buffer is allocated by the first decode request
+    async_ = true;
+#endif
+
     loaded_ = true;
     ESP_LOGD(TAG, "GIF loaded from image descriptor: %dx%d", gif_->width, gif_->height);
 }
@@ -71,9 +86,28 @@ void LvglGif::Start() {
         last_call_ = lv_tick_get();
         lv_timer_resume(timer_);
         lv_timer_reset(timer_);
-        
-        // Render first frame
+
+        // Time to first frame counts from opening the GIF, or from here when it is reused
+        first_frame_reused_ = played_;
+        if (played_) {
+            first_frame_from_us_ = esp_timer_get_time();
+        }
+        played_ = true;
+        first_frame_pending_ = true;
+
+        // A finite loop that ran out plays again from the first frame
+        if (frames_finished_) {
+            frames_finished_ = false;
+            frame_plays_ = 0;
+            ShowCachedFrame(0);
+        }
+
+        // Render first frame. With decode-ahead this only queues it, the worker's
+        // frame is shown by a later timer tick
         NextFrame();
+        if (!async_ || frames_complete_) {
+            RecordFirstFrame();
+        }
         
         ESP_LOGD(TAG, "GIF animation started");
     }
@@ -101,15 +135,28 @@ void LvglGif::Resume() {
 }
 
 void LvglGif::Stop() {
-    if (timer_) {
-        playing_ = false;
-        lv_timer_pause(timer_);
-    }
+    playing_ = false;
 
     // Reset loop waiting state
     loop_waiting_ = false;
 
-    if (gif_) {
+    if (frames_complete_) {
+        gd_rewind(gif_);
+        frames_finished_ = false;
+        frame_plays_ = 0;
+        ShowCachedFrame(0);
+        ESP_LOGD(TAG, "GIF animation stopped and rewound");
+    } else if (async_) {
+        // Never waits for the worker: if it is decoding, the rewind is finished by the
+        // timer once it is done
+        DiscardDecode();
+        reset_pending_ = true;
+        ResetDecoder();
+    } else if (gif_) {
+        // A partial capture starts over with the rewound decoder
+        if (decoder_->capturing) {
+            decoder_->FreeFrames();
+        }
         gd_rewind(gif_);
         // Render first frame without advancing
         if (gif_->canvas) {
@@ -117,6 +164,10 @@ void LvglGif::Stop() {
         }
         ESP_LOGD(TAG, "GIF animation stopped and rewound");
     }
+
+    if (timer_ && !reset_pending_) {
+        lv_timer_pause(timer_);
+    }
 }
 
 bool LvglGif::IsPlaying() const {
@@ -131,6 +182,9 @@ int32_t LvglGif::GetLoopCount() const {
     if (!loaded_ || !gif_) {
         return -1;
     }
+    if (frames_complete_) {
+        return frame_loop_count_;
+    }
     return gif_->loop_count;
 }
 
@@ -139,7 +193,12 @@ void LvglGif::SetLoopCount(int32_t count) {
         ESP_LOGW(TAG, "GIF not loaded, cannot set loop count");
         return;
     }
-    gif_->loop_count = count;
+    // The worker may be decoding, whichever task decodes next applies it
+    decoder_->loop_count_request = count;
+    if (!async_) {
+        decoder_->ApplyLoopCount();
+    }
+    frame_loop_count_ = count;
 }
 
 uint32_t LvglGif::GetLoopDelay() const {
@@ -170,10 +229,20 @@ void LvglGif::SetFrameCallback(std::function<void()> callback) {
 }
 
 void LvglGif::NextFrame() {
+    // Stop() could not rewind while the worker was decoding, the timer keeps running until it can
+    if (reset_pending_ && !ResetDecoder()) {
+        return;
+    }
+
     if (!loaded_ || !gif_ || !playing_) {
         return;
     }
 
+    // Nothing to show while hidden, so nothing to decode either
+    if (target_ != nullptr && !lv_obj_is_visible(target_)) {
+        return;
+    }
+
     // Check if we're in loop wait state (only for infinite loop GIFs with delay)
     if (loop_waiting_) {
         uint32_t wait_elapsed = lv_tick_elaps(loop_wait_start_);
@@ -184,6 +253,21 @@ void LvglGif::NextFrame() {
         // Loop delay completed, continue playing
         loop_waiting_ = false;
         ESP_LOGD(TAG, "Loop delay completed, continuing GIF");
+        if (frames_complete_) {
+            last_call_ = lv_tick_get();
+            ShowCachedFrame(0);
+            return;
+        }
+    }
+
+    if (frames_complete_) {
+        NextCachedFrame();
+        return;
+    }
+
+    if (async_) {
+        NextDecodedFrame();
+        return;
     }
 
     // Check if enough time has passed for the next frame
@@ -193,11 +277,13 @@ void LvglGif::NextFrame() {
     }
 
     last_call_ = lv_tick_get();
+    int64_t start_time = esp_timer_get_time();
 
     // Save file position before getting next frame to detect loop
     uint32_t pos_before = gif_->f_rw_p;
 
     // Get next frame
+    decoder_->ApplyLoopCount();
     int has_next = gd_get_frame(gif_);
     if (has_next == 0) {
         // Animation truly finished (non-infinite loop)
@@ -205,13 +291,34 @@ void LvglGif::NextFrame() {
         if (timer_) {
             lv_timer_pause(timer_);
         }
+        if (decoder_->capturing) {
+            FinishCapture();
+            frames_finished_ = frames_complete_;
+        }
         ESP_LOGD(TAG, "GIF animation completed");
         return;
     }
 
     // Detect loop by checking if file position jumped back (rewound to start)
     // This works for looping GIFs regardless of when loop_count is set
-    if (loop_delay_ms_ > 0 && gif_->f_rw_p < pos_before) {
+    bool looped = gif_->f_rw_p < pos_before;
+    if (looped && decoder_->capturing) {
+        FinishCapture();
+        if (frames_complete_) {
+            // The decoder played the first loop, the captured frames play the rest
+            frame_plays_ = 1;
+            frame_index_ = decoder_->frames.size() - 1;
+            if (loop_delay_ms_ > 0) {
+                loop_waiting_ = true;
+                loop_wait_start_ = lv_tick_get();
+            } else {
+                ShowCachedFrame(0);
+            }
+            return;
+        }
+    }
+
+    if (loop_delay_ms_ > 0 && looped) {
         // File position decreased, meaning GIF looped back to beginning
         // Start waiting before rendering this frame
         loop_waiting_ = true;
@@ -223,6 +330,14 @@ void LvglGif::NextFrame() {
     // Render current frame
     if (gif_->canvas) {
         gd_render_frame(gif_, gif_->canvas);
+        if (decoder_->capturing) {
+            decoder_->CaptureFrame();
+        }
+        if (stats_ != nullptr) {
+            uint32_t elapsed_us = esp_timer_get_time() - start_time;
+            stats_->RecordFrame(elapsed_us, false);
+            stats_->lvgl_frame_us.Add(elapsed_us);
+        }
         
         // Call frame callback if set
         if (frame_callback_) {
@@ -231,6 +346,247 @@ void LvglGif::NextFrame() {
     }
 }
 
+void LvglGif::NextCachedFrame() {
+    auto& frames = decoder_->frames;
+    if (lv_tick_elaps(last_call_) < frames[frame_index_].delay * 10) {
+        return;
+    }
+    last_call_ = lv_tick_get();
+
+    size_t next = frame_index_ + 1;
+    if (next == frames.size()) {
+        // Same loop count rules as the decoder: -1 plays once, 0 forever, N plays N times
+        frame_plays_++;
+        int32_t plays = frame_loop_count_ < 0 ? 1 : frame_loop_count_;
+        if (plays > 0 && frame_plays_ >= plays) {
+            playing_ = false;
+            frames_finished_ = true;
+            if (timer_) {
+                lv_timer_pause(timer_);
+            }
+            ESP_LOGD(TAG, "GIF animation completed");
+            return;
+        }
+        if (loop_delay_ms_ > 0) {
+            loop_waiting_ = true;
+            loop_wait_start_ = lv_tick_get();
+            ESP_LOGD(TAG, "GIF completed one cycle, waiting %lu ms before next loop", loop_delay_ms_);
+            return;
+        }
+        next = 0;
+    }
+
+    int64_t start_time = esp_timer_get_time();
+    ShowCachedFrame(next);
+    if (stats_ != nullptr) {
+        uint32_t elapsed_us = esp_timer_get_time() - start_time;
+        stats_->RecordFrame(elapsed_us, true);
+        stats_->lvgl_frame_us.Add(elapsed_us);
+    }
+}
+
+void LvglGif::NextDecodedFrame() {
+    auto& decoder = *decoder_;
+    int state = decoder.state.load(std::memory_order_acquire);
+    if (state == LvglGifDecoder::kIdle) {
+        RequestDecode();
+        return;
+    }
+    if (state != LvglGifDecoder::kReady) {
+        // Still decoding, this frame is late
+        return;
+    }
+    // Until the first decoded frame the canvas holds no frame of its own, it goes as soon as
+    // there is one
+    if (frame_shown_ && lv_tick_elaps(last_call_) < shown_delay_ * 10) {
+        return;
+    }
+
+    // A looped GIF waits with the first frame of the next loop ready in the back buffer
+    if (decoder.looped && !decoder.capturing && loop_delay_ms_ > 0) {
+        decoder.looped = false;
+        loop_waiting_ = true;
+        loop_wait_start_ = lv_tick_get();
+        ESP_LOGD(TAG, "GIF completed one cycle, waiting %lu ms before next loop", loop_delay_ms_);
+        return;
+    }
+
+    last_call_ = lv_tick_get();
+    int64_t start_time = esp_timer_get_time();
+    decoder.state = LvglGifDecoder::kIdle;
+    if (stats_ != nullptr) {
+        stats_->RecordFrame(decoder.decode_us, false);
+    }
+
+    if (decoder.result == 0) {
+        // Animation truly finished (non-infinite loop), keep the canvas in front
+        decoder.front = 1 - decoder.front;
+        img_dsc_.data = decoder.buffers[decoder.front];
+        playing_ = false;
+        if (timer_) {
+            lv_timer_pause(timer_);
+        }
+        if (decoder.capturing) {
+            FinishCapture();
+            frames_finished_ = frames_complete_;
+        }
+        ReleaseBackBuffer();
+        ESP_LOGD(TAG, "GIF animation completed");
+        return;
+    }
+
+    if (decoder.looped && decoder.capturing) {
+        FinishCapture();
+        if (frames_complete_) {
+            // The decoder played the first loop, the captured frames play the rest.
+            // The last one is the frame in front, show it from the capture so the
+            // back buffer can go
+            frame_plays_ = 1;
+            frame_index_ = decoder.frames.size() - 1;
+            if (loop_delay_ms_ > 0) {
+                ShowCachedFrame(frame_index_);
+                loop_waiting_ = true;
+                loop_wait_start_ = lv_tick_get();
+            } else {
+                ShowCachedFrame(0);
+            }
+            ReleaseBackBuffer();
+            return;
+        }
+    }
+
+    // The back buffer becomes the front one, decode the next frame into the other
+    decoder.front = 1 - decoder.front;
+    img_dsc_.data = decoder.buffers[decoder.front];
+    shown_delay_ = decoder.delay;
+    frame_shown_ = true;
+    if (frame_callback_) {
+        frame_callback_();
+    }
+    RecordFirstFrame();
+    RequestDecode();
+
+    if (stats_ != nullptr) {
+        stats_->lvgl_frame_us.Add(esp_timer_get_time() - start_time);
+    }
+}
+
+void LvglGif::RequestDecode() {
+    auto& decoder = *decoder_;
+    if (decoder.buffers[1] == nullptr) {
+        decoder.buffers[1] = (uint8_t*)heap_caps_malloc(decoder.frame_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (decoder.buffers[1] == nullptr) {
+            ESP_LOGW(TAG, "No memory for the back buffer, decoding in the LVGL task");
+            async_ = false;
+            return;
+        }
+    }
+    decoder.state = LvglGifDecoder::kQueued;
+    LvglGifWorker::GetInstance().Post(decoder_, decoder.generation);
+}
+
+// A queued decode is taken back. One the worker is already running is left to finish,
+// it comes back as kStale because the generation changed.
+void LvglGif::DiscardDecode() {
+    auto& decoder = *decoder_;
+    decoder.generation++;
+    if (decoder.state == LvglGifDecoder::kQueued && LvglGifWorker::GetInstance().Cancel(&decoder)) {
+        decoder.state = LvglGifDecoder::kIdle;
+    }
+}
+
+// Rewinds the decoder for Stop(). False while the worker still decodes.
+bool LvglGif::ResetDecoder() {
+    auto& decoder = *decoder_;
+    int state = decoder.state.load(std::memory_order_acquire);
+    if (state == LvglGifDecoder::kQueued || state == LvglGifDecoder::kBusy) {
+        return false;
+    }
+    reset_pending_ = false;
+    decoder.state = LvglGifDecoder::kIdle;
+    // A stopped GIF keeps only the frame in front, Start() allocates the back buffer again
+    ReleaseBackBuffer();
+    // A partial capture starts over with the rewound decoder
+    if (decoder.capturing) {
+        decoder.FreeFrames();
+    }
+    gd_rewind(gif_);
+    frame_shown_ = false;
+    if (!playing_ && timer_) {
+        lv_timer_pause(timer_);
+    }
+    ESP_LOGD(TAG, "GIF animation stopped and rewound");
+    return true;
+}
+
+// Only called while the worker is not decoding
+void LvglGif::ReleaseBackBuffer() {
+    auto& decoder = *decoder_;
+    if (decoder.buffers[1] == nullptr) {
+        return;
+    }
+    if (img_dsc_.data == decoder.buffers[1]) {
+        memcpy(decoder.buffers[0], decoder.buffers[1], decoder.frame_size);
+        img_dsc_.data = decoder.buffers[0];
+        if (frame_callback_) {
+            frame_callback_();
+        }
+    }
+    decoder.front = 0;
+    gif_->canvas = decoder.buffers[0];
+    heap_caps_free(decoder.buffers[1]);
+    decoder.buffers[1] = nullptr;
+}
+
+void LvglGif::RecordFirstFrame() {
+    if (!first_frame_pending_) {
+        return;
+    }
+    first_frame_pending_ = false;
+    if (stats_ != nullptr) {
+        stats_->RecordFirstFrame(esp_timer_get_time() - first_frame_from_us_, first_frame_reused_);
+    }
+}
+
+void LvglGif::ShowCachedFrame(size_t index) {
+    frame_index_ = index;
+    img_dsc_.data = decoder_->frames[index].pixels;
+    if (frame_callback_) {
+        frame_callback_();
+    }
+}
+
+void LvglGif::EnableFrameCapture(std::shared_ptr<LvglGifFrameBudget> budget) {
+    if (!loaded_ || frames_complete_ || decoder_->capturing || budget == nullptr) {
+        return;
+    }
+    // Not worth it unless at least a couple of frames fit
+    if (budget->available() < decoder_->frame_size * 2) {
+        return;
+    }
+    decoder_->frame_budget = std::move(budget);
+    decoder_->capturing = true;
+}
+
+size_t LvglGif::frame_bytes() const {
+    if (!loaded_ || !gif_) {
+        return 0;
+    }
+    // Atomic, the worker adds frames while it captures the first loop
+    return decoder_->frame_bytes;
+}
+
+void LvglGif::FinishCapture() {
+    auto& decoder = *decoder_;
+    decoder.capturing = false;
+    if (decoder.frames.empty()) {
+        return;
+    }
+    frames_complete_ = true;
+    frame_loop_count_ = decoder.frame_loop_count;
+    ESP_LOGI(TAG, "Captured %u frames, %u bytes", (unsigned)decoder.frames.size(), (unsigned)frame_bytes());
+}
+
 void LvglGif::Cleanup() {
     // Stop and delete timer
     if (timer_) {
@@ -238,11 +594,17 @@ void LvglGif::Cleanup() {
         timer_ = nullptr;
     }
 
-    // Close GIF decoder
-    if (gif_) {
-        gd_close_gif(gif_);
-        gif_ = nullptr;
+    // Close GIF decoder. If the worker is still decoding it holds the last reference
+    // and closes the decoder when done, nothing here waits for it
+    if (decoder_ != nullptr) {
+        DiscardDecode();
+        decoder_.reset();
     }
+    gif_ = nullptr;
+    async_ = false;
+    reset_pending_ = false;
+    frames_complete_ = false;
+    frames_finished_ = false;
 
     playing_ = false;
     loaded_ = false;
@@ -250,3 +612,85 @@ void LvglGif::Cleanup() {
     // Clear image descriptor
     memset(&img_dsc_, 0, sizeof(img_dsc_));
 }
+
+LvglGifDecoder::~LvglGifDecoder() {
+    FreeFrames();
+    // The canvas may be either buffer, but only the second one is allocated separately
+    if (buffers[1] != nullptr) {
+        heap_caps_free(buffers[1]);
+    }
+    if (gif != nullptr) {
+        gd_close_gif(gif);
+    }
+}
+
+void LvglGifDecoder::DecodeAhead(uint32_t queued_generation) {
+    int64_t start_time = esp_timer_get_time();
+    uint8_t* back = buffers[1 - front];
+
+    // The decoder draws onto the previous frame, the front buffer is only read here
+    memcpy(back, buffers[front], frame_size);
+    gif->canvas = back;
+
+    ApplyLoopCount();
+    uint32_t pos_before = gif->f_rw_p;
+    result = gd_get_frame(gif);
+    looped = result != 0 && gif->f_rw_p < pos_before;
+    if (result != 0) {
+        gd_render_frame(gif, back);
+    }
+
+    // Stopped or destroyed meanwhile: not captured and never shown
+    if (generation != queued_generation) {
+        state.store(kStale, std::memory_order_release);
+        return;
+    }
+    if (result != 0 && capturing && !looped) {
+        CaptureFrame();
+    }
+    delay = gif->gce.delay;
+    decode_us = esp_timer_get_time() - start_time;
+    state.store(kReady, std::memory_order_release);
+}
+
+void LvglGifDecoder::ApplyLoopCount() {
+    int32_t count = loop_count_request.exchange(INT32_MIN);
+    if (count != INT32_MIN) {
+        gif->loop_count = count;
+    }
+}
+
+void LvglGifDecoder::CaptureFrame() {
+    if (frames.empty()) {
+        // The loop count is read with the first frame
+        frame_loop_count = gif->loop_count;
+    }
+
+    uint8_t* pixels = nullptr;
+    if (frames.size() < LVGL_GIF_MAX_CACHED_FRAMES && frame_budget->Charge(frame_size)) {
+        pixels = (uint8_t*)heap_caps_malloc(frame_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (pixels == nullptr) {
+            frame_budget->Refund(frame_size);
+        }
+    }
+    if (pixels == nullptr) {
+        // Too long for the budget, keep decoding this one
+        ESP_LOGD(TAG, "Frame capture stopped after %u frames", (unsigned)frames.size());
+        FreeFrames();
+        capturing = false;
+        return;
+    }
+    memcpy(pixels, gif->canvas, frame_size);
+    frames.push_back(LvglGifFrame{pixels, gif->gce.delay});
+    frame_bytes += frame_size;
+}
+
+void LvglGifDecoder::FreeFrames() {
+    for (auto& frame : frames) {
+        heap_caps_free(frame.pixels);
+    }
+    frames.clear();
+    if (frame_budget != nullptr) {
+        frame_budget->Refund(frame_bytes.exchange(0));
+    }
+}
@@ -4,7 +4,95 @@
 #include "gifdec.h"
 #include <lvgl.h>
 #include <memory>
+#include <atomic>
+#include <algorithm>
 #include <functional>
+#include <vector>
+
+// A short loop is kept as fully rendered frames, longer GIFs are always decoded
+#define LVGL_GIF_MAX_CACHED_FRAMES 48
+
+struct LvglGifStats;
+
+/**
+ * PSRAM shared by the captured frames of every decoder, whether cached, playing or
+ * still capturing. Frames are charged as they are kept and refunded when freed, so
+ * the total never goes over the limit. Charged from the worker task as well.
+ */
+struct LvglGifFrameBudget {
+    const size_t limit;
+    std::atomic<size_t> used = 0;
+
+    explicit LvglGifFrameBudget(size_t limit) : limit(limit) {}
+
+    bool Charge(size_t bytes) {
+        size_t current = used.load();
+        do {
+            if (current + bytes > limit) {
+                return false;
+            }
+        } while (!used.compare_exchange_weak(current, current + bytes));
+        return true;
+    }
+
+    void Refund(size_t bytes) { used -= bytes; }
+    size_t available() const { return limit - std::min(limit, used.load()); }
+};
+
+struct LvglGifFrame {
+    uint8_t* pixels;
+    uint16_t delay;           // In 10 ms units, as in the GIF
+};
+
+/**
+ * The GIF decoder, the buffers it renders into and the frames captured from it.
+ * Shared with LvglGifWorker, which holds its own reference while it decodes, so the
+ * LVGL task never waits for the worker: a decode that is no longer wanted is dropped
+ * by bumping the generation, and whichever side lets go last closes the decoder.
+ */
+struct LvglGifDecoder {
+    enum State {
+        kIdle,
+        kQueued,
+        kBusy,
+        kReady,
+        kStale,                   // Finished after the generation changed, nothing to show
+    };
+
+    gd_GIF* gif = nullptr;
+    size_t frame_size = 0;
+
+    // Decode-ahead: the worker renders the next frame into the back buffer while the
+    // front one is shown. buffers[0] is the decoder's own canvas, buffers[1] is only
+    // allocated while playing.
+    uint8_t* buffers[2] = {};
+    int front = 0;
+    std::atomic<int> state = kIdle;
+    std::atomic<uint32_t> generation = 0;
+    // Set by SetLoopCount(), taken over by whichever task decodes next
+    std::atomic<int32_t> loop_count_request = INT32_MIN;
+
+    // Result of the last decode ahead
+    int result = 0;               // gd_get_frame() result
+    bool looped = false;
+    uint16_t delay = 0;
+    uint32_t decode_us = 0;
+
+    // First loop kept as rendered frames
+    std::vector<LvglGifFrame> frames;
+    std::atomic<size_t> frame_bytes = 0;
+    std::shared_ptr<LvglGifFrameBudget> frame_budget;
+    bool capturing = false;
+    int32_t frame_loop_count = -1;
+
+    ~LvglGifDecoder();
+
+    // Runs in the worker task, `queued_generation` is the generation the decode was queued with
+    void DecodeAhead(uint32_t queued_generation);
+    void ApplyLoopCount();
+    void CaptureFrame();
+    void FreeFrames();
+};
 
 /**
  * C++ implementation of LVGL GIF widget
@@ -80,8 +168,58 @@ public:
      */
     void SetFrameCallback(std::function<void()> callback);
 
+    /**
+     * Keep the frames rendered during the first loop, charged against the budget.
+     * Later loops show the kept frames and skip LZW decoding altogether.
+     */
+    void EnableFrameCapture(std::shared_ptr<LvglGifFrameBudget> budget);
+
+    /**
+     * Bytes held by captured frames
+     */
+    size_t frame_bytes() const;
+
+    /**
+     * GIF data this decoder reads from
+     */
+    const void* source() const { return source_; }
+
+    /**
+     * Record per-frame decode time into the given statistics
+     */
+    void SetStats(LvglGifStats* stats) { stats_ = stats; }
+
+    /**
+     * Frames are neither decoded nor shown while this object is not visible
+     */
+    void SetTarget(lv_obj_t* target) { target_ = target; }
+
 private:
-    // GIF decoder instance
+    const void* source_ = nullptr;
+    LvglGifStats* stats_ = nullptr;
+    std::shared_ptr<LvglGifDecoder> decoder_;
+
+    // Captured loop, used instead of the decoder once complete
+    bool frames_complete_ = false;
+    bool frames_finished_ = false;  // A finite loop count ran out
+    size_t frame_index_ = 0;
+    int32_t frame_loop_count_ = -1;
+    int32_t frame_plays_ = 0;
+
+    lv_obj_t* target_ = nullptr;
+
+    bool async_ = false;          // Frames are decoded ahead by the worker
+    bool reset_pending_ = false;  // Stop() waits for the decode in flight to finish
+    bool frame_shown_ = false;    // False while the canvas only holds the background or a stopped frame
+    uint16_t shown_delay_ = 0;    // Delay of the front buffer, in 10 ms units
+
+    // Time to first frame, counted from opening the GIF or from Start() when reused
+    bool played_ = false;
+    bool first_frame_reused_ = false;
+    bool first_frame_pending_ = false;
+    int64_t first_frame_from_us_ = 0;
+
+    // GIF decoder instance, owned by decoder_
     gd_GIF* gif_;
     
     // LVGL image descriptor
@@ -109,6 +247,24 @@ private:
      * Update to next frame
      */
     void NextFrame();
+
+    /**
+     * Advance through the captured frames
+     */
+    void NextCachedFrame();
+    void ShowCachedFrame(size_t index);
+
+    /**
+     * Decode-ahead playback
+     */
+    void NextDecodedFrame();
+    void RequestDecode();
+    void DiscardDecode();
+    bool ResetDecoder();
+    void ReleaseBackBuffer();
+
+    void FinishCapture();
+    void RecordFirstFrame();
     
     /**
      * Cleanup resources
@@ -0,0 +1,95 @@
+#include "lvgl_gif_cache.h"
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <algorithm>
+
+#define TAG "LvglGifCache"
+
+void LvglGifStats::RecordFrame(uint32_t elapsed_us, bool cached) {
+    frame_us_total += elapsed_us;
+    if (cached) {
+        cached_frame_us.Add(elapsed_us);
+    } else {
+        decoded_frame_us.Add(elapsed_us);
+    }
+}
+
+void LvglGifStats::RecordFirstFrame(uint32_t elapsed_us, bool hit) {
+    if (hit) {
+        first_frame_hit_us.Add(elapsed_us);
+    } else {
+        first_frame_miss_us.Add(elapsed_us);
+    }
+}
+
+void LvglGifStats::Reset() {
+    *this = LvglGifStats();
+    since_us = esp_timer_get_time();
+}
+
+LvglGifCache::LvglGifCache(size_t capacity, size_t frame_budget)
+    : capacity_(capacity), frame_budget_(std::make_shared<LvglGifFrameBudget>(frame_budget)) {
+    stats_.since_us = esp_timer_get_time();
+}
+
+std::unique_ptr<LvglGif> LvglGifCache::Acquire(const lv_img_dsc_t* img_dsc) {
+    auto it = std::find_if(entries_.begin(), entries_.end(), [img_dsc](const std::unique_ptr<LvglGif>& gif) {
+        return gif->source() == img_dsc->data;
+    });
+    if (it != entries_.end()) {
+        auto gif = std::move(*it);
+        entries_.erase(it);
+        stats_.hits++;
+        return gif;
+    }
+
+    stats_.misses++;
+    auto gif = std::make_unique<LvglGif>(img_dsc);
+    gif->SetStats(&stats_);
+    // Whatever the other decoders keep, including one still capturing, is already charged
+    gif->EnableFrameCapture(frame_budget_);
+    return gif;
+}
+
+void LvglGifCache::Release(std::unique_ptr<LvglGif> gif) {
+    if (gif == nullptr || !gif->IsLoaded() || capacity_ == 0) {
+        return;
+    }
+    // The callback belongs to the previous user
+    gif->SetFrameCallback(nullptr);
+    gif->Stop();
+    entries_.push_front(std::move(gif));
+
+    while (entries_.size() > capacity_) {
+        ESP_LOGD(TAG, "Evict GIF %p, %u frame bytes", entries_.back()->source(), (unsigned)entries_.back()->frame_bytes());
+        entries_.pop_back();
+        stats_.evictions++;
+    }
+}
+
+void LvglGifCache::Clear() {
+    entries_.clear();
+}
+
+cJSON* LvglGifCache::ToJson(bool reset) {
+    int64_t elapsed_us = std::max<int64_t>(1, esp_timer_get_time() - stats_.since_us);
+    cJSON* json = cJSON_CreateObject();
+    cJSON_AddNumberToObject(json, "entries", entries_.size());
+    // Captured frames of every decoder, the playing one included
+    cJSON_AddNumberToObject(json, "frame_bytes", frame_budget_->used.load());
+    cJSON_AddNumberToObject(json, "frame_budget", frame_budget_->limit);
+    cJSON_AddNumberToObject(json, "hits", stats_.hits);
+    cJSON_AddNumberToObject(json, "misses", stats_.misses);
+    cJSON_AddNumberToObject(json, "evictions", stats_.evictions);
+    cJSON_AddItemToObject(json, "first_frame_hit_us", stats_.first_frame_hit_us.ToJson());
+    cJSON_AddItemToObject(json, "first_frame_miss_us", stats_.first_frame_miss_us.ToJson());
+    cJSON_AddItemToObject(json, "decoded_frame_us", stats_.decoded_frame_us.ToJson());
+    cJSON_AddItemToObject(json, "cached_frame_us", stats_.cached_frame_us.ToJson());
+    cJSON_AddItemToObject(json, "lvgl_frame_us", stats_.lvgl_frame_us.ToJson());
+    // CPU time per second of wall time spent on GIF frames, in microseconds
+    cJSON_AddNumberToObject(json, "frame_us_per_s", (double)(stats_.frame_us_total * 1000000 / elapsed_us));
+    if (reset) {
+        stats_.Reset();
+    }
+    return json;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "lvgl_gif.h"
+#include "../lvgl_perf_monitor.h"
+#include <cJSON.h>
+#include <list>
+#include <memory>
+
+/**
+ * Emotion GIF timing: time to first frame, and the time spent producing frames
+ * (decoding, or just switching to a captured frame)
+ */
+struct LvglGifStats {
+    int64_t since_us = 0;
+    uint32_t hits = 0;
+    uint32_t misses = 0;
+    uint32_t evictions = 0;
+    uint64_t frame_us_total = 0;
+    LvglPerfHistogram first_frame_hit_us;
+    LvglPerfHistogram first_frame_miss_us;
+    LvglPerfHistogram decoded_frame_us;
+    LvglPerfHistogram cached_frame_us;
+    LvglPerfHistogram lvgl_frame_us;      // Time the LVGL task spent per frame
+
+    void RecordFrame(uint32_t elapsed_us, bool cached);
+    // From opening the GIF, or from Start() for a reused one, until its first frame is shown
+    void RecordFirstFrame(uint32_t elapsed_us, bool hit);
+    void Reset();
+};
+
+/**
+ * Opened GIF decoders kept for reuse, least recently used first out.
+ *
+ * The display hands its controller back when the emotion changes and asks for
+ * one again on the next GIF emotion, so a repeated emotion skips reopening the
+ * GIF. New decoders may capture their first loop as rendered frames within
+ * frame_budget bytes, shared by the cached decoders and the one handed out.
+ * Only used from the LVGL task or with the display lock held.
+ */
+class LvglGifCache {
+public:
+    LvglGifCache(size_t capacity, size_t frame_budget);
+
+    /**
+     * Cached decoder for this GIF, or a newly opened one
+     */
+    std::unique_ptr<LvglGif> Acquire(const lv_img_dsc_t* img_dsc);
+
+    /**
+     * Stop the decoder and keep it for later
+     */
+    void Release(std::unique_ptr<LvglGif> gif);
+
+    /**
+     * Drop every cached decoder, the GIF data they read may go away
+     */
+    void Clear();
+
+    cJSON* ToJson(bool reset);
+
+private:
+    size_t capacity_;
+    std::shared_ptr<LvglGifFrameBudget> frame_budget_;
+    std::list<std::unique_ptr<LvglGif>> entries_;  // Most recently used first
+    LvglGifStats stats_;
+};
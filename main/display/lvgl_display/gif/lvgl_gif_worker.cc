@@ -0,0 +1,53 @@
+#include "lvgl_gif_worker.h"
+#include "lvgl_gif.h"
+#include <esp_log.h>
+#include <algorithm>
+
+#define TAG "LvglGifWorker"
+
+// Below the LVGL task, decoding only uses otherwise idle time
+#define LVGL_GIF_WORKER_PRIORITY 1
+#define LVGL_GIF_WORKER_STACK_SIZE 4096
+
+LvglGifWorker::LvglGifWorker() {
+    xTaskCreate([](void* arg) {
+        static_cast<LvglGifWorker*>(arg)->Run();
+    }, "gif_decode", LVGL_GIF_WORKER_STACK_SIZE, this, LVGL_GIF_WORKER_PRIORITY, &task_);
+}
+
+void LvglGifWorker::Post(std::shared_ptr<LvglGifDecoder> decoder, uint32_t generation) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.push_back(Job{std::move(decoder), generation});
+    }
+    condition_.notify_one();
+}
+
+bool LvglGifWorker::Cancel(LvglGifDecoder* decoder) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = std::remove_if(queue_.begin(), queue_.end(), [decoder](const Job& job) {
+        return job.decoder.get() == decoder;
+    });
+    bool removed = it != queue_.end();
+    queue_.erase(it, queue_.end());
+    return removed;
+}
+
+void LvglGifWorker::Run() {
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            condition_.wait(lock, [this]() { return !queue_.empty(); });
+            job = std::move(queue_.front());
+            queue_.pop_front();
+            // Set under the lock, so Cancel() either removes the job or sees it running
+            job.decoder->state = LvglGifDecoder::kBusy;
+        }
+
+        job.decoder->DecodeAhead(job.generation);
+        // Closes the decoder if its LvglGif was destroyed while decoding. The LVGL heap
+        // is the C library's (CONFIG_LV_USE_CLIB_MALLOC), so freeing here is safe
+        job.decoder.reset();
+    }
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+struct LvglGifDecoder;
+
+/**
+ * Low priority task that decodes the next GIF frame ahead of time, so the
+ * LVGL timer only swaps buffers. One task serves every LvglGif.
+ */
+class LvglGifWorker {
+public:
+    static LvglGifWorker& GetInstance() {
+        static LvglGifWorker instance;
+        return instance;
+    }
+
+    /**
+     * Queue one frame decode, the result is dropped if the decoder's
+     * generation has changed by the time it is done
+     */
+    void Post(std::shared_ptr<LvglGifDecoder> decoder, uint32_t generation);
+
+    /**
+     * Take back a decode that has not started. Returns false if the worker
+     * is already running it; it is never waited for.
+     */
+    bool Cancel(LvglGifDecoder* decoder);
+
+private:
+    struct Job {
+        std::shared_ptr<LvglGifDecoder> decoder;
+        uint32_t generation;
+    };
+
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    std::deque<Job> queue_;
+    TaskHandle_t task_ = nullptr;
+
+    LvglGifWorker();
+    void Run();
+};
@@ -1,6 +1,7 @@
 #include <esp_attr.h>
 #include <esp_heap_caps.h>
 #include <esp_log.h>
+#include <esp_timer.h>
 #include <stddef.h>
 #include <string.h>
 #include <utility>
@@ -424,6 +425,159 @@ static bool encode_with_esp_new_jpeg(const uint8_t* src, size_t src_len, uint16_
     return true;
 }
 
+// 分块编码：一次只转换并编码一个 MCU 行带（YUV420 为 16 行，灰度为 8 行），
+// 不再需要整帧的中间缓冲区，每个行带的 JPEG 输出会立即交给回调
+#define TILED_BAND_ROWS_YUV420 16
+#define TILED_BAND_ROWS_GRAY 8
+// 单个行带输出的最坏情况（与 libjpeg-turbo tj3JPEGBufSize 的上界相同）：4:2:0 每像素 3 字节，
+// 灰度每像素 2 字节，再加上余量给第一个行带的 JPEG 头和最后的 EOI。
+// 按最坏情况分配后，编码器不会遇到输出缓冲区写满
+#define TILED_OUT_BYTES_PER_PIXEL_YUV420 3
+#define TILED_OUT_BYTES_PER_PIXEL_GRAY 2
+#define TILED_OUT_MARGIN (4 * 1024)
+
+static bool tiled_encode_supported(uint16_t width, uint16_t height, v4l2_pix_fmt_t format) {
+    switch (format) {
+        case V4L2_PIX_FMT_GREY:
+            return height % TILED_BAND_ROWS_GRAY == 0;
+        case V4L2_PIX_FMT_YUYV:
+        case V4L2_PIX_FMT_RGB565:
+        case V4L2_PIX_FMT_RGB565X:
+        case V4L2_PIX_FMT_RGB24:
+            // A partial last band would need padding, such frames take the full-frame path
+            return height % TILED_BAND_ROWS_YUV420 == 0 && width % 2 == 0;
+        default:
+            return false;
+    }
+}
+
+// Returns false on failure; *started tells whether any output already reached the callback,
+// in which case the stream has been ended with the NULL call as well
+static bool encode_with_esp_new_jpeg_tiled(const uint8_t* src, uint16_t width, uint16_t height, v4l2_pix_fmt_t format,
+                                           uint8_t quality, jpg_out_cb cb, void* cb_arg, bool* started) {
+    *started = false;
+    if (quality < 1)
+        quality = 1;
+    if (quality > 100)
+        quality = 100;
+
+    int64_t start_time = esp_timer_get_time();
+    // 编码器、转换器和行带缓冲区一起占用的堆，按最低剩余量估算峰值
+    size_t free_before = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    size_t free_min = free_before;
+    bool gray = format == V4L2_PIX_FMT_GREY;
+    int band_rows = gray ? TILED_BAND_ROWS_GRAY : TILED_BAND_ROWS_YUV420;
+    int src_bpp = gray ? 1 : (format == V4L2_PIX_FMT_RGB24 ? 3 : 2);
+    int band_size = (int)width * band_rows * (gray ? 1 : 2);
+    int src_band_size = (int)width * band_rows * src_bpp;
+
+    jpeg_enc_config_t cfg = DEFAULT_JPEG_ENC_CONFIG();
+    cfg.width = width;
+    cfg.height = height;
+    cfg.src_type = gray ? JPEG_PIXEL_FORMAT_GRAY : JPEG_PIXEL_FORMAT_YCbYCr;
+    cfg.subsampling = gray ? JPEG_SUBSAMPLE_GRAY : JPEG_SUBSAMPLE_420;
+    cfg.quality = quality;
+    cfg.rotate = JPEG_ROTATE_0D;
+    cfg.task_enable = false;
+
+    jpeg_enc_handle_t h = NULL;
+    jpeg_error_t ret = jpeg_enc_open(&cfg, &h);
+    if (ret != JPEG_ERR_OK) {
+        ESP_LOGE(TAG, "jpeg_enc_open failed: %d", (int)ret);
+        return false;
+    }
+    if (jpeg_enc_get_block_size(h) != band_size) {
+        ESP_LOGW(TAG, "unexpected block size %d, expected %d", jpeg_enc_get_block_size(h), band_size);
+        jpeg_enc_close(h);
+        return false;
+    }
+
+    size_t out_cap = (size_t)width * band_rows *
+                         (gray ? TILED_OUT_BYTES_PER_PIXEL_GRAY : TILED_OUT_BYTES_PER_PIXEL_YUV420) +
+                     TILED_OUT_MARGIN;
+    uint8_t* band = (uint8_t*)jpeg_calloc_align(band_size, 16);
+    uint8_t* outbuf = (uint8_t*)malloc_psram(out_cap);
+    esp_imgfx_color_convert_handle_t convert_handle = nullptr;
+    esp_imgfx_data_t convert_input_data = {};
+    esp_imgfx_data_t convert_output_data = {};
+    size_t offset = 0;
+    bool ok = false;
+    if (!band || !outbuf) {
+        ESP_LOGE(TAG, "alloc band buffers failed");
+        goto tiled_exit;
+    }
+
+    // RGB 按行带转换为 YUYV，转换器只需要一个行带大小的输入
+    if (format == V4L2_PIX_FMT_RGB565 || format == V4L2_PIX_FMT_RGB565X || format == V4L2_PIX_FMT_RGB24) {
+        esp_imgfx_color_convert_cfg_t convert_cfg = {
+            .in_res = {.width = static_cast<int16_t>(width),
+                        .height = static_cast<int16_t>(band_rows)},
+            .in_pixel_fmt = format == V4L2_PIX_FMT_RGB24 ? ESP_IMGFX_PIXEL_FMT_RGB888
+                          : format == V4L2_PIX_FMT_RGB565 ? ESP_IMGFX_PIXEL_FMT_RGB565_LE
+                                                          : ESP_IMGFX_PIXEL_FMT_RGB565_BE,
+            .out_pixel_fmt = ESP_IMGFX_PIXEL_FMT_YUYV,
+            .color_space_std = ESP_IMGFX_COLOR_SPACE_STD_BT601,
+        };
+        if (esp_imgfx_color_convert_open(&convert_cfg, &convert_handle) != ESP_IMGFX_ERR_OK || convert_handle == nullptr) {
+            ESP_LOGE(TAG, "esp_imgfx_color_convert_open failed");
+            convert_handle = nullptr;
+            goto tiled_exit;
+        }
+        convert_input_data.data_len = static_cast<uint32_t>(src_band_size);
+        convert_output_data.data = band;
+        convert_output_data.data_len = static_cast<uint32_t>(band_size);
+    }
+
+    for (int y = 0; y < height; y += band_rows) {
+        const uint8_t* src_band = src + (size_t)y * width * src_bpp;
+        if (convert_handle) {
+            convert_input_data.data = const_cast<uint8_t*>(src_band);
+            if (esp_imgfx_color_convert_process(convert_handle, &convert_input_data, &convert_output_data) != ESP_IMGFX_ERR_OK) {
+                ESP_LOGE(TAG, "esp_imgfx_color_convert_process failed");
+                goto tiled_exit;
+            }
+        } else {
+            // GRAY 和 YUYV 直接复制到对齐的行带缓冲区
+            memcpy(band, src_band, band_size);
+        }
+
+        int out_len = 0;
+        ret = jpeg_enc_process_with_block(h, band, band_size, outbuf, (int)out_cap, &out_len);
+        if (ret < JPEG_ERR_OK) {
+            ESP_LOGE(TAG, "jpeg_enc_process_with_block failed: %d", (int)ret);
+            goto tiled_exit;
+        }
+        if (out_len > 0) {
+            cb(cb_arg, offset, outbuf, (size_t)out_len);
+            offset += out_len;
+            *started = true;
+        }
+        size_t free_now = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+        if (free_now < free_min)
+            free_min = free_now;
+    }
+    ok = true;
+
+    ESP_LOGI(TAG, "tiled encode %ux%u: %d bands, %u bytes, %ld ms, working buffers %u bytes, peak heap %u bytes",
+             width, height, height / band_rows, (unsigned)offset, (long)((esp_timer_get_time() - start_time) / 1000),
+             (unsigned)(band_size + out_cap), (unsigned)(free_before - free_min));
+
+tiled_exit:
+    // 已经输出过的流即使失败也要结束，接收方才不会一直等下去
+    if (ok || *started) {
+        cb(cb_arg, offset, NULL, 0);  // 结束信号
+    }
+    if (convert_handle) {
+        esp_imgfx_color_convert_close(convert_handle);
+    }
+    jpeg_enc_close(h);
+    if (band) {
+        jpeg_free_align(band);
+    }
+    free(outbuf);
+    return ok;
+}
+
 bool image_to_jpeg(uint8_t* src, size_t src_len, uint16_t width, uint16_t height, v4l2_pix_fmt_t format,
                    uint8_t quality, uint8_t** out, size_t* out_len) {
 #ifdef CONFIG_XIAOZHI_CAMERA_ALLOW_JPEG_INPUT
@@ -463,5 +617,16 @@ bool image_to_jpeg_cb(uint8_t* src, size_t src_len, uint16_t width, uint16_t hei
     }
     // Fallback to esp_new_jpeg
 #endif
+    if (tiled_encode_supported(width, height, format)) {
+        bool started = false;
+        if (encode_with_esp_new_jpeg_tiled(src, width, height, format, quality, cb, arg, &started)) {
+            return true;
+        }
+        if (started) {
+            // 回调已经收到部分输出和结束信号，不能再从头编码
+            return false;
+        }
+        ESP_LOGW(TAG, "tiled encode unavailable, fallback to full-frame encode");
+    }
     return encode_with_esp_new_jpeg(src, src_len, width, height, format, quality, NULL, NULL, cb, arg);
 }
@@ -32,6 +32,7 @@ extern "C"
 
     // JPEG输出回调函数类型
     // arg: 用户自定义参数, index: 当前数据索引, data: JPEG数据块, len: 数据块长度
+    // JPEG 可能分多块到达，data 为 NULL 表示结束
     // 返回: 实际处理的字节数
     typedef size_t (*jpg_out_cb)(void *arg, size_t index, const void *data, size_t len);
 
@@ -64,6 +65,9 @@ extern "C"
      * - 节省约8KB的SRAM使用（静态变量改为堆分配）
      * - 支持流式输出，无需预分配大缓冲区
      * - 通过回调函数逐块处理JPEG数据
+     * - 高度为 16 的倍数时（灰度为 8）按 MCU 行带转换和编码，每个行带的输出立即交给回调，
+     *   不分配整帧的中间缓冲区
+     * - 回调一旦收到数据，流总会以 data 为 NULL 的调用结束，编码中途失败时也是如此
      *
      * @param src       源图像数据
      * @param src_len   源图像数据长度
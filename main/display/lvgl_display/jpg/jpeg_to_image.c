@@ -262,3 +262,254 @@ esp_err_t jpeg_to_image(const uint8_t* src, size_t src_len, uint8_t** out, size_
 #endif
     return decode_with_new_jpeg(src, src_len, out, out_len, width, height, stride);
 }
+
+#if CONFIG_LV_USE_TJPGD
+#include <esp_timer.h>
+#include <string.h>
+
+#include "src/libs/tjpgd/tjpgd.h"
+
+// TJpgDec work area, the same size LVGL's own TJpgDec image decoder uses
+#define JPEG_STREAM_WORK_SIZE 4096
+// Largest reduction while decoding, 1/8 is a single DC coefficient per block
+#define JPEG_STREAM_MAX_SCALE 3
+
+typedef struct {
+    jpeg_stream_read_t read;
+    void* ctx;
+    size_t bytes_read;
+    uint16_t* out;
+    size_t out_width;
+    size_t out_height;
+    // Reduction still to apply to the blocks TJpgDec hands out (when it was built without scaling)
+    uint8_t shift;
+    // Byte of an RGB888 pixel that holds red, 0 or 2
+    uint8_t red;
+} jpeg_stream_t;
+
+static size_t jpeg_stream_input(JDEC* jd, uint8_t* buf, size_t len) {
+    jpeg_stream_t* stream = (jpeg_stream_t*)jd->device;
+    uint8_t skip[64];
+    size_t done = 0;
+    while (done < len) {
+        // A NULL buffer means skip, used for the segments TJpgDec does not need (EXIF, thumbnails)
+        uint8_t* dst = buf != NULL ? buf + done : skip;
+        size_t chunk = buf != NULL ? len - done : MIN(len - done, sizeof(skip));
+        size_t n = stream->read(stream->ctx, dst, chunk);
+        if (n == 0) {
+            break;
+        }
+        done += n;
+    }
+    stream->bytes_read += done;
+    return done;
+}
+
+#if JD_FORMAT == 0
+// Upstream TJpgDec writes RGB888 as R, G, B, LV_COLOR_FORMAT_RGB888 is B, G, R, and no macro tells which
+// one the copy bundled with LVGL writes. This 8x8 baseline JPEG of one color (R 255, G 57, B 128: only Cr set,
+// DC-only Huffman tables for both component classes) is decoded once to find out.
+static const uint8_t jpeg_order_probe[] = {
+    0xFF, 0xD8, 0xFF, 0xDB, 0x00, 0x43, 0x00, 0x08, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+    0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+    0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01,
+    0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0xFF,
+    0xC0, 0x00, 0x11, 0x08, 0x00, 0x08, 0x00, 0x08, 0x03, 0x01, 0x11, 0x00, 0x02, 0x11, 0x00, 0x03, 0x11, 0x00,
+    0xFF, 0xC4, 0x00, 0x4C, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x07, 0x01, 0x00, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x07, 0x10, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x11, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xDA, 0x00, 0x0C, 0x03, 0x01, 0x00, 0x02, 0x00, 0x03, 0x00, 0x00,
+    0x3F, 0x00, 0x01, 0xC8, 0xFF, 0xD9,
+};
+
+typedef struct {
+    size_t pos;
+    int red;
+} jpeg_probe_t;
+
+// Byte that holds red once probed, -1 before
+static int jpeg_stream_red = -1;
+
+static size_t jpeg_probe_input(JDEC* jd, uint8_t* buf, size_t len) {
+    jpeg_probe_t* probe = (jpeg_probe_t*)jd->device;
+    len = MIN(len, sizeof(jpeg_order_probe) - probe->pos);
+    if (buf != NULL) {
+        memcpy(buf, jpeg_order_probe + probe->pos, len);
+    }
+    probe->pos += len;
+    return len;
+}
+
+static int jpeg_probe_output(JDEC* jd, void* bitmap, JRECT* rect) {
+    const uint8_t* pixel = (const uint8_t*)bitmap;
+    ((jpeg_probe_t*)jd->device)->red = pixel[0] > pixel[2] ? 0 : 2;
+    return 1;
+}
+
+static uint8_t jpeg_stream_red_byte(void* work) {
+    if (jpeg_stream_red < 0) {
+        JDEC jd;
+        jpeg_probe_t probe = {.pos = 0, .red = -1};
+        if (jd_prepare(&jd, jpeg_probe_input, work, JPEG_STREAM_WORK_SIZE, &probe) == JDR_OK &&
+            jd_decomp(&jd, jpeg_probe_output, 0) == JDR_OK && probe.red >= 0) {
+            jpeg_stream_red = probe.red;
+            ESP_LOGI(TAG, "TJpgDec writes RGB888 as %s", probe.red == 0 ? "R, G, B" : "B, G, R");
+        } else {
+            // The order LVGL's RGB888 images need
+            jpeg_stream_red = 2;
+            ESP_LOGW(TAG, "TJpgDec byte order probe failed, assuming B, G, R");
+        }
+    }
+    return (uint8_t)jpeg_stream_red;
+}
+#endif  // JD_FORMAT == 0
+
+static inline void jpeg_stream_pixel(const jpeg_stream_t* stream, const uint8_t* bitmap, int index, uint32_t* r,
+                                     uint32_t* g, uint32_t* b) {
+#if JD_FORMAT == 1
+    uint16_t pixel = ((const uint16_t*)bitmap)[index];
+    *r = (pixel >> 8) & 0xF8;
+    *g = (pixel >> 3) & 0xFC;
+    *b = (pixel << 3) & 0xF8;
+#elif JD_FORMAT == 2
+    *r = *g = *b = bitmap[index];
+#else
+    const uint8_t* pixel = bitmap + index * 3;
+    *r = pixel[stream->red];
+    *g = pixel[1];
+    *b = pixel[2 - stream->red];
+#endif
+}
+
+// Converts one decoded block to RGB565, averaging 2^shift x 2^shift pixels when there is reduction left to do
+static int jpeg_stream_output(JDEC* jd, void* bitmap, JRECT* rect) {
+    jpeg_stream_t* stream = (jpeg_stream_t*)jd->device;
+    int shift = stream->shift;
+    int step = 1 << shift;
+    int src_width = rect->right - rect->left + 1;
+    int src_height = rect->bottom - rect->top + 1;
+    // Blocks start on MCU boundaries, so they divide evenly except at the right and bottom edges
+    size_t x0 = rect->left >> shift;
+    size_t y0 = rect->top >> shift;
+    int width = MIN(src_width >> shift, (int)stream->out_width - (int)x0);
+    int height = MIN(src_height >> shift, (int)stream->out_height - (int)y0);
+
+    for (int y = 0; y < height; y++) {
+        uint16_t* dst = stream->out + (y0 + y) * stream->out_width + x0;
+        for (int x = 0; x < width; x++) {
+            uint32_t r = 0, g = 0, b = 0;
+            for (int sy = 0; sy < step; sy++) {
+                int row = ((y << shift) + sy) * src_width + (x << shift);
+                for (int sx = 0; sx < step; sx++) {
+                    uint32_t pr, pg, pb;
+                    jpeg_stream_pixel(stream, (const uint8_t*)bitmap, row + sx, &pr, &pg, &pb);
+                    r += pr;
+                    g += pg;
+                    b += pb;
+                }
+            }
+            r >>= 2 * shift;
+            g >>= 2 * shift;
+            b >>= 2 * shift;
+            dst[x] = ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+        }
+    }
+    return 1;
+}
+
+esp_err_t jpeg_stream_to_image(jpeg_stream_read_t read, void* ctx, size_t max_width, size_t max_height, uint8_t** out,
+                               size_t* out_len, size_t* width, size_t* height, size_t* stride) {
+    if (read == NULL || max_width == 0 || max_height == 0 || out == NULL || out_len == NULL || width == NULL ||
+        height == NULL || stride == NULL) {
+        ESP_LOGE(TAG, "Invalid parameters");
+        return ESP_ERR_INVALID_ARG;
+    }
+    *out = NULL;
+    *out_len = 0;
+    *width = 0;
+    *height = 0;
+    *stride = 0;
+
+    int64_t start_time = esp_timer_get_time();
+    esp_err_t ret = ESP_OK;
+    jpeg_stream_t stream = {
+        .read = read,
+        .ctx = ctx,
+    };
+    JDEC jd;
+    JRESULT res;
+    uint8_t scale = 0;
+    size_t out_size = 0;
+
+    void* work = heap_caps_malloc(JPEG_STREAM_WORK_SIZE, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (work == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate memory for JPEG work area");
+        return ESP_ERR_NO_MEM;
+    }
+
+#if JD_FORMAT == 0
+    stream.red = jpeg_stream_red_byte(work);
+#endif
+    res = jd_prepare(&jd, jpeg_stream_input, work, JPEG_STREAM_WORK_SIZE, &stream);
+    if (res != JDR_OK) {
+        ESP_LOGE(TAG, "Failed to parse JPEG header: %d", (int)res);
+        ret = (res == JDR_MEM1 || res == JDR_MEM2) ? ESP_ERR_NO_MEM : ESP_ERR_INVALID_ARG;
+        goto jpeg_stream_failed;
+    }
+
+    // Reduce as long as the image still covers the box in the direction that limits it
+    while (scale < JPEG_STREAM_MAX_SCALE &&
+           ((size_t)(jd.width >> (scale + 1)) >= max_width || (size_t)(jd.height >> (scale + 1)) >= max_height)) {
+        scale++;
+    }
+    stream.out_width = jd.width >> scale;
+    stream.out_height = jd.height >> scale;
+    if (stream.out_width == 0 || stream.out_height == 0) {
+        ESP_LOGE(TAG, "Invalid JPEG size: %dx%d", jd.width, jd.height);
+        ret = ESP_ERR_INVALID_SIZE;
+        goto jpeg_stream_failed;
+    }
+
+    out_size = stream.out_width * stream.out_height * 2;
+    stream.out = (uint16_t*)heap_caps_calloc(1, out_size, MALLOC_CAP_8BIT);
+    if (stream.out == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate memory for JPEG output buffer");
+        ret = ESP_ERR_NO_MEM;
+        goto jpeg_stream_failed;
+    }
+
+#if JD_USE_SCALE
+    // TJpgDec drops the high frequency coefficients itself
+    res = jd_decomp(&jd, jpeg_stream_output, scale);
+#else
+    stream.shift = scale;
+    res = jd_decomp(&jd, jpeg_stream_output, 0);
+#endif
+    if (res != JDR_OK) {
+        ESP_LOGE(TAG, "Failed to decode JPEG: %d", (int)res);
+        ret = ESP_FAIL;
+        goto jpeg_stream_failed;
+    }
+    heap_caps_free(work);
+
+    ESP_LOGI(TAG, "Decoded %dx%d JPEG to %ux%u (1/%d) in %ld ms, read %u bytes, peak %u bytes", jd.width, jd.height,
+             (unsigned)stream.out_width, (unsigned)stream.out_height, 1 << scale,
+             (long)((esp_timer_get_time() - start_time) / 1000), (unsigned)stream.bytes_read,
+             (unsigned)(out_size + JPEG_STREAM_WORK_SIZE));
+
+    *out = (uint8_t*)stream.out;
+    *out_len = out_size;
+    *width = stream.out_width;
+    *height = stream.out_height;
+    *stride = stream.out_width * 2;
+    return ESP_OK;
+
+jpeg_stream_failed:
+    if (stream.out) {
+        heap_caps_free(stream.out);
+    }
+    heap_caps_free(work);
+    return ret;
+}
+#endif  // CONFIG_LV_USE_TJPGD
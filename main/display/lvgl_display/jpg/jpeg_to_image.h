@@ -2,6 +2,8 @@
 #ifndef CONFIG_IDF_TARGET_ESP32
 
 #include <esp_err.h>
+#include <stddef.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -55,6 +57,43 @@ extern "C" {
 esp_err_t jpeg_to_image(const uint8_t* src, size_t src_len, uint8_t** out, size_t* out_len, size_t* width,
                         size_t* height, size_t* stride);
 
+#if CONFIG_LV_USE_TJPGD
+/**
+ * @brief Reads up to `len` bytes of a JPEG bitstream into `buf`
+ *
+ * @return Number of bytes read, 0 at the end of the stream or on error
+ */
+typedef size_t (*jpeg_stream_read_t)(void* ctx, uint8_t* buf, size_t len);
+
+/**
+ * @brief Decodes a JPEG image from a stream to RGB565, downscaled to fit a box
+ *
+ * The bitstream is pulled through `read` a few hundred bytes at a time, so the compressed image is
+ * never held in memory. The image is reduced by 1/2, 1/4 or 1/8 while decoding, picking the smallest
+ * size that still covers the box (the caller scales the rest of the way), and the decoder writes
+ * RGB565 straight into the output buffer. Only baseline JPEGs are supported.
+ *
+ * @param[in] read Callback that supplies the bitstream
+ * @param[in] ctx Passed to `read`
+ * @param[in] max_width Width of the box the image is shown in, in pixels
+ * @param[in] max_height Height of the box the image is shown in, in pixels
+ * @param[out] out Same as jpeg_to_image(), free with heap_caps_free()
+ * @param[out] out_len Size of the decoded image data in bytes
+ * @param[out] width Decoded image width in pixels
+ * @param[out] height Decoded image height in pixels
+ * @param[out] stride Decoded image stride in bytes
+ *
+ * @return ESP_OK on successful decoding
+ * @return ESP_ERR_INVALID_ARG on invalid parameters or a bitstream that is not a supported JPEG
+ * @return ESP_ERR_NO_MEM on memory allocation failure
+ * @return ESP_FAIL on a truncated or corrupt bitstream
+ *
+ * @note Uses the TJpgDec copy that ships with LVGL, so it needs CONFIG_LV_USE_TJPGD.
+ */
+esp_err_t jpeg_stream_to_image(jpeg_stream_read_t read, void* ctx, size_t max_width, size_t max_height, uint8_t** out,
+                               size_t* out_len, size_t* width, size_t* height, size_t* stride);
+#endif  // CONFIG_LV_USE_TJPGD
+
 #ifdef __cplusplus
 }
 #endif
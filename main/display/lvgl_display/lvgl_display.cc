@@ -69,7 +69,56 @@ LvglDisplay::~LvglDisplay() {
     }
 }
 
+void LvglDisplay::OnDisplayCreated() {
+    DisplayLockGuard lock(this);
+    perf_monitor_.Attach(display_);
+    ui_queue_.Start([this](const LvglUiCommand& command) {
+        ApplyUiCommand(command);
+    });
+}
+
+// Runs in the LVGL task; each call finds IsApplying() true and does the work
+void LvglDisplay::ApplyUiCommand(const LvglUiCommand& command) {
+    switch (command.type) {
+    case kUiCommandStatus:
+        SetStatus(command.text.c_str());
+        break;
+    case kUiCommandNotification:
+        ShowNotification(command.text.c_str(), command.value);
+        break;
+    case kUiCommandEmotion:
+        SetEmotion(command.text.c_str());
+        break;
+    case kUiCommandChatMessage:
+        SetChatMessage(command.role.c_str(), command.text.c_str());
+        break;
+    case kUiCommandClearChat:
+        ClearChatMessages();
+        break;
+    case kUiCommandShowStandby:
+        ShowStandbyScreen();
+        break;
+    case kUiCommandHideStandby:
+        HideStandbyScreen();
+        break;
+    case kUiCommandUpdateStandby:
+        UpdateStandbyScreen();
+        break;
+    }
+}
+
+void LvglDisplay::RecordLockWait(uint32_t wait_us) {
+    // Nested locks taken while the LVGL task applies queued commands never wait
+    if (ui_queue_.IsApplying()) {
+        return;
+    }
+    perf_monitor_.RecordLockWait(wait_us, Application::GetInstance().IsMainTask());
+}
+
 void LvglDisplay::SetStatus(const char* status) {
+    if (ui_queue_.Defer(kUiCommandStatus, status)) {
+        return;
+    }
     if (!setup_ui_called_) {
         ESP_LOGW(TAG, "SetStatus('%s') called before SetupUI() - message will be lost!", status);
     }
@@ -92,6 +141,9 @@ void LvglDisplay::ShowNotification(const std::string &notification, int duration
 }
 
 void LvglDisplay::ShowNotification(const char* notification, int duration_ms) {
+    if (ui_queue_.Defer(kUiCommandNotification, notification, "", duration_ms)) {
+        return;
+    }
     if (!setup_ui_called_) {
         ESP_LOGW(TAG, "ShowNotification('%s') called before SetupUI() - message will be lost!", notification);
     }
@@ -218,6 +270,23 @@ void LvglDisplay::UpdateStatusBar(bool update_all) {
     esp_pm_lock_release(pm_lock_);
 }
 
+cJSON* LvglDisplay::GetRenderStats(bool reset) {
+    DisplayLockGuard lock(this);
+    perf_monitor_.KeepProbing();
+    cJSON* json = perf_monitor_.ToJson();
+    cJSON_AddItemToObject(json, "ui_queue", ui_queue_.ToJson());
+    AddRenderStats(json, reset);
+    if (reset) {
+        perf_monitor_.Reset();
+    }
+    return json;
+}
+
+void LvglDisplay::SetRenderOverlay(bool enabled) {
+    DisplayLockGuard lock(this);
+    perf_monitor_.SetOverlay(enabled);
+}
+
 void LvglDisplay::SetPreviewImage(std::unique_ptr<LvglImage> image) {
 }
 
@@ -232,11 +301,19 @@ void LvglDisplay::SetPowerSaveMode(bool on) {
 }
 
 bool LvglDisplay::SnapshotToJpeg(std::string& jpeg_data, int quality) {
-#if CONFIG_LV_USE_SNAPSHOT
-    DisplayLockGuard lock(this);
+    jpeg_data.clear();
+    return SnapshotToJpeg([&jpeg_data](const void* data, size_t len) {
+        jpeg_data.append(static_cast<const char*>(data), len);
+    }, quality);
+}
 
-    lv_obj_t* screen = lv_screen_active();
-    lv_draw_buf_t* draw_buffer = lv_snapshot_take(screen, LV_COLOR_FORMAT_RGB565);
+bool LvglDisplay::SnapshotToJpeg(std::function<void(const void* data, size_t len)> write, int quality) {
+#if CONFIG_LV_USE_SNAPSHOT
+    lv_draw_buf_t* draw_buffer = nullptr;
+    {
+        DisplayLockGuard lock(this);
+        draw_buffer = lv_snapshot_take(lv_screen_active(), LV_COLOR_FORMAT_RGB565);
+    }
     if (draw_buffer == nullptr) {
         ESP_LOGE(TAG, "Failed to take snapshot, draw_buffer is nullptr");
         return false;
@@ -249,22 +326,20 @@ bool LvglDisplay::SnapshotToJpeg(std::string& jpeg_data, int quality) {
         data[i] = __builtin_bswap16(data[i]);
     }
 
-    // Clear output string and use callback version to avoid pre-allocating large memory blocks
-    jpeg_data.clear();
-
-    // Use callback-based JPEG encoder to further save memory
+    // The snapshot is a private copy, so the screen keeps refreshing while it is encoded
     bool ret = image_to_jpeg_cb((uint8_t*)draw_buffer->data, draw_buffer->data_size, draw_buffer->header.w, draw_buffer->header.h, V4L2_PIX_FMT_RGB565, quality,
         [](void *arg, size_t index, const void *data, size_t len) -> size_t {
-        std::string* output = static_cast<std::string*>(arg);
+        // The encoder ends with an empty call
         if (data && len > 0) {
-            output->append(static_cast<const char*>(data), len);
+            (*static_cast<std::function<void(const void*, size_t)>*>(arg))(data, len);
         }
         return len;
-    }, &jpeg_data);
+    }, &write);
     if (!ret) {
         ESP_LOGE(TAG, "Failed to convert image to JPEG");
     }
 
+    DisplayLockGuard lock(this);
     lv_draw_buf_destroy(draw_buffer);
     return ret;
 #else
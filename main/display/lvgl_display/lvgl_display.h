@@ -3,6 +3,8 @@
 
 #include "display.h"
 #include "lvgl_image.h"
+#include "lvgl_perf_monitor.h"
+#include "lvgl_ui_queue.h"
 
 #include <lvgl.h>
 #include <esp_timer.h>
@@ -11,6 +13,7 @@
 
 #include <string>
 #include <chrono>
+#include <functional>
 
 class LvglDisplay : public Display {
 public:
@@ -21,9 +24,17 @@ public:
     virtual void ShowNotification(const char* notification, int duration_ms = 3000);
     virtual void ShowNotification(const std::string &notification, int duration_ms = 3000);
     virtual void SetPreviewImage(std::unique_ptr<LvglImage> image);
+    // Box the preview image is fitted into, JPEG previews are decoded down to about this size
+    virtual void GetPreviewImageBox(int& width, int& height) { width = width_; height = height_; }
     virtual void UpdateStatusBar(bool update_all = false);
     virtual void SetPowerSaveMode(bool on);
     virtual bool SnapshotToJpeg(std::string& jpeg_data, int quality = 80);
+    // Hands the JPEG to `write` piece by piece as the encoder produces it. The display is only locked
+    // while the screen is captured, encoding runs unlocked in the calling task.
+    virtual bool SnapshotToJpeg(std::function<void(const void* data, size_t len)> write, int quality = 80);
+    virtual uint32_t GetFlushedPixels() { return perf_monitor_.flushed_pixels(); }
+    cJSON* GetRenderStats(bool reset);
+    void SetRenderOverlay(bool enabled);
 
 protected:
     esp_pm_lock_handle_t pm_lock_ = nullptr;
@@ -43,10 +54,19 @@ protected:
 
     std::chrono::system_clock::time_point last_status_update_time_;
     esp_timer_handle_t notification_timer_ = nullptr;
+    LvglPerfMonitor perf_monitor_;
+    LvglUiQueue ui_queue_;
+
+    // Call once display_ is created: attaches the perf monitor and starts the UI queue
+    void OnDisplayCreated();
+    void ApplyUiCommand(const LvglUiCommand& command);
+    // Subclasses add their own sections to GetRenderStats(), called with the lock held
+    virtual void AddRenderStats(cJSON* json, bool reset) {}
 
     friend class DisplayLockGuard;
     virtual bool Lock(int timeout_ms = 0) = 0;
     virtual void Unlock() = 0;
+    virtual void RecordLockWait(uint32_t wait_us);
 };
 
 
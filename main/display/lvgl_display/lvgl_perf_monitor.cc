@@ -0,0 +1,268 @@
+#include "lvgl_perf_monitor.h"
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <esp_heap_caps.h>
+#include <algorithm>
+#include <cstdio>
+
+#define TAG "LvglPerfMonitor"
+
+#define LVGL_PERF_OVERLAY_PERIOD_MS 1000
+#define LVGL_PERF_PROBE_PERIOD_MS 20
+// How long the probe keeps running after the stats were read
+#define LVGL_PERF_PROBE_WINDOW_MS 60000
+
+void LvglPerfHistogram::Add(uint32_t value) {
+    int bucket = value == 0 ? 0 : 32 - __builtin_clz(value);
+    buckets[std::min(bucket, LVGL_PERF_HISTOGRAM_BUCKETS - 1)]++;
+    count++;
+    sum += value;
+    max = std::max(max, value);
+}
+
+uint32_t LvglPerfHistogram::Percentile(int percent) const {
+    if (count == 0) {
+        return 0;
+    }
+    // Rank of the sample, rounded up so p100 is the last one
+    uint64_t rank = ((uint64_t)count * percent + 99) / 100;
+    uint64_t seen = 0;
+    for (int i = 0; i < LVGL_PERF_HISTOGRAM_BUCKETS; i++) {
+        seen += buckets[i];
+        if (seen >= rank && seen > 0) {
+            if (i == 0) {
+                return 0;
+            }
+            // The top bucket is open ended, max bounds it
+            return i == LVGL_PERF_HISTOGRAM_BUCKETS - 1 ? max : std::min<uint32_t>(max, (1u << i) - 1);
+        }
+    }
+    return max;
+}
+
+cJSON* LvglPerfHistogram::ToJson() const {
+    cJSON* json = cJSON_CreateObject();
+    cJSON_AddNumberToObject(json, "count", count);
+    cJSON_AddNumberToObject(json, "avg", count > 0 ? (double)(sum / count) : 0);
+    cJSON_AddNumberToObject(json, "p50", Percentile(50));
+    cJSON_AddNumberToObject(json, "p90", Percentile(90));
+    cJSON_AddNumberToObject(json, "p99", Percentile(99));
+    cJSON_AddNumberToObject(json, "max", max);
+    // Trailing empty buckets are left out; bucket i holds values below 2^i
+    int used = LVGL_PERF_HISTOGRAM_BUCKETS;
+    while (used > 0 && buckets[used - 1] == 0) {
+        used--;
+    }
+    cJSON* array = cJSON_CreateArray();
+    for (int i = 0; i < used; i++) {
+        cJSON_AddItemToArray(array, cJSON_CreateNumber(buckets[i]));
+    }
+    cJSON_AddItemToObject(json, "log2_buckets", array);
+    return json;
+}
+
+LvglPerfMonitor::~LvglPerfMonitor() {
+    if (probe_timer_ != nullptr) {
+        lv_timer_delete(probe_timer_);
+    }
+    if (overlay_timer_ != nullptr) {
+        lv_timer_delete(overlay_timer_);
+    }
+    if (overlay_label_ != nullptr) {
+        lv_obj_delete(overlay_label_);
+    }
+}
+
+void LvglPerfMonitor::Attach(lv_display_t* display) {
+    since_us_ = esp_timer_get_time();
+    const lv_event_code_t events[] = {
+        LV_EVENT_RENDER_START,
+        LV_EVENT_RENDER_READY,
+        LV_EVENT_FLUSH_START,
+        LV_EVENT_FLUSH_FINISH,
+        LV_EVENT_FLUSH_WAIT_START,
+        LV_EVENT_FLUSH_WAIT_FINISH,
+    };
+    for (auto event : events) {
+        lv_display_add_event_cb(display, OnDisplayEvent, event, this);
+    }
+
+    // A 20 ms timer keeps the LVGL task from sleeping, so it only runs while the stats are in use
+    probe_timer_ = lv_timer_create(OnProbeTimer, LVGL_PERF_PROBE_PERIOD_MS, this);
+    lv_timer_pause(probe_timer_);
+}
+
+// Runs in the LVGL timer handler, with the display lock held
+void LvglPerfMonitor::OnProbeTimer(lv_timer_t* timer) {
+    auto monitor = static_cast<LvglPerfMonitor*>(lv_timer_get_user_data(timer));
+    int64_t now_us = esp_timer_get_time();
+    if (monitor->overlay_timer_ == nullptr && now_us >= monitor->probe_until_us_) {
+        lv_timer_pause(timer);
+        monitor->probing_ = false;
+        return;
+    }
+    if (monitor->probe_last_us_ != 0) {
+        int64_t late_us = now_us - monitor->probe_last_us_ - LVGL_PERF_PROBE_PERIOD_MS * 1000;
+        monitor->timer_latency_us_.Add(std::max<int64_t>(0, late_us));
+    }
+    monitor->probe_last_us_ = now_us;
+}
+
+void LvglPerfMonitor::KeepProbing() {
+    probe_until_us_ = esp_timer_get_time() + LVGL_PERF_PROBE_WINDOW_MS * 1000LL;
+    if (probe_timer_ == nullptr || probing_) {
+        return;
+    }
+    // The time spent paused is not latency, start measuring from the next tick
+    probing_ = true;
+    probe_last_us_ = 0;
+    lv_timer_reset(probe_timer_);
+    lv_timer_resume(probe_timer_);
+}
+
+// Runs in the LVGL task, with the display lock held
+void LvglPerfMonitor::OnDisplayEvent(lv_event_t* e) {
+    auto monitor = static_cast<LvglPerfMonitor*>(lv_event_get_user_data(e));
+    int64_t now_us = esp_timer_get_time();
+
+    switch (lv_event_get_code(e)) {
+    case LV_EVENT_RENDER_START:
+        if (monitor->last_frame_start_us_ != 0) {
+            monitor->frame_interval_us_.Add(now_us - monitor->last_frame_start_us_);
+        }
+        monitor->last_frame_start_us_ = now_us;
+        monitor->frame_start_us_ = now_us;
+        monitor->frame_flush_us_ = 0;
+        monitor->frame_pixels_ = 0;
+        break;
+    case LV_EVENT_RENDER_READY: {
+        if (monitor->frame_start_us_ == 0) {
+            break;
+        }
+        uint32_t frame_us = now_us - monitor->frame_start_us_;
+        monitor->render_us_.Add(frame_us - std::min(frame_us, monitor->frame_flush_us_));
+        monitor->flush_us_.Add(monitor->frame_flush_us_);
+        monitor->frame_pixels_hist_.Add(monitor->frame_pixels_);
+        monitor->frames_++;
+        monitor->frame_start_us_ = 0;
+        break;
+    }
+    case LV_EVENT_FLUSH_START: {
+        auto area = static_cast<const lv_area_t*>(lv_event_get_param(e));
+        uint32_t pixels = lv_area_get_size(area);
+        monitor->frame_pixels_ += pixels;
+        monitor->flushed_pixels_.fetch_add(pixels, std::memory_order_relaxed);
+        monitor->flush_start_us_ = now_us;
+        break;
+    }
+    case LV_EVENT_FLUSH_WAIT_START:
+        monitor->flush_start_us_ = now_us;
+        break;
+    case LV_EVENT_FLUSH_FINISH:
+    case LV_EVENT_FLUSH_WAIT_FINISH:
+        if (monitor->flush_start_us_ != 0) {
+            monitor->frame_flush_us_ += now_us - monitor->flush_start_us_;
+            monitor->flush_start_us_ = 0;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+void LvglPerfMonitor::RecordLockWait(uint32_t wait_us, bool main_task) {
+    lock_wait_us_.Add(wait_us);
+    if (main_task) {
+        main_task_lock_wait_us_.Add(wait_us);
+    }
+}
+
+void LvglPerfMonitor::RecordChatMessage(uint32_t elapsed_us, int32_t heap_bytes) {
+    chat_message_us_.Add(elapsed_us);
+    // Freed memory counts as zero, the histogram only tracks growth; its max is the largest growth
+    chat_message_heap_bytes_.Add(std::max<int32_t>(0, heap_bytes));
+}
+
+void LvglPerfMonitor::Reset() {
+    since_us_ = esp_timer_get_time();
+    frames_ = 0;
+    overlay_frames_ = 0;
+    last_frame_start_us_ = 0;
+    render_us_ = LvglPerfHistogram();
+    flush_us_ = LvglPerfHistogram();
+    frame_pixels_hist_ = LvglPerfHistogram();
+    frame_interval_us_ = LvglPerfHistogram();
+    lock_wait_us_ = LvglPerfHistogram();
+    main_task_lock_wait_us_ = LvglPerfHistogram();
+    timer_latency_us_ = LvglPerfHistogram();
+    probe_last_us_ = 0;
+    chat_message_us_ = LvglPerfHistogram();
+    chat_message_heap_bytes_ = LvglPerfHistogram();
+}
+
+cJSON* LvglPerfMonitor::ToJson() const {
+    int64_t elapsed_us = std::max<int64_t>(1, esp_timer_get_time() - since_us_);
+    cJSON* json = cJSON_CreateObject();
+    cJSON_AddNumberToObject(json, "elapsed_ms", elapsed_us / 1000);
+    cJSON_AddNumberToObject(json, "frames", frames_);
+    cJSON_AddNumberToObject(json, "fps", frames_ * 1000000.0 / elapsed_us);
+    cJSON_AddNumberToObject(json, "flushed_pixels", flushed_pixels());
+    cJSON_AddItemToObject(json, "render_us", render_us_.ToJson());
+    cJSON_AddItemToObject(json, "flush_us", flush_us_.ToJson());
+    cJSON_AddItemToObject(json, "frame_pixels", frame_pixels_hist_.ToJson());
+    cJSON_AddItemToObject(json, "frame_interval_us", frame_interval_us_.ToJson());
+    cJSON_AddItemToObject(json, "lock_wait_us", lock_wait_us_.ToJson());
+    cJSON_AddItemToObject(json, "main_task_lock_wait_us", main_task_lock_wait_us_.ToJson());
+    cJSON_AddItemToObject(json, "timer_latency_us", timer_latency_us_.ToJson());
+    cJSON_AddItemToObject(json, "chat_message_us", chat_message_us_.ToJson());
+    cJSON_AddItemToObject(json, "chat_message_heap_bytes", chat_message_heap_bytes_.ToJson());
+    // Internal heap low-water mark since boot, LVGL allocates from the system heap
+    cJSON_AddNumberToObject(json, "heap_free_min", heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT));
+    return json;
+}
+
+void LvglPerfMonitor::SetOverlay(bool enabled) {
+    ESP_LOGI(TAG, "Overlay %s", enabled ? "on" : "off");
+    if (!enabled) {
+        if (overlay_timer_ != nullptr) {
+            lv_timer_delete(overlay_timer_);
+            overlay_timer_ = nullptr;
+        }
+        if (overlay_label_ != nullptr) {
+            lv_obj_delete(overlay_label_);
+            overlay_label_ = nullptr;
+        }
+        return;
+    }
+    if (overlay_label_ != nullptr) {
+        return;
+    }
+
+    // The overlay redraws itself once a second, so an idle screen shows about 1 fps
+    overlay_label_ = lv_label_create(lv_layer_top());
+    lv_obj_set_style_bg_opa(overlay_label_, LV_OPA_70, 0);
+    lv_obj_set_style_bg_color(overlay_label_, lv_color_black(), 0);
+    lv_obj_set_style_text_color(overlay_label_, lv_color_white(), 0);
+    lv_obj_set_style_pad_all(overlay_label_, 2, 0);
+    lv_obj_align(overlay_label_, LV_ALIGN_BOTTOM_LEFT, 0, 0);
+    overlay_frames_ = frames_;
+    KeepProbing();
+    overlay_timer_ = lv_timer_create([](lv_timer_t* timer) {
+        static_cast<LvglPerfMonitor*>(lv_timer_get_user_data(timer))->UpdateOverlay();
+    }, LVGL_PERF_OVERLAY_PERIOD_MS, this);
+    UpdateOverlay();
+}
+
+// Runs in the LVGL timer handler, with the display lock held
+void LvglPerfMonitor::UpdateOverlay() {
+    char text[96];
+    snprintf(text, sizeof(text), "%lu fps r %lu f %lu ms %lu px lk %lu ms",
+        (unsigned long)(frames_ - overlay_frames_),
+        (unsigned long)(render_us_.Percentile(90) / 1000),
+        (unsigned long)(flush_us_.Percentile(90) / 1000),
+        (unsigned long)frame_pixels_hist_.Percentile(90),
+        (unsigned long)(lock_wait_us_.max / 1000));
+    overlay_frames_ = frames_;
+    lv_label_set_text(overlay_label_, text);
+}
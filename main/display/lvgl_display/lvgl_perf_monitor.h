@@ -0,0 +1,86 @@
+#ifndef LVGL_PERF_MONITOR_H
+#define LVGL_PERF_MONITOR_H
+
+#include <lvgl.h>
+#include <cJSON.h>
+
+#include <atomic>
+#include <cstdint>
+
+#define LVGL_PERF_HISTOGRAM_BUCKETS 24
+
+// Log2 buckets: bucket 0 counts zeros, bucket i counts values in [2^(i-1), 2^i)
+struct LvglPerfHistogram {
+    uint32_t buckets[LVGL_PERF_HISTOGRAM_BUCKETS] = {};
+    uint32_t count = 0;
+    uint32_t max = 0;
+    uint64_t sum = 0;
+
+    void Add(uint32_t value);
+    // Upper bound of the bucket that holds the given percentile
+    uint32_t Percentile(int percent) const;
+    cJSON* ToJson() const;
+};
+
+/*
+ * Per-frame render and flush statistics from the LVGL display events, plus the time
+ * callers wait for the display lock.
+ *
+ * A frame is one refresh with dirty areas (RENDER_START to RENDER_READY). Flush time is
+ * the time spent in the flush callback and waiting for the panel to take the previous
+ * buffer; render time is the rest of the frame. Everything except the pixel counter is
+ * only touched with the display lock held (the LVGL task holds it while refreshing).
+ */
+class LvglPerfMonitor {
+public:
+    ~LvglPerfMonitor();
+
+    void Attach(lv_display_t* display);
+    void RecordLockWait(uint32_t wait_us, bool main_task);
+    // Time spent in one SetChatMessage() call and the heap it took (negative if freed)
+    void RecordChatMessage(uint32_t elapsed_us, int32_t heap_bytes);
+    void Reset();
+    cJSON* ToJson() const;
+    // One-line summary drawn on the top layer, refreshed every second
+    void SetOverlay(bool enabled);
+    // Run the timer latency probe for a while, it is paused when nobody reads the stats
+    void KeepProbing();
+    // Pixels sent to the panel since boot, readable without the lock
+    uint32_t flushed_pixels() const { return flushed_pixels_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint32_t> flushed_pixels_ = 0;
+
+    int64_t since_us_ = 0;
+    uint32_t frames_ = 0;
+    int64_t frame_start_us_ = 0;
+    int64_t last_frame_start_us_ = 0;
+    int64_t flush_start_us_ = 0;
+    uint32_t frame_flush_us_ = 0;
+    uint32_t frame_pixels_ = 0;
+
+    LvglPerfHistogram render_us_;
+    LvglPerfHistogram flush_us_;
+    LvglPerfHistogram frame_pixels_hist_;
+    LvglPerfHistogram frame_interval_us_;
+    LvglPerfHistogram lock_wait_us_;
+    LvglPerfHistogram main_task_lock_wait_us_;
+    // How late a periodic probe timer fires, i.e. how long lv_timer_handler() runs keep it waiting
+    LvglPerfHistogram timer_latency_us_;
+    lv_timer_t* probe_timer_ = nullptr;
+    bool probing_ = false;
+    int64_t probe_last_us_ = 0;
+    int64_t probe_until_us_ = 0;
+    LvglPerfHistogram chat_message_us_;
+    LvglPerfHistogram chat_message_heap_bytes_;
+
+    lv_obj_t* overlay_label_ = nullptr;
+    lv_timer_t* overlay_timer_ = nullptr;
+    uint32_t overlay_frames_ = 0;
+
+    static void OnDisplayEvent(lv_event_t* e);
+    static void OnProbeTimer(lv_timer_t* timer);
+    void UpdateOverlay();
+};
+
+#endif // LVGL_PERF_MONITOR_H
@@ -0,0 +1,83 @@
+#include "lvgl_text_field.h"
+
+#include <esp_log.h>
+#include <algorithm>
+#include <cstring>
+
+#define TAG "LvglTextField"
+
+void LvglTextField::Attach(lv_obj_t* label) {
+    label_ = label;
+    cached_ = false;
+}
+
+bool LvglTextField::SetText(const char* text) {
+    if (label_ == nullptr) {
+        return false;
+    }
+    if (cached_ && strcmp(text_, text) == 0) {
+        return false;
+    }
+    lv_label_set_text(label_, text);
+    // Text too long for the cache is set every time, as before
+    size_t length = strlen(text);
+    cached_ = length < sizeof(text_);
+    if (cached_) {
+        memcpy(text_, text, length + 1);
+    }
+    return true;
+}
+
+lv_obj_t* LvglDigitField::Create(lv_obj_t* parent, const lv_font_t* font, lv_color_t color, const char* text) {
+    count_ = std::min<int>(strlen(text), LVGL_DIGIT_FIELD_MAX_CELLS);
+
+    uint16_t digit_width = 0;
+    for (char c = '0'; c <= '9'; c++) {
+        digit_width = std::max(digit_width, lv_font_get_glyph_width(font, c, 0));
+    }
+    int32_t height = lv_font_get_line_height(font);
+
+    // Bare container: no theme padding, border or scrolling, cells are placed by hand
+    row_ = lv_obj_create(parent);
+    lv_obj_remove_style_all(row_);
+    lv_obj_remove_flag(row_, LV_OBJ_FLAG_SCROLLABLE);
+    lv_obj_remove_flag(row_, LV_OBJ_FLAG_CLICKABLE);
+
+    int32_t x = 0;
+    for (int i = 0; i < count_; i++) {
+        char c = text[i];
+        int32_t width = (c >= '0' && c <= '9') ? digit_width : lv_font_get_glyph_width(font, c, 0);
+        char cell_text[2] = {c, '\0'};
+        cells_[i] = lv_label_create(row_);
+        lv_obj_set_style_text_font(cells_[i], font, 0);
+        lv_obj_set_style_text_color(cells_[i], color, 0);
+        lv_obj_set_style_text_align(cells_[i], LV_TEXT_ALIGN_CENTER, 0);
+        lv_obj_set_size(cells_[i], width, height);
+        lv_obj_set_pos(cells_[i], x, 0);
+        lv_label_set_text(cells_[i], cell_text);
+        text_[i] = c;
+        x += width;
+    }
+    text_[count_] = '\0';
+    lv_obj_set_size(row_, x, height);
+    ESP_LOGD(TAG, "Created %d cells, %ldx%ld", count_, (long)x, (long)height);
+    return row_;
+}
+
+bool LvglDigitField::SetText(const char* text) {
+    bool changed = false;
+    bool ended = false;
+    for (int i = 0; i < count_; i++) {
+        // Cells past the end of a shorter text are blanked
+        ended = ended || text[i] == '\0';
+        char c = ended ? ' ' : text[i];
+        if (c == text_[i]) {
+            continue;
+        }
+        char cell_text[2] = {c, '\0'};
+        lv_label_set_text(cells_[i], cell_text);
+        text_[i] = c;
+        changed = true;
+    }
+    return changed;
+}
@@ -0,0 +1,48 @@
+#ifndef LVGL_TEXT_FIELD_H
+#define LVGL_TEXT_FIELD_H
+
+#include <lvgl.h>
+
+#define LVGL_TEXT_FIELD_MAX_LENGTH 48
+#define LVGL_DIGIT_FIELD_MAX_CELLS 12
+
+/*
+ * Label wrapper that remembers the text it set last. Setting the same text again is a
+ * strcmp instead of a re-layout and an invalidation of the label area.
+ *
+ * Must be used under the display lock, like the label itself.
+ */
+class LvglTextField {
+public:
+    void Attach(lv_obj_t* label);
+    // Returns true if the label was changed
+    bool SetText(const char* text);
+    lv_obj_t* obj() const { return label_; }
+
+private:
+    lv_obj_t* label_ = nullptr;
+    char text_[LVGL_TEXT_FIELD_MAX_LENGTH] = {};
+    bool cached_ = false;
+};
+
+/*
+ * A row of one-character labels with fixed widths, for clocks and counters.
+ * Going from "12:34:56" to "12:34:57" redraws one cell, and a narrow digit replacing a
+ * wide one does not move the others. Every digit cell is as wide as the widest digit.
+ */
+class LvglDigitField {
+public:
+    // `text` sets the number of cells and the initial content, single byte characters only
+    lv_obj_t* Create(lv_obj_t* parent, const lv_font_t* font, lv_color_t color, const char* text);
+    // Returns true if any cell was changed
+    bool SetText(const char* text);
+    lv_obj_t* obj() const { return row_; }
+
+private:
+    lv_obj_t* row_ = nullptr;
+    lv_obj_t* cells_[LVGL_DIGIT_FIELD_MAX_CELLS] = {};
+    char text_[LVGL_DIGIT_FIELD_MAX_CELLS + 1] = {};
+    int count_ = 0;
+};
+
+#endif // LVGL_TEXT_FIELD_H
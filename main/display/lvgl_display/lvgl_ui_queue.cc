@@ -0,0 +1,168 @@
+#include "lvgl_ui_queue.h"
+
+#include <esp_log.h>
+#include <esp_lvgl_port.h>
+#include <algorithm>
+
+#define TAG "LvglUiQueue"
+
+// How often the LVGL task looks for queued commands while there are any, about one frame
+#define LVGL_UI_QUEUE_PERIOD_MS 20
+// Retry delay when the drain timer could not be resumed because a frame holds the LVGL lock
+#define LVGL_UI_QUEUE_WAKE_RETRY_US 5000
+// Commands waiting at most; the coalesced kinds take one entry each, the rest are chat messages
+#define LVGL_UI_QUEUE_MAX_COMMANDS 32
+
+// Commands in the same group replace each other, -1 means no coalescing
+static int CoalesceGroup(LvglUiCommandType type) {
+    switch (type) {
+    case kUiCommandStatus:
+    case kUiCommandNotification:
+    case kUiCommandEmotion:
+    case kUiCommandUpdateStandby:
+        return type;
+    case kUiCommandShowStandby:
+    case kUiCommandHideStandby:
+        return kUiCommandShowStandby;
+    default:
+        return -1;
+    }
+}
+
+LvglUiQueue::~LvglUiQueue() {
+    if (wake_timer_ != nullptr) {
+        esp_timer_stop(wake_timer_);
+        esp_timer_delete(wake_timer_);
+    }
+    if (timer_ != nullptr) {
+        lv_timer_delete(timer_);
+    }
+}
+
+void LvglUiQueue::Start(Applier applier) {
+    applier_ = applier;
+    timer_ = lv_timer_create([](lv_timer_t* timer) {
+        static_cast<LvglUiQueue*>(lv_timer_get_user_data(timer))->Drain();
+    }, LVGL_UI_QUEUE_PERIOD_MS, this);
+    lv_timer_pause(timer_);
+
+    esp_timer_create_args_t wake_timer_args = {
+        .callback = [](void* arg) {
+            static_cast<LvglUiQueue*>(arg)->Wake();
+        },
+        .arg = this,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "ui_queue_wake",
+        .skip_unhandled_events = true,
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&wake_timer_args, &wake_timer_));
+    started_ = true;
+    ESP_LOGI(TAG, "Display calls from other tasks are now queued");
+}
+
+bool LvglUiQueue::Defer(LvglUiCommandType type, const char* text, const char* role, int value) {
+    if (!started_ || IsApplying()) {
+        return false;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    int group = CoalesceGroup(type);
+    size_t size = commands_.size();
+    if (group >= 0) {
+        // Drop the stale one and append, so the new command keeps its place relative to the others
+        commands_.erase(std::remove_if(commands_.begin(), commands_.end(), [group](const LvglUiCommand& command) {
+            return CoalesceGroup(command.type) == group;
+        }), commands_.end());
+    } else if (type == kUiCommandClearChat) {
+        commands_.erase(std::remove_if(commands_.begin(), commands_.end(), [](const LvglUiCommand& command) {
+            return command.type == kUiCommandChatMessage || command.type == kUiCommandClearChat;
+        }), commands_.end());
+    }
+    stats_.coalesced += size - commands_.size();
+    bool dropped = false;
+    if (commands_.size() >= LVGL_UI_QUEUE_MAX_COMMANDS) {
+        // Only chat messages can fill the queue, the oldest one goes
+        auto oldest = std::find_if(commands_.begin(), commands_.end(), [](const LvglUiCommand& command) {
+            return command.type == kUiCommandChatMessage;
+        });
+        if (oldest != commands_.end()) {
+            commands_.erase(oldest);
+            stats_.dropped++;
+            dropped = true;
+        }
+    }
+    commands_.push_back(LvglUiCommand{type, text != nullptr ? text : "", role != nullptr ? role : "", value});
+    stats_.posted++;
+    stats_.max_depth = std::max<uint32_t>(stats_.max_depth, commands_.size());
+    bool wake = idle_;
+    idle_ = false;
+    lock.unlock();
+
+    if (dropped) {
+        ESP_LOGW(TAG, "Queue full, dropped the oldest chat message");
+    }
+    if (wake) {
+        Wake();
+    }
+    return true;
+}
+
+void LvglUiQueue::Flush() {
+    // While applying, the commands still queued were posted after the one being applied
+    if (!started_ || IsApplying()) {
+        return;
+    }
+    Drain();
+}
+
+// Resumes the drain timer from any task. The LVGL lock is only tried, not waited for: if a
+// frame is rendering, the wake is retried from the esp_timer task a little later.
+void LvglUiQueue::Wake() {
+    if (!lvgl_port_lock(1)) {
+        esp_timer_start_once(wake_timer_, LVGL_UI_QUEUE_WAKE_RETRY_US);
+        return;
+    }
+    lv_timer_resume(timer_);
+    lv_timer_ready(timer_);
+    lvgl_port_unlock();
+    // The LVGL task may be sleeping with no timer due, get it to run the drain now
+    lvgl_port_task_wake(LVGL_PORT_EVENT_USER, nullptr);
+}
+
+// Runs with the display lock held, in the LVGL task or in the task calling Flush()
+void LvglUiQueue::Drain() {
+    std::deque<LvglUiCommand> commands;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (commands_.empty()) {
+            // The next Defer() resumes the timer
+            idle_ = true;
+            lv_timer_pause(timer_);
+            return;
+        }
+        commands.swap(commands_);
+        stats_.applied += commands.size();
+    }
+
+    applying_task_ = xTaskGetCurrentTaskHandle();
+    for (auto& command : commands) {
+        applier_(command);
+    }
+    applying_task_ = nullptr;
+}
+
+LvglUiQueueStats LvglUiQueue::GetStats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+cJSON* LvglUiQueue::ToJson() {
+    auto stats = GetStats();
+    cJSON* json = cJSON_CreateObject();
+    cJSON_AddNumberToObject(json, "posted", stats.posted);
+    cJSON_AddNumberToObject(json, "coalesced", stats.coalesced);
+    cJSON_AddNumberToObject(json, "applied", stats.applied);
+    cJSON_AddNumberToObject(json, "dropped", stats.dropped);
+    cJSON_AddNumberToObject(json, "max_depth", stats.max_depth);
+    return json;
+}
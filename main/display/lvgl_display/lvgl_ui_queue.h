@@ -0,0 +1,94 @@
+#ifndef LVGL_UI_QUEUE_H
+#define LVGL_UI_QUEUE_H
+
+#include <lvgl.h>
+#include <cJSON.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_timer.h>
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+
+enum LvglUiCommandType {
+    kUiCommandStatus,           // Coalesced, the latest one wins
+    kUiCommandNotification,     // Coalesced
+    kUiCommandEmotion,          // Coalesced
+    kUiCommandChatMessage,      // Kept in order, dropped by a later clear
+    kUiCommandClearChat,
+    kUiCommandShowStandby,      // Show and hide coalesce with each other
+    kUiCommandHideStandby,
+    kUiCommandUpdateStandby,    // Coalesced
+};
+
+struct LvglUiCommand {
+    LvglUiCommandType type;
+    std::string text;
+    std::string role;
+    int value = 0;
+};
+
+struct LvglUiQueueStats {
+    uint32_t posted = 0;
+    uint32_t coalesced = 0;
+    uint32_t applied = 0;
+    uint32_t dropped = 0;
+    uint32_t max_depth = 0;
+};
+
+/*
+ * Display calls from other tasks are queued here and applied by the LVGL task between
+ * frames, so callers never wait for the display lock while a frame renders.
+ *
+ * A display method starts with `if (ui_queue_.Defer(...)) return;`. From another task
+ * the call is queued and returns at once; when the LVGL task applies the command it
+ * calls the same method again, Defer returns false and the method does the work.
+ * Before Start(), Defer always returns false and calls stay synchronous.
+ *
+ * Display calls that are not queued (SetPreviewImage, SetTheme, ...) call Flush() once
+ * they hold the lock, so they never overtake commands queued before them. UpdateStatusBar
+ * does not: it only touches the mute, battery and network icons, which no command changes,
+ * and its clock goes through SetStatus.
+ *
+ * Coalesced commands keep at most one entry per kind, only chat messages pile up. Past
+ * LVGL_UI_QUEUE_MAX_COMMANDS the oldest chat message is dropped.
+ *
+ * The drain timer is paused while the queue is empty; the command that makes it non-empty
+ * resumes it, so an idle screen does not wake the LVGL task to poll.
+ */
+class LvglUiQueue {
+public:
+    using Applier = std::function<void(const LvglUiCommand&)>;
+
+    ~LvglUiQueue();
+
+    // Call with the display lock held
+    void Start(Applier applier);
+    // Returns true if the command was queued, false if the caller should apply it now
+    bool Defer(LvglUiCommandType type, const char* text = "", const char* role = "", int value = 0);
+    // Call with the display lock held: applies the queued commands now, in the calling task
+    void Flush();
+    // True in the task applying queued commands, normally the LVGL task
+    bool IsApplying() const { return applying_task_.load() == xTaskGetCurrentTaskHandle(); }
+    LvglUiQueueStats GetStats();
+    cJSON* ToJson();
+
+private:
+    std::mutex mutex_;
+    std::deque<LvglUiCommand> commands_;
+    LvglUiQueueStats stats_;
+    Applier applier_;
+    lv_timer_t* timer_ = nullptr;
+    bool idle_ = true;                          // Timer paused, guarded by mutex_
+    esp_timer_handle_t wake_timer_ = nullptr;   // Retries Wake() while the LVGL lock is busy
+    std::atomic<bool> started_ = false;
+    std::atomic<TaskHandle_t> applying_task_ = nullptr;
+
+    void Drain();
+    void Wake();
+};
+
+#endif // LVGL_UI_QUEUE_H
@@ -77,6 +77,7 @@ OledDisplay::OledDisplay(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_handl
         ESP_LOGE(TAG, "Failed to add display");
         return;
     }
+    OnDisplayCreated();
 
     // Note: SetupUI() should be called by Application::Initialize(), not in constructor
     // to ensure lvgl objects are created after the display is fully initialized.
@@ -146,6 +147,9 @@ void OledDisplay::Unlock() {
 }
 
 void OledDisplay::SetChatMessage(const char* role, const char* content) {
+    if (ui_queue_.Defer(kUiCommandChatMessage, content, role)) {
+        return;
+    }
     DisplayLockGuard lock(this);
     if (chat_message_label_ == nullptr) {
         return;
@@ -393,6 +397,9 @@ void OledDisplay::SetupUI_128x32() {
 }
 
 void OledDisplay::SetEmotion(const char* emotion) {
+    if (ui_queue_.Defer(kUiCommandEmotion, emotion)) {
+        return;
+    }
     const char* utf8 = font_awesome_get_utf8(emotion);
     DisplayLockGuard lock(this);
     if (emotion_label_ == nullptr) {
@@ -407,6 +414,7 @@ void OledDisplay::SetEmotion(const char* emotion) {
 
 void OledDisplay::SetTheme(Theme* theme) {
     DisplayLockGuard lock(this);
+    ui_queue_.Flush();
 
     auto lvgl_theme = static_cast<LvglTheme*>(theme);
     auto text_font = lvgl_theme->text_font()->font();
@@ -462,12 +470,17 @@ void OledDisplay::SetupStandbyScreen() {
     ESP_LOGI(TAG, "weekday_label_ created: %p", weekday_label_);
 
     // Time label (center, largest font)
+#if CONFIG_STANDBY_CLOCK_DIGIT_CELLS
+    time_label_ = time_field_.Create(standby_screen_, text_font, lv_color_white(), "12:00");
+#else
     time_label_ = lv_label_create(standby_screen_);
     lv_obj_set_width(time_label_, LV_HOR_RES);  // Same as date and weekday labels
     lv_obj_set_style_text_align(time_label_, LV_TEXT_ALIGN_CENTER, 0);
     lv_obj_set_style_text_font(time_label_, text_font, 0);  // Use text font for time display
     lv_obj_set_style_text_color(time_label_, lv_color_white(), 0);  // Set text color to white
     lv_label_set_text(time_label_, "12:00");
+    time_field_.Attach(time_label_);
+#endif
     // Position time label at fixed Y position (between weekday and temp_humidity)
     lv_obj_align(time_label_, LV_ALIGN_TOP_MID, 0, 32);
     ESP_LOGI(TAG, "time_label_ created: %p, text='12:00'", time_label_);
@@ -481,11 +494,19 @@ void OledDisplay::SetupStandbyScreen() {
     lv_label_set_text(temp_humidity_label_, "25.0°C / 50.0%");
     lv_obj_align(temp_humidity_label_, LV_ALIGN_BOTTOM_MID, 0, -4);
     ESP_LOGI(TAG, "temp_humidity_label_ created: %p", temp_humidity_label_);
-    
+
+    date_field_.Attach(date_label_);
+    weekday_field_.Attach(weekday_label_);
+    temp_humidity_field_.Attach(temp_humidity_label_);
+    standby_day_ = -1;
+
     ESP_LOGI(TAG, "SetupStandbyScreen() completed");
 }
 
 void OledDisplay::ShowStandbyScreen() {
+    if (ui_queue_.Defer(kUiCommandShowStandby)) {
+        return;
+    }
     DisplayLockGuard lock(this);
 
     ESP_LOGI(TAG, "ShowStandbyScreen() called");
@@ -531,6 +552,9 @@ void OledDisplay::ShowStandbyScreen() {
 }
 
 void OledDisplay::HideStandbyScreen() {
+    if (ui_queue_.Defer(kUiCommandHideStandby)) {
+        return;
+    }
     DisplayLockGuard lock(this);
 
     if (standby_screen_ != nullptr) {
@@ -565,11 +589,12 @@ void OledDisplay::HideStandbyScreen() {
 }
 
 void OledDisplay::UpdateStandbyScreen() {
+    if (ui_queue_.Defer(kUiCommandUpdateStandby)) {
+        return;
+    }
     DisplayLockGuard lock(this);
 
     if (standby_screen_ == nullptr || lv_obj_has_flag(standby_screen_, LV_OBJ_FLAG_HIDDEN)) {
-        ESP_LOGW(TAG, "UpdateStandbyScreen skipped - standby_screen_=%p, hidden=%d", 
-                 standby_screen_, standby_screen_ ? lv_obj_has_flag(standby_screen_, LV_OBJ_FLAG_HIDDEN) : 0);
         return;
     }
 
@@ -579,46 +604,36 @@ void OledDisplay::UpdateStandbyScreen() {
     time(&now);
     localtime_r(&now, &timeinfo);
 
-    // Log time values for debugging
-    ESP_LOGI(TAG, "UpdateStandbyScreen: year=%d, mon=%d, day=%d, hour=%d, min=%d, sec=%d",
-             timeinfo.tm_year + 1900, timeinfo.tm_mon + 1, timeinfo.tm_mday,
-             timeinfo.tm_hour, timeinfo.tm_min, timeinfo.tm_sec);
-
-    // Update date
-    char date_buf[16];
-    strftime(date_buf, sizeof(date_buf), "%Y-%m-%d", &timeinfo);
-    ESP_LOGI(TAG, "Setting date label: %s", date_buf);
-    lv_label_set_text(date_label_, date_buf);
+    // Date and weekday only change at midnight, or when SNTP sets the clock. Keyed on the
+    // year and day of the year: the day of the month alone misses a sync on the 1st.
+    int day = timeinfo.tm_year * 1000 + timeinfo.tm_yday;
+    if (day != standby_day_) {
+        standby_day_ = day;
+        char date_buf[16];
+        strftime(date_buf, sizeof(date_buf), "%Y-%m-%d", &timeinfo);
+        date_field_.SetText(date_buf);
 
-    // Update weekday
-    char weekday_buf[16];
-    strftime(weekday_buf, sizeof(weekday_buf), "%A", &timeinfo);
-    ESP_LOGI(TAG, "Setting weekday label: %s", weekday_buf);
-    lv_label_set_text(weekday_label_, weekday_buf);
+        char weekday_buf[16];
+        strftime(weekday_buf, sizeof(weekday_buf), "%A", &timeinfo);
+        weekday_field_.SetText(weekday_buf);
+    }
 
-    // Update time
+    // Update time, the label is only redrawn when the minute changes
     char time_buf[16];
     strftime(time_buf, sizeof(time_buf), "%H:%M", &timeinfo);
-    ESP_LOGI(TAG, "Setting time label: '%s' (time_label_=%p)", time_buf, time_label_);
-    if (time_label_ != nullptr) {
-        lv_label_set_text(time_label_, time_buf);
-        // Force refresh
-        lv_obj_invalidate(time_label_);
-        ESP_LOGI(TAG, "Time label text set and invalidated");
-    } else {
-        ESP_LOGE(TAG, "time_label_ is NULL!");
+    if (time_field_.SetText(time_buf)) {
+        ESP_LOGD(TAG, "UpdateStandbyScreen: %s", time_buf);
     }
 
     // Update temperature and humidity
     try {
-        // Try to get sensor data
+        // Cached text, only re-formatted when the sampler published a new reading
         auto& sensor_manager = SensorManager::GetInstance();
-        std::string temp_humidity_str = sensor_manager.GetTemperatureHumidityString();
-        ESP_LOGI(TAG, "Setting temp_humidity label: %s", temp_humidity_str.c_str());
-        lv_label_set_text(temp_humidity_label_, temp_humidity_str.c_str());
+        SensorReadingText text;
+        sensor_manager.GetReadingText(text);
+        temp_humidity_field_.SetText(text.combined);
     } catch (...) {
         // If sensor manager is not initialized, show default value
-        ESP_LOGW(TAG, "Sensor manager not available, showing default value");
-        lv_label_set_text(temp_humidity_label_, "--.-°C / --.-%");
+        temp_humidity_field_.SetText("--.-°C / --.-%");
     }
 }
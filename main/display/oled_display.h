@@ -2,6 +2,7 @@
 #define OLED_DISPLAY_H
 
 #include "lvgl_display.h"
+#include "lvgl_text_field.h"
 
 #include <esp_lcd_panel_io.h>
 #include <esp_lcd_panel_ops.h>
@@ -47,6 +48,17 @@ private:
     lv_obj_t* weekday_label_ = nullptr;
     lv_obj_t* time_label_ = nullptr;
     lv_obj_t* temp_humidity_label_ = nullptr;
+
+    // Fields remember their text, one that did not change costs no redraw
+    LvglTextField date_field_;
+    LvglTextField weekday_field_;
+#if CONFIG_STANDBY_CLOCK_DIGIT_CELLS
+    LvglDigitField time_field_;
+#else
+    LvglTextField time_field_;
+#endif
+    LvglTextField temp_humidity_field_;
+    int standby_day_ = -1;              // tm_year * 1000 + tm_yday the date and weekday were formatted for
 };
 
 #endif // OLED_DISPLAY_H
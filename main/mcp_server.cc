@@ -8,22 +8,63 @@
 #include <esp_app_desc.h>
 #include <algorithm>
 #include <cstring>
+#include <cmath>
+#include <ctime>
 #include <esp_pthread.h>
+#include <atomic>
+#include <thread>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <esp_timer.h>
+#include <esp_heap_caps.h>
 
 #include "application.h"
 #include "display.h"
 #include "oled_display.h"
 #include "board.h"
 #include "settings.h"
+#include "sensors/sensor_manager.h"
 #include "lvgl_theme.h"
 #include "lvgl_display.h"
+#include "jpg/jpeg_to_image.h"
 
 #define TAG "MCP"
 
+#define MCP_WORKER_COUNT            2
+#define MCP_WORKER_STACK_SIZE       (4096 * 2)
+#define MCP_WORKER_PRIORITY         2
+#define MCP_MAX_QUEUED_TOOL_CALLS   4
+// Screen snapshots are uploaded in pieces of this size, with at most this many waiting
+#define MCP_SNAPSHOT_CHUNK_SIZE     (4 * 1024)
+#define MCP_SNAPSHOT_QUEUE_LENGTH   4
+
+struct McpToolCall {
+    McpReplyTarget target;
+    McpTool* tool;
+    PropertyList arguments;
+    int64_t deadline_us;                // 0 means no timeout
+    std::atomic<bool> replied{false};   // Set by whoever replies first: worker, timeout or cancellation
+};
+
 McpServer::McpServer() {
+    esp_timer_create_args_t tool_call_timer_args = {
+        .callback = [](void* arg) {
+            McpServer* server = (McpServer*)arg;
+            server->CheckToolCallTimeouts();
+        },
+        .arg = this,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "mcp_tool_call_timer",
+        .skip_unhandled_events = true
+    };
+    esp_timer_create(&tool_call_timer_args, &tool_call_timer_);
 }
 
 McpServer::~McpServer() {
+    if (tool_call_timer_ != nullptr) {
+        esp_timer_stop(tool_call_timer_);
+        esp_timer_delete(tool_call_timer_);
+    }
     for (auto tool : tools_) {
         delete tool;
     }
@@ -63,6 +104,125 @@ void McpServer::AddCommonTools() {
             return true;
         });
     
+    auto sensor_history = SensorManager::GetInstance().GetHistory();
+    if (sensor_history) {
+        AddTool("self.sensor.get_history",
+            "Get the temperature and humidity history recorded by the device's sensor.\n"
+            "Use this tool for questions about trends, e.g. how did the humidity change overnight?\n"
+            "Args:\n"
+            "  `hours`: How many hours to look back, up to 720 (30 days).\n"
+            "Return:\n"
+            "  Min / max / mean over the period and a series of up to 24 points, oldest first. "
+            "Times are unix timestamps in seconds.",
+            PropertyList({
+                Property("hours", kPropertyTypeInteger, 24, 1, 720)
+            }),
+            [sensor_history](const PropertyList& properties) -> ReturnValue {
+                uint32_t to = time(nullptr) + 1;
+                uint32_t from = to - properties["hours"].value<int>() * 3600;
+                SensorHistoryStats stats;
+                if (!sensor_history->GetStats(from, to, stats)) {
+                    throw std::runtime_error("No sensor history recorded in this period");
+                }
+
+                auto json = cJSON_CreateObject();
+                cJSON_AddNumberToObject(json, "start", stats.start);
+                cJSON_AddNumberToObject(json, "end", stats.end);
+                auto add_stats = [json](const char* name, float min, float max, float mean) {
+                    auto item = cJSON_CreateObject();
+                    cJSON_AddNumberToObject(item, "min", min);
+                    cJSON_AddNumberToObject(item, "max", max);
+                    cJSON_AddNumberToObject(item, "mean", mean);
+                    cJSON_AddItemToObject(json, name, item);
+                };
+                add_stats("temperature", stats.temperature_min, stats.temperature_max, stats.temperature_mean);
+                add_stats("humidity", stats.humidity_min, stats.humidity_max, stats.humidity_mean);
+
+                SensorHistoryBucket buckets[24];
+                size_t count = sensor_history->GetSeries(from, to, buckets, 24);
+                auto series = cJSON_CreateArray();
+                for (size_t i = 0; i < count; i++) {
+                    // Compact rows: [time, temperature mean, humidity mean], one decimal
+                    auto row = cJSON_CreateArray();
+                    cJSON_AddItemToArray(row, cJSON_CreateNumber(buckets[i].start));
+                    cJSON_AddItemToArray(row, cJSON_CreateNumber(
+                        std::round(buckets[i].temperature_sum / 10.0 / buckets[i].count) / 10.0));
+                    cJSON_AddItemToArray(row, cJSON_CreateNumber(
+                        std::round(buckets[i].humidity_sum / 10.0 / buckets[i].count) / 10.0));
+                    cJSON_AddItemToArray(series, row);
+                }
+                cJSON_AddItemToObject(json, "series", series);
+                return json;
+            });
+    }
+
+    // 没有检测到传感器时不注册规则工具，避免模型添加永远不会触发的规则
+    if (SensorManager::GetInstance().IsInitialized()) {
+        auto& sensor_rules = SensorManager::GetInstance().GetRules();
+        AddTool("self.sensor.add_rule",
+            "Add a rule that watches the temperature / humidity sensor and notifies the user when it matches.\n"
+            "Use this tool when the user asks to be told when it gets too hot, too humid, etc.\n"
+            "Args:\n"
+            "  `expression`: `<channel> <op> <value> [in <duration>] [hyst <value>]`, channel is `temperature` or `humidity`, "
+            "op is one of `>`, `>=`, `<`, `<=`, `rise`, `drop`. `rise` / `drop` compare the change within `in` "
+            "(default 10m, suffix s / m / h). `hyst` is how far the value must recede before the rule fires again "
+            "(default 0.5). Examples: `humidity > 70`, `temperature drop 3 in 10m`.\n"
+            "  `action`: `alert` shows the message with a sound, `sound` only plays a sound, "
+            "`reminder` speaks the message like a reminder.\n"
+            "  `message`: Text shown or spoken when the rule fires, in the user's language.\n"
+            "Return:\n"
+            "  The id of the new rule.",
+            PropertyList({
+                Property("expression", kPropertyTypeString),
+                Property("action", kPropertyTypeString, "alert"),
+                Property("message", kPropertyTypeString, "")
+            }),
+            [&sensor_rules](const PropertyList& properties) -> ReturnValue {
+                auto action_name = properties["action"].value<std::string>();
+                SensorRuleAction action;
+                if (action_name == "alert") {
+                    action = kSensorRuleActionAlert;
+                } else if (action_name == "sound") {
+                    action = kSensorRuleActionSound;
+                } else if (action_name == "reminder") {
+                    action = kSensorRuleActionReminder;
+                } else {
+                    throw std::runtime_error("Unknown action: " + action_name);
+                }
+                return sensor_rules.AddRule(properties["expression"].value<std::string>(), action,
+                    properties["message"].value<std::string>());
+            });
+
+        AddTool("self.sensor.list_rules",
+            "List the sensor rules added with `self.sensor.add_rule`.",
+            PropertyList(),
+            [&sensor_rules](const PropertyList& properties) -> ReturnValue {
+                static const char* const action_names[] = {"alert", "sound", "reminder"};
+                auto json = cJSON_CreateArray();
+                for (auto& rule : sensor_rules.GetRules()) {
+                    auto item = cJSON_CreateObject();
+                    cJSON_AddNumberToObject(item, "id", rule.id);
+                    cJSON_AddStringToObject(item, "expression", rule.expression.c_str());
+                    cJSON_AddStringToObject(item, "action", action_names[rule.action]);
+                    cJSON_AddStringToObject(item, "message", rule.message.c_str());
+                    cJSON_AddItemToArray(json, item);
+                }
+                return json;
+            });
+
+        AddTool("self.sensor.remove_rule",
+            "Remove a sensor rule by its id, see `self.sensor.list_rules`.",
+            PropertyList({
+                Property("id", kPropertyTypeInteger)
+            }),
+            [&sensor_rules](const PropertyList& properties) -> ReturnValue {
+                if (!sensor_rules.RemoveRule(properties["id"].value<int>())) {
+                    throw std::runtime_error("Rule not found");
+                }
+                return true;
+            });
+    }
+
     auto backlight = board.GetBacklight();
     if (backlight) {
         AddTool("self.screen.set_brightness",
@@ -117,12 +277,16 @@ void McpServer::AddCommonTools() {
                 }
                 auto question = properties["question"].value<std::string>();
                 return camera->Explain(question);
-            });
+            })->set_execution(kToolExecutionWorker, 60000);
     }
 #endif
 
     // Restore the original tools list to the end of the tools list
     tools_.insert(tools_.end(), original_tools.begin(), original_tools.end());
+
+    // The tools order has changed, invalidate the tools/list cache
+    std::lock_guard<std::mutex> lock(tools_list_mutex_);
+    tools_list_cache_valid_ = false;
 }
 
 void McpServer::AddUserOnlyTools() {
@@ -156,7 +320,10 @@ void McpServer::AddUserOnlyTools() {
         [this](const PropertyList& properties) -> ReturnValue {
             auto url = properties["url"].value<std::string>();
             ESP_LOGI(TAG, "User requested firmware upgrade from URL: %s", url.c_str());
-            
+
+            // Reply first: the upgrade closes the audio channel, which cancels pending tool calls,
+            // and reboots on success. On the main task it also shows its progress like an OTA
+            // started from the version check, and a tool timeout cannot abandon it half way.
             auto& app = Application::GetInstance();
             app.Schedule([url, &app]() {
                 bool success = app.UpgradeFirmware(url);
@@ -164,9 +331,8 @@ void McpServer::AddUserOnlyTools() {
                     ESP_LOGE(TAG, "Firmware upgrade failed");
                 }
             });
-            
             return true;
-        });
+        })->set_execution(kToolExecutionInline);
 
     // Reminder tool - allows LLM to set a timed reminder
     AddUserOnlyTool("self.set_reminder",
@@ -213,7 +379,28 @@ void McpServer::AddUserOnlyTools() {
                     cJSON_AddBoolToObject(json, "monochrome", false);
                 }
                 return json;
-            });
+            })->set_execution(kToolExecutionInline);
+
+        AddUserOnlyTool("self.screen.get_render_stats",
+            "Render performance of the screen since boot or the last reset: frames, fps, and histograms of "
+            "render time, flush time, pixels per frame, frame interval and display lock wait. "
+            "Times are in microseconds, histogram bucket i counts values below 2^i. "
+            "LVGL timer latency is only sampled for a minute after each call and while the overlay is shown.",
+            PropertyList({
+                Property("reset", kPropertyTypeBoolean, false)
+            }),
+            [display](const PropertyList& properties) -> ReturnValue {
+                return display->GetRenderStats(properties["reset"].value<bool>());
+            })->set_execution(kToolExecutionInline);
+
+        AddUserOnlyTool("self.screen.set_render_overlay", "Show or hide a one-line render performance overlay on the screen",
+            PropertyList({
+                Property("enabled", kPropertyTypeBoolean)
+            }),
+            [display](const PropertyList& properties) -> ReturnValue {
+                display->SetRenderOverlay(properties["enabled"].value<bool>());
+                return true;
+            })->set_execution(kToolExecutionInline);
 
 #if CONFIG_LV_USE_SNAPSHOT
         AddUserOnlyTool("self.screen.snapshot", "Snapshot the screen and upload it to a specific URL",
@@ -225,22 +412,49 @@ void McpServer::AddUserOnlyTools() {
                 auto url = properties["url"].value<std::string>();
                 auto quality = properties["quality"].value<int>();
 
-                std::string jpeg_data;
-                if (!display->SnapshotToJpeg(jpeg_data, quality)) {
-                    throw std::runtime_error("Failed to snapshot screen");
+                // The encoder runs on its own thread and hands its output over through a short queue,
+                // so the upload overlaps encoding and the JPEG is never held whole
+                struct SnapshotChunk {
+                    uint8_t* data;  // nullptr ends the stream
+                    size_t len;
+                };
+                QueueHandle_t chunk_queue = xQueueCreate(MCP_SNAPSHOT_QUEUE_LENGTH, sizeof(SnapshotChunk));
+                if (chunk_queue == nullptr) {
+                    throw std::runtime_error("Failed to create snapshot queue");
                 }
+                int64_t start_time = esp_timer_get_time();
+                int64_t encode_us = 0;
+                bool encode_ok = false;
+                std::thread encoder([display, quality, chunk_queue, &encode_us, &encode_ok]() {
+                    bool out_of_memory = false;
+                    bool ok = display->SnapshotToJpeg([chunk_queue, &out_of_memory](const void* data, size_t len) {
+                        // Large pieces are split, a slow upload then blocks the encoder after a few chunks
+                        for (size_t offset = 0; offset < len && !out_of_memory; offset += MCP_SNAPSHOT_CHUNK_SIZE) {
+                            SnapshotChunk chunk = {nullptr, std::min<size_t>(MCP_SNAPSHOT_CHUNK_SIZE, len - offset)};
+                            chunk.data = (uint8_t*)heap_caps_malloc(chunk.len, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+                            if (chunk.data == nullptr) {
+                                ESP_LOGE(TAG, "Failed to allocate %u bytes for snapshot chunk", chunk.len);
+                                out_of_memory = true;
+                                break;
+                            }
+                            memcpy(chunk.data, (const uint8_t*)data + offset, chunk.len);
+                            xQueueSend(chunk_queue, &chunk, portMAX_DELAY);
+                        }
+                    }, quality);
+                    encode_ok = ok && !out_of_memory;
+                    encode_us = esp_timer_get_time();
+                    SnapshotChunk end = {nullptr, 0};
+                    xQueueSend(chunk_queue, &end, portMAX_DELAY);
+                });
 
-                ESP_LOGI(TAG, "Upload snapshot %u bytes to %s", jpeg_data.size(), url.c_str());
-                
                 // 构造multipart/form-data请求体
                 std::string boundary = "----ESP32_SCREEN_SNAPSHOT_BOUNDARY";
                 
                 auto http = Board::GetInstance().GetNetwork()->CreateHttp(3);
                 http->SetHeader("Content-Type", "multipart/form-data; boundary=" + boundary);
-                if (!http->Open("POST", url)) {
-                    throw std::runtime_error("Failed to open URL: " + url);
-                }
-                {
+                http->SetHeader("Transfer-Encoding", "chunked");
+                bool opened = http->Open("POST", url);
+                if (opened) {
                     // 文件字段头部
                     std::string file_header;
                     file_header += "--" + boundary + "\r\n";
@@ -250,8 +464,34 @@ void McpServer::AddUserOnlyTools() {
                     http->Write(file_header.c_str(), file_header.size());
                 }
 
-                // JPEG数据
-                http->Write((const char*)jpeg_data.data(), jpeg_data.size());
+                // JPEG数据, the queue is drained even on failure so the encoder can finish
+                size_t total_sent = 0;
+                int chunk_count = 0;
+                while (true) {
+                    SnapshotChunk chunk;
+                    xQueueReceive(chunk_queue, &chunk, portMAX_DELAY);
+                    if (chunk.data == nullptr) {
+                        break;
+                    }
+                    if (opened) {
+                        http->Write((const char*)chunk.data, chunk.len);
+                        total_sent += chunk.len;
+                        chunk_count++;
+                    }
+                    heap_caps_free(chunk.data);
+                }
+                encoder.join();
+                vQueueDelete(chunk_queue);
+
+                if (!opened) {
+                    throw std::runtime_error("Failed to open URL: " + url);
+                }
+                if (!encode_ok || total_sent == 0) {
+                    // Drop the connection instead of ending the chunked body, so the server
+                    // sees an aborted upload rather than a truncated JPEG
+                    http->Close();
+                    throw std::runtime_error("Failed to snapshot screen");
+                }
 
                 {
                     // multipart尾部
@@ -266,9 +506,12 @@ void McpServer::AddUserOnlyTools() {
                 }
                 std::string result = http->ReadAll();
                 http->Close();
+                ESP_LOGI(TAG, "Uploaded snapshot %u bytes in %d chunks to %s, encoded in %ld ms, total %ld ms",
+                    total_sent, chunk_count, url.c_str(), (long)((encode_us - start_time) / 1000),
+                    (long)((esp_timer_get_time() - start_time) / 1000));
                 ESP_LOGI(TAG, "Snapshot screen result: %s", result.c_str());
                 return true;
-            });
+            })->set_execution(kToolExecutionWorker, 30000);
         
         AddUserOnlyTool("self.screen.preview_image", "Preview an image on the screen",
             PropertyList({
@@ -286,12 +529,61 @@ void McpServer::AddUserOnlyTools() {
                     throw std::runtime_error("Unexpected status code: " + std::to_string(status_code));
                 }
 
+                // The first bytes tell JPEGs apart, the decoder gets them back before the rest of the body
+                struct PreviewStream {
+                    Http* http;
+                    uint8_t head[2];
+                    size_t head_len;
+                    size_t head_pos;
+                } stream = {http.get(), {}, 0, 0};
+                while (stream.head_len < sizeof(stream.head)) {
+                    int ret = http->Read((char*)stream.head + stream.head_len, sizeof(stream.head) - stream.head_len);
+                    if (ret <= 0) {
+                        break;
+                    }
+                    stream.head_len += ret;
+                }
+
+#if CONFIG_LV_USE_TJPGD
+                if (stream.head_len == 2 && stream.head[0] == 0xFF && stream.head[1] == 0xD8) {
+                    // Decode while downloading, straight to about the size it is shown at
+                    int box_width, box_height;
+                    display->GetPreviewImageBox(box_width, box_height);
+                    uint8_t* pixels = nullptr;
+                    size_t pixels_len, width, height, stride;
+                    esp_err_t err = jpeg_stream_to_image([](void* ctx, uint8_t* buf, size_t len) -> size_t {
+                        auto stream = static_cast<PreviewStream*>(ctx);
+                        if (stream->head_pos < stream->head_len) {
+                            size_t n = std::min(len, stream->head_len - stream->head_pos);
+                            memcpy(buf, stream->head + stream->head_pos, n);
+                            stream->head_pos += n;
+                            return n;
+                        }
+                        int ret = stream->http->Read((char*)buf, len);
+                        return ret > 0 ? ret : 0;
+                    }, &stream, box_width, box_height, &pixels, &pixels_len, &width, &height, &stride);
+                    http->Close();
+                    if (err != ESP_OK) {
+                        throw std::runtime_error("Failed to decode image: " + url);
+                    }
+                    auto image = std::make_unique<LvglAllocatedImage>(pixels, pixels_len, width, height, stride,
+                        LV_COLOR_FORMAT_RGB565);
+                    display->SetPreviewImage(std::move(image));
+                    return true;
+                }
+#endif
+
+                // Other formats are downloaded whole and decoded by LVGL
                 size_t content_length = http->GetBodyLength();
+                if (content_length < stream.head_len) {
+                    throw std::runtime_error("Failed to download image: " + url);
+                }
                 char* data = (char*)heap_caps_malloc(content_length, MALLOC_CAP_8BIT);
                 if (data == nullptr) {
                     throw std::runtime_error("Failed to allocate memory for image: " + url);
                 }
-                size_t total_read = 0;
+                memcpy(data, stream.head, stream.head_len);
+                size_t total_read = stream.head_len;
                 while (total_read < content_length) {
                     int ret = http->Read(data + total_read, content_length - total_read);
                     if (ret < 0) {
@@ -308,7 +600,7 @@ void McpServer::AddUserOnlyTools() {
                 auto image = std::make_unique<LvglAllocatedImage>(data, content_length);
                 display->SetPreviewImage(std::move(image));
                 return true;
-            });
+            })->set_execution(kToolExecutionWorker, 30000);
 #endif // CONFIG_LV_USE_SNAPSHOT
     }
 #endif // HAVE_LVGL
@@ -331,23 +623,30 @@ void McpServer::AddUserOnlyTools() {
 
 void McpServer::AddTool(McpTool* tool) {
     // Prevent adding duplicate tools
-    if (std::find_if(tools_.begin(), tools_.end(), [tool](const McpTool* t) { return t->name() == tool->name(); }) != tools_.end()) {
+    if (tool_index_.find(tool->name()) != tool_index_.end()) {
         ESP_LOGW(TAG, "Tool %s already added", tool->name().c_str());
         return;
     }
 
     ESP_LOGI(TAG, "Add tool: %s%s", tool->name().c_str(), tool->user_only() ? " [user]" : "");
     tools_.push_back(tool);
+    tool_index_[tool->name()] = tool;
+
+    std::lock_guard<std::mutex> lock(tools_list_mutex_);
+    tools_list_cache_valid_ = false;
 }
 
-void McpServer::AddTool(const std::string& name, const std::string& description, const PropertyList& properties, std::function<ReturnValue(const PropertyList&)> callback) {
-    AddTool(new McpTool(name, description, properties, callback));
+McpTool* McpServer::AddTool(const std::string& name, const std::string& description, const PropertyList& properties, std::function<ReturnValue(const PropertyList&)> callback) {
+    auto tool = new McpTool(name, description, properties, callback);
+    AddTool(tool);
+    return tool;
 }
 
-void McpServer::AddUserOnlyTool(const std::string& name, const std::string& description, const PropertyList& properties, std::function<ReturnValue(const PropertyList&)> callback) {
+McpTool* McpServer::AddUserOnlyTool(const std::string& name, const std::string& description, const PropertyList& properties, std::function<ReturnValue(const PropertyList&)> callback) {
     auto tool = new McpTool(name, description, properties, callback);
     tool->set_user_only(true);
     AddTool(tool);
+    return tool;
 }
 
 void McpServer::ParseMessage(const std::string& message) {
@@ -380,6 +679,51 @@ void McpServer::ParseCapabilities(const cJSON* capabilities) {
 }
 
 void McpServer::ParseMessage(const cJSON* json) {
+    if (cJSON_IsArray(json)) {
+        ParseBatch(json);
+        return;
+    }
+    ParseRequest(json, nullptr);
+}
+
+// JSON-RPC 2.0 error for a batch that is empty or has an item that is not a request object
+static constexpr char kInvalidRequestReply[] =
+    "{\"jsonrpc\":\"2.0\",\"id\":null,\"error\":{\"code\":-32600,\"message\":\"Invalid Request\"}}";
+
+void McpServer::ParseBatch(const cJSON* json) {
+    int count = cJSON_GetArraySize(json);
+    if (count == 0) {
+        ESP_LOGE(TAG, "Empty JSONRPC batch");
+        Application::GetInstance().SendMcpMessage(std::string(kInvalidRequestReply));
+        return;
+    }
+
+    // Requests are dispatched in order, their responses are sent together in one message
+    auto batch = std::make_shared<McpBatch>();
+    batch->start_time = esp_timer_get_time();
+    batch->requests = count;
+    {
+        std::lock_guard<std::mutex> lock(batch_mutex_);
+        batch->generation = batch_generation_;
+    }
+    const std::string invalid_request = kInvalidRequestReply;
+    const cJSON* item;
+    cJSON_ArrayForEach(item, json) {
+        if (!cJSON_IsObject(item)) {
+            ESP_LOGE(TAG, "Invalid JSONRPC batch item");
+            {
+                std::lock_guard<std::mutex> lock(batch_mutex_);
+                batch->pending++;
+            }
+            CompleteBatchReply(batch, &invalid_request);
+            continue;
+        }
+        ParseRequest(item, batch);
+    }
+    CompleteBatchReply(batch, nullptr);
+}
+
+void McpServer::ParseRequest(const cJSON* json, const std::shared_ptr<McpBatch>& batch) {
     // Check JSONRPC version
     auto version = cJSON_GetObjectItem(json, "jsonrpc");
     if (version == nullptr || !cJSON_IsString(version) || strcmp(version->valuestring, "2.0") != 0) {
@@ -411,7 +755,13 @@ void McpServer::ParseMessage(const cJSON* json) {
         ESP_LOGE(TAG, "Invalid id for method: %s", method_str.c_str());
         return;
     }
-    auto id_int = id->valueint;
+    McpReplyTarget target{id->valueint, batch};
+
+    // Every path below replies exactly once
+    if (batch) {
+        std::lock_guard<std::mutex> lock(batch_mutex_);
+        batch->pending++;
+    }
     
     if (method_str == "initialize") {
         if (cJSON_IsObject(params)) {
@@ -424,7 +774,7 @@ void McpServer::ParseMessage(const cJSON* json) {
         std::string message = "{\"protocolVersion\":\"2024-11-05\",\"capabilities\":{\"tools\":{}},\"serverInfo\":{\"name\":\"" BOARD_NAME "\",\"version\":\"";
         message += app_desc->version;
         message += "\"}}";
-        ReplyResult(id_int, message);
+        ReplyResult(target, message);
     } else if (method_str == "tools/list") {
         std::string cursor_str = "";
         bool list_user_only_tools = false;
@@ -438,155 +788,401 @@ void McpServer::ParseMessage(const cJSON* json) {
                 list_user_only_tools = with_user_tools->valueint == 1;
             }
         }
-        GetToolsList(id_int, cursor_str, list_user_only_tools);
+        GetToolsList(target, cursor_str, list_user_only_tools);
     } else if (method_str == "tools/call") {
         if (!cJSON_IsObject(params)) {
             ESP_LOGE(TAG, "tools/call: Missing params");
-            ReplyError(id_int, "Missing params");
+            ReplyError(target, "Missing params");
             return;
         }
         auto tool_name = cJSON_GetObjectItem(params, "name");
         if (!cJSON_IsString(tool_name)) {
             ESP_LOGE(TAG, "tools/call: Missing name");
-            ReplyError(id_int, "Missing name");
+            ReplyError(target, "Missing name");
             return;
         }
         auto tool_arguments = cJSON_GetObjectItem(params, "arguments");
         if (tool_arguments != nullptr && !cJSON_IsObject(tool_arguments)) {
             ESP_LOGE(TAG, "tools/call: Invalid arguments");
-            ReplyError(id_int, "Invalid arguments");
+            ReplyError(target, "Invalid arguments");
             return;
         }
-        DoToolCall(id_int, std::string(tool_name->valuestring), tool_arguments);
+        DoToolCall(target, tool_name->valuestring, tool_arguments);
     } else {
         ESP_LOGE(TAG, "Method not implemented: %s", method_str.c_str());
-        ReplyError(id_int, "Method not implemented: " + method_str);
+        ReplyError(target, "Method not implemented: " + method_str);
     }
 }
 
-void McpServer::ReplyResult(int id, const std::string& result) {
+void McpServer::ReplyResult(const McpReplyTarget& target, const std::string& result) {
     std::string payload = "{\"jsonrpc\":\"2.0\",\"id\":";
-    payload += std::to_string(id) + ",\"result\":";
+    payload += std::to_string(target.id) + ",\"result\":";
     payload += result;
     payload += "}";
-    Application::GetInstance().SendMcpMessage(payload);
+    SendReply(target, payload);
 }
 
-void McpServer::ReplyError(int id, const std::string& message) {
+void McpServer::SendReply(const McpReplyTarget& target, const std::string& payload) {
+    if (target.batch) {
+        CompleteBatchReply(target.batch, &payload);
+    } else {
+        Application::GetInstance().SendMcpMessage(payload);
+    }
+}
+
+void McpServer::CompleteBatchReply(const std::shared_ptr<McpBatch>& batch, const std::string* payload) {
+    std::string message;
+    {
+        std::lock_guard<std::mutex> lock(batch_mutex_);
+        if (payload != nullptr) {
+            batch->responses += batch->responses.empty() ? "[" : ",";
+            batch->responses += *payload;
+            batch->replies++;
+        }
+        if (--batch->pending > 0) {
+            return;
+        }
+        if (batch->generation != batch_generation_) {
+            ESP_LOGW(TAG, "Drop the replies of a batch from a closed session");
+            return;
+        }
+        if (batch->responses.empty()) {
+            // Notifications only, nothing to reply
+            return;
+        }
+        message = std::move(batch->responses);
+        message += "]";
+    }
+    ESP_LOGI(TAG, "Batch of %d requests replied with %d responses, %u bytes in %d ms", batch->requests, batch->replies,
+        message.size(), (int)((esp_timer_get_time() - batch->start_time) / 1000));
+    Application::GetInstance().SendMcpMessage(message);
+}
+
+void McpServer::ReplyToolResult(const McpReplyTarget& target, ReturnValue& return_value) {
+    ReplyResult(target, McpTool::FormatResult(return_value));
+}
+
+void McpServer::ReplyError(const McpReplyTarget& target, const std::string& message) {
     std::string payload = "{\"jsonrpc\":\"2.0\",\"id\":";
-    payload += std::to_string(id);
+    payload += std::to_string(target.id);
     payload += ",\"error\":{\"message\":\"";
     payload += message;
     payload += "\"}}";
-    Application::GetInstance().SendMcpMessage(payload);
+    SendReply(target, payload);
 }
 
-void McpServer::GetToolsList(int id, const std::string& cursor, bool list_user_only_tools) {
-    const int max_payload_size = 8000;
-    std::string json = "{\"tools\":[";
-    
-    bool found_cursor = cursor.empty();
-    auto it = tools_.begin();
-    std::string next_cursor = "";
-    
-    while (it != tools_.end()) {
-        // 如果我们还没有找到起始位置，继续搜索
-        if (!found_cursor) {
-            if ((*it)->name() == cursor) {
-                found_cursor = true;
-            } else {
-                ++it;
+static constexpr char kToolsListHeader[] = "{\"tools\":[";
+
+void McpServer::BuildToolsListCache() {
+    const size_t max_payload_size = 8000;
+    const size_t header_size = sizeof(kToolsListHeader) - 1;
+    int64_t start_time = esp_timer_get_time();
+    size_t free_heap = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+
+    // Serialize each tool once
+    tools_json_arena_.clear();
+    tool_json_spans_.clear();
+    tool_json_spans_.reserve(tools_.size());
+    for (auto tool : tools_) {
+        std::string tool_json = tool->to_json();
+        tool_json_spans_.push_back({(uint32_t)tools_json_arena_.size(), (uint32_t)tool_json.size()});
+        tools_json_arena_ += tool_json;
+    }
+    tools_json_arena_.shrink_to_fit();
+
+    // Split the tools into pages, the same way as the payload size limit is checked by the server
+    for (int variant = 0; variant < 2; variant++) {
+        bool list_user_only_tools = variant == 1;
+        auto& cache = tools_list_cache_[variant];
+        cache.pages.clear();
+        cache.cursor_pages.clear();
+        cache.pages.emplace_back();
+        cache.pages.back().payload_size = header_size;
+
+        size_t i = 0;
+        while (i < tools_.size()) {
+            if (!list_user_only_tools && tools_[i]->user_only()) {
+                ++i;
                 continue;
             }
+
+            auto& page = cache.pages.back();
+            size_t tool_size = tool_json_spans_[i].length + 1;  // Trailing comma
+            if (page.payload_size + tool_size + 30 > max_payload_size) {
+                page.next_tool = tools_[i];
+                if (page.tools.empty()) {
+                    // A single tool exceeds the payload size limit
+                    break;
+                }
+                cache.cursor_pages[tools_[i]->name()] = cache.pages.size();
+                cache.pages.emplace_back();
+                cache.pages.back().payload_size = header_size;
+                continue;
+            }
+
+            page.tools.push_back(i);
+            page.payload_size += tool_size;
+            ++i;
         }
+    }
+    tools_list_cache_valid_ = true;
 
-        if (!list_user_only_tools && (*it)->user_only()) {
-            ++it;
-            continue;
+    ESP_LOGI(TAG, "tools/list cache built: %u tools, %u bytes, %u/%u pages, %lld us, heap %d bytes",
+        tools_.size(), tools_json_arena_.size(), tools_list_cache_[0].pages.size(), tools_list_cache_[1].pages.size(),
+        esp_timer_get_time() - start_time, (int)(free_heap - heap_caps_get_free_size(MALLOC_CAP_8BIT)));
+}
+
+void McpServer::GetToolsList(const McpReplyTarget& target, const std::string& cursor, bool list_user_only_tools) {
+    std::string json;
+    std::string error;
+    {
+        std::lock_guard<std::mutex> lock(tools_list_mutex_);
+        if (!tools_list_cache_valid_) {
+            BuildToolsListCache();
         }
-        
-        // 添加tool前检查大小
-        std::string tool_json = (*it)->to_json() + ",";
-        if (json.length() + tool_json.length() + 30 > max_payload_size) {
-            // 如果添加这个tool会超出大小限制，设置next_cursor并退出循环
-            next_cursor = (*it)->name();
-            break;
+
+        auto& cache = tools_list_cache_[list_user_only_tools ? 1 : 0];
+        size_t page_index = 0;
+        if (!cursor.empty()) {
+            auto it = cache.cursor_pages.find(cursor);
+            if (it == cache.cursor_pages.end()) {
+                error = "Invalid cursor: " + cursor;
+            } else {
+                page_index = it->second;
+            }
+        }
+
+        if (error.empty()) {
+            auto& page = cache.pages[page_index];
+            if (page.tools.empty() && page.next_tool != nullptr) {
+                // 如果没有添加任何tool，返回错误
+                error = "Failed to add tool " + page.next_tool->name() + " because of payload size limit";
+            } else {
+                json.reserve(page.payload_size + 32 + (page.next_tool ? page.next_tool->name().size() : 0));
+                json = kToolsListHeader;
+                for (size_t i = 0; i < page.tools.size(); i++) {
+                    if (i > 0) {
+                        json += ',';
+                    }
+                    auto& span = tool_json_spans_[page.tools[i]];
+                    json.append(tools_json_arena_, span.offset, span.length);
+                }
+                if (page.next_tool == nullptr) {
+                    json += "]}";
+                } else {
+                    json += "],\"nextCursor\":\"" + page.next_tool->name() + "\"}";
+                }
+            }
         }
-        
-        json += tool_json;
-        ++it;
-    }
-    
-    if (json.back() == ',') {
-        json.pop_back();
-    }
-    
-    if (json.back() == '[' && !tools_.empty()) {
-        // 如果没有添加任何tool，返回错误
-        ESP_LOGE(TAG, "tools/list: Failed to add tool %s because of payload size limit", next_cursor.c_str());
-        ReplyError(id, "Failed to add tool " + next_cursor + " because of payload size limit");
-        return;
     }
 
-    if (next_cursor.empty()) {
-        json += "]}";
-    } else {
-        json += "],\"nextCursor\":\"" + next_cursor + "\"}";
+    if (!error.empty()) {
+        ESP_LOGE(TAG, "tools/list: %s", error.c_str());
+        ReplyError(target, error);
+        return;
     }
-    
-    ReplyResult(id, json);
+    ReplyResult(target, json);
 }
 
-void McpServer::DoToolCall(int id, const std::string& tool_name, const cJSON* tool_arguments) {
-    auto tool_iter = std::find_if(tools_.begin(), tools_.end(), 
-                                 [&tool_name](const McpTool* tool) { 
-                                     return tool->name() == tool_name; 
-                                 });
-    
-    if (tool_iter == tools_.end()) {
-        ESP_LOGE(TAG, "tools/call: Unknown tool: %s", tool_name.c_str());
-        ReplyError(id, "Unknown tool: " + tool_name);
+void McpServer::DoToolCall(const McpReplyTarget& target, std::string_view tool_name, const cJSON* tool_arguments) {
+    auto tool_iter = tool_index_.find(tool_name);
+    if (tool_iter == tool_index_.end()) {
+        std::string name(tool_name);
+        ESP_LOGE(TAG, "tools/call: Unknown tool: %s", name.c_str());
+        ReplyError(target, "Unknown tool: " + name);
         return;
     }
 
-    PropertyList arguments = (*tool_iter)->properties();
+    auto tool = tool_iter->second;
+    PropertyList arguments = tool->AcquireArguments();
     try {
-        for (auto& argument : arguments) {
-            bool found = false;
-            if (cJSON_IsObject(tool_arguments)) {
-                auto value = cJSON_GetObjectItem(tool_arguments, argument.name().c_str());
-                if (argument.type() == kPropertyTypeBoolean && cJSON_IsBool(value)) {
-                    argument.set_value<bool>(value->valueint == 1);
-                    found = true;
-                } else if (argument.type() == kPropertyTypeInteger && cJSON_IsNumber(value)) {
-                    argument.set_value<int>(value->valueint);
-                    found = true;
-                } else if (argument.type() == kPropertyTypeString && cJSON_IsString(value)) {
-                    argument.set_value<std::string>(value->valuestring);
-                    found = true;
-                }
+        tool->BindArguments(tool_arguments, arguments);
+    } catch (const std::exception& e) {
+        ESP_LOGE(TAG, "tools/call: %s", e.what());
+        tool->ReleaseArguments(std::move(arguments));
+        ReplyError(target, e.what());
+        return;
+    }
+
+    switch (tool->execution()) {
+    case kToolExecutionInline:
+        try {
+            ReturnValue return_value = tool->Invoke(arguments);
+            ReplyToolResult(target, return_value);
+        } catch (const std::exception& e) {
+            ESP_LOGE(TAG, "tools/call: %s", e.what());
+            ReplyError(target, e.what());
+        }
+        tool->ReleaseArguments(std::move(arguments));
+        break;
+    case kToolExecutionMainThread: {
+        // Use main thread to call the tool
+        auto& app = Application::GetInstance();
+        app.Schedule([this, target, tool, arguments = std::move(arguments)]() mutable {
+            try {
+                ReturnValue return_value = tool->Invoke(arguments);
+                ReplyToolResult(target, return_value);
+            } catch (const std::exception& e) {
+                ESP_LOGE(TAG, "tools/call: %s", e.what());
+                ReplyError(target, e.what());
             }
+            tool->ReleaseArguments(std::move(arguments));
+        });
+        break;
+    }
+    case kToolExecutionWorker:
+        SubmitToolCall(target, tool, std::move(arguments));
+        break;
+    }
+}
+
+void McpServer::SubmitToolCall(const McpReplyTarget& target, McpTool* tool, PropertyList&& arguments) {
+    auto call = std::make_shared<McpToolCall>();
+    call->target = target;
+    call->tool = tool;
+    call->arguments = std::move(arguments);
+    call->deadline_us = tool->timeout_ms() > 0 ? esp_timer_get_time() + tool->timeout_ms() * 1000LL : 0;
 
-            if (!argument.has_default_value() && !found) {
-                ESP_LOGE(TAG, "tools/call: Missing valid argument: %s", argument.name().c_str());
-                ReplyError(id, "Missing valid argument: " + argument.name());
-                return;
+    {
+        std::lock_guard<std::mutex> lock(worker_mutex_);
+        if (worker_queue_.size() >= MCP_MAX_QUEUED_TOOL_CALLS) {
+            ESP_LOGW(TAG, "tools/call: Too many queued tool calls, rejecting %s", tool->name().c_str());
+            call->replied = true;
+        } else {
+            // Start the workers on the first worker tool call
+            while (worker_count_ < MCP_WORKER_COUNT) {
+                BaseType_t ret = xTaskCreate([](void* arg) {
+                    McpServer* server = (McpServer*)arg;
+                    server->WorkerTask();
+                    vTaskDelete(NULL);
+                }, "mcp_worker", MCP_WORKER_STACK_SIZE, this, MCP_WORKER_PRIORITY, nullptr);
+                if (ret != pdPASS) {
+                    ESP_LOGE(TAG, "Failed to create MCP worker task");
+                    break;
+                }
+                worker_count_++;
             }
+            worker_queue_.push_back(call);
+            active_tool_calls_.push_back(call);
         }
-    } catch (const std::exception& e) {
-        ESP_LOGE(TAG, "tools/call: %s", e.what());
-        ReplyError(id, e.what());
+    }
+
+    if (call->replied) {
+        ReplyError(target, "Too many pending tool calls");
         return;
     }
+    if (call->deadline_us > 0 && !esp_timer_is_active(tool_call_timer_)) {
+        esp_timer_start_periodic(tool_call_timer_, 500 * 1000);
+    }
+    worker_cv_.notify_one();
+}
 
-    // Use main thread to call the tool
-    auto& app = Application::GetInstance();
-    app.Schedule([this, id, tool_iter, arguments = std::move(arguments)]() {
+void McpServer::WorkerTask() {
+    while (true) {
+        std::shared_ptr<McpToolCall> call;
+        {
+            // Calls of the same tool are serialized, tools are not required to be reentrant
+            std::unique_lock<std::mutex> lock(worker_mutex_);
+            auto find_runnable = [this]() {
+                return std::find_if(worker_queue_.begin(), worker_queue_.end(), [this](const std::shared_ptr<McpToolCall>& c) {
+                    return c->replied || std::find(running_tools_.begin(), running_tools_.end(), c->tool) == running_tools_.end();
+                });
+            };
+            worker_cv_.wait(lock, [this, &find_runnable]() {
+                return find_runnable() != worker_queue_.end();
+            });
+            auto it = find_runnable();
+            call = *it;
+            worker_queue_.erase(it);
+            if (call->replied) {
+                // Timed out or cancelled while queued
+                continue;
+            }
+            running_tools_.push_back(call->tool);
+        }
+
+        int64_t start_time = esp_timer_get_time();
+        ReturnValue result = false;
+        std::string error;
         try {
-            ReplyResult(id, (*tool_iter)->Call(arguments));
+            result = call->tool->Invoke(call->arguments);
         } catch (const std::exception& e) {
             ESP_LOGE(TAG, "tools/call: %s", e.what());
-            ReplyError(id, e.what());
+            error = e.what();
         }
-    });
+        call->tool->ReleaseArguments(std::move(call->arguments));
+        ESP_LOGI(TAG, "Worker tool %s finished in %lld ms", call->tool->name().c_str(), (esp_timer_get_time() - start_time) / 1000);
+
+        {
+            std::lock_guard<std::mutex> lock(worker_mutex_);
+            running_tools_.erase(std::find(running_tools_.begin(), running_tools_.end(), call->tool));
+            auto it = std::find(active_tool_calls_.begin(), active_tool_calls_.end(), call);
+            if (it != active_tool_calls_.end()) {
+                active_tool_calls_.erase(it);
+            }
+        }
+        // Other calls of the same tool may be runnable now
+        worker_cv_.notify_all();
+
+        if (call->replied.exchange(true)) {
+            ESP_LOGW(TAG, "tools/call: Discard result of %s (timed out or cancelled)", call->tool->name().c_str());
+            McpTool::ReleaseResult(result);
+            continue;
+        }
+        if (error.empty()) {
+            ReplyToolResult(call->target, result);
+        } else {
+            ReplyError(call->target, error);
+        }
+    }
+}
+
+void McpServer::CheckToolCallTimeouts() {
+    std::vector<std::shared_ptr<McpToolCall>> timed_out;
+    {
+        std::lock_guard<std::mutex> lock(worker_mutex_);
+        int64_t now = esp_timer_get_time();
+        for (auto it = active_tool_calls_.begin(); it != active_tool_calls_.end();) {
+            auto& call = *it;
+            if (call->deadline_us > 0 && now >= call->deadline_us) {
+                if (!call->replied.exchange(true)) {
+                    timed_out.push_back(call);
+                }
+                it = active_tool_calls_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        bool has_deadline = std::any_of(active_tool_calls_.begin(), active_tool_calls_.end(),
+            [](const std::shared_ptr<McpToolCall>& call) { return call->deadline_us > 0; });
+        if (!has_deadline) {
+            esp_timer_stop(tool_call_timer_);
+        }
+    }
+    // Wake up the workers to drop timed out calls from the queue
+    worker_cv_.notify_all();
+
+    for (auto& call : timed_out) {
+        ESP_LOGE(TAG, "tools/call: %s timed out after %d ms", call->tool->name().c_str(), call->tool->timeout_ms());
+        ReplyError(call->target, "Tool call timed out: " + call->tool->name());
+    }
+}
+
+void McpServer::CancelToolCalls() {
+    {
+        // Batches still waiting for replies belong to the closed session
+        std::lock_guard<std::mutex> lock(batch_mutex_);
+        batch_generation_++;
+    }
+
+    std::lock_guard<std::mutex> lock(worker_mutex_);
+    if (active_tool_calls_.empty()) {
+        return;
+    }
+    ESP_LOGW(TAG, "Cancel %u pending tool calls", active_tool_calls_.size());
+    for (auto& call : active_tool_calls_) {
+        call->replied = true;
+    }
+    active_tool_calls_.clear();
+    worker_queue_.clear();
 }
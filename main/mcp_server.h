@@ -4,14 +4,22 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <unordered_map>
+#include <string_view>
+#include <mutex>
+#include <deque>
+#include <memory>
+#include <condition_variable>
 #include <functional>
 #include <variant>
 #include <optional>
 #include <stdexcept>
 #include <thread>
+#include <cstring>
 #include <mbedtls/base64.h>
 
 #include <cJSON.h>
+#include <esp_timer.h>
 
 class ImageContent {
 private:
@@ -23,6 +31,7 @@ private:
         mbedtls_base64_encode((unsigned char*)nullptr, 0, &dlen, (const unsigned char*)data.data(), data.size());
         std::string result(dlen, 0);
         mbedtls_base64_encode((unsigned char*)result.data(), result.size(), &olen, (const unsigned char*)data.data(), data.size());
+        result.resize(olen);
         return result;
     }
 
@@ -106,6 +115,11 @@ public:
         return std::get<T>(value_);
     }
 
+    // Restore the value (the default value if any) from the property this one was copied from
+    inline void reset_value(const Property& prototype) {
+        value_ = prototype.value_;
+    }
+
     template<typename T>
     inline void set_value(const T& value) {
         // 添加对设置的整数值进行范围检查
@@ -175,6 +189,10 @@ public:
         throw std::runtime_error("Property not found: " + name);
     }
 
+    inline size_t size() const { return properties_.size(); }
+    inline Property& at(size_t index) { return properties_[index]; }
+    inline const Property& at(size_t index) const { return properties_[index]; }
+
     auto begin() { return properties_.begin(); }
     auto end() { return properties_.end(); }
 
@@ -205,6 +223,13 @@ public:
     }
 };
 
+// Where a tool call is executed
+enum ToolExecution {
+    kToolExecutionInline,       // In the protocol task that received the call, for cheap non-blocking tools
+    kToolExecutionMainThread,   // In the main task through Application::Schedule (default)
+    kToolExecutionWorker        // In the MCP worker pool, for long running tools
+};
+
 class McpTool {
 private:
     std::string name_;
@@ -212,6 +237,34 @@ private:
     PropertyList properties_;
     std::function<ReturnValue(const PropertyList&)> callback_;
     bool user_only_ = false;
+    ToolExecution execution_ = kToolExecutionMainThread;
+    int timeout_ms_ = 0;
+
+    // Precompiled argument binder: one slot per property, in the same order as properties_
+    struct ArgumentSlot {
+        const char* name;
+        size_t length;
+    };
+    std::vector<ArgumentSlot> argument_slots_;
+    uint64_t required_mask_ = 0;
+
+    // Argument blocks returned by finished calls, reused by the next call
+    std::mutex argument_blocks_mutex_;
+    std::vector<PropertyList> argument_blocks_;
+
+    void CompileArgumentBinder() {
+        if (properties_.size() > 64) {
+            throw std::invalid_argument("Too many properties for tool: " + name_);
+        }
+        argument_slots_.reserve(properties_.size());
+        for (size_t i = 0; i < properties_.size(); i++) {
+            const auto& property = properties_.at(i);
+            argument_slots_.push_back({property.name().c_str(), property.name().size()});
+            if (!property.has_default_value()) {
+                required_mask_ |= 1ULL << i;
+            }
+        }
+    }
 
 public:
     McpTool(const std::string& name, 
@@ -221,13 +274,87 @@ public:
         : name_(name), 
         description_(description), 
         properties_(properties), 
-        callback_(callback) {}
+        callback_(callback) {
+        CompileArgumentBinder();
+    }
+
+    // Get an argument block for a call, it must be returned with ReleaseArguments
+    PropertyList AcquireArguments() {
+        std::lock_guard<std::mutex> lock(argument_blocks_mutex_);
+        if (argument_blocks_.empty()) {
+            return properties_;
+        }
+        PropertyList arguments = std::move(argument_blocks_.back());
+        argument_blocks_.pop_back();
+        return arguments;
+    }
+
+    void ReleaseArguments(PropertyList&& arguments) {
+        if (arguments.size() == 0) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(argument_blocks_mutex_);
+        if (argument_blocks_.empty()) {
+            argument_blocks_.push_back(std::move(arguments));
+        }
+    }
+
+    // Fill the argument block in one pass over the arguments object.
+    // Arguments not provided are reset to their default values.
+    // Throws std::invalid_argument if a required argument is missing or a value is out of range.
+    void BindArguments(const cJSON* tool_arguments, PropertyList& arguments) const {
+        uint64_t found = 0;
+        if (cJSON_IsObject(tool_arguments)) {
+            for (const cJSON* item = tool_arguments->child; item != nullptr; item = item->next) {
+                if (item->string == nullptr) {
+                    continue;
+                }
+                size_t length = strlen(item->string);
+                for (size_t i = 0; i < argument_slots_.size(); i++) {
+                    const auto& slot = argument_slots_[i];
+                    if (slot.length != length || memcmp(slot.name, item->string, length) != 0) {
+                        continue;
+                    }
+                    auto& argument = arguments.at(i);
+                    if (argument.type() == kPropertyTypeBoolean && cJSON_IsBool(item)) {
+                        argument.set_value<bool>(cJSON_IsTrue(item));
+                        found |= 1ULL << i;
+                    } else if (argument.type() == kPropertyTypeInteger && cJSON_IsNumber(item)) {
+                        argument.set_value<int>(item->valueint);
+                        found |= 1ULL << i;
+                    } else if (argument.type() == kPropertyTypeString && cJSON_IsString(item)) {
+                        argument.set_value<std::string>(item->valuestring);
+                        found |= 1ULL << i;
+                    }
+                    break;
+                }
+            }
+        }
+
+        uint64_t missing = ~found & ((argument_slots_.size() == 64) ? ~0ULL : ((1ULL << argument_slots_.size()) - 1));
+        for (size_t i = 0; missing != 0; i++, missing >>= 1) {
+            if (!(missing & 1)) {
+                continue;
+            }
+            if (required_mask_ & (1ULL << i)) {
+                throw std::invalid_argument("Missing valid argument: " + properties_.at(i).name());
+            }
+            arguments.at(i).reset_value(properties_.at(i));
+        }
+    }
 
     void set_user_only(bool user_only) { user_only_ = user_only; }
+    // timeout_ms only applies to worker tools, 0 means no timeout
+    void set_execution(ToolExecution execution, int timeout_ms = 0) {
+        execution_ = execution;
+        timeout_ms_ = timeout_ms;
+    }
     inline const std::string& name() const { return name_; }
     inline const std::string& description() const { return description_; }
     inline const PropertyList& properties() const { return properties_; }
     inline bool user_only() const { return user_only_; }
+    inline ToolExecution execution() const { return execution_; }
+    inline int timeout_ms() const { return timeout_ms_; }
 
     std::string to_json() const {
         std::vector<std::string> required = properties_.GetRequired();
@@ -269,8 +396,17 @@ public:
         return result;
     }
 
+    ReturnValue Invoke(const PropertyList& properties) {
+        return callback_(properties);
+    }
+
     std::string Call(const PropertyList& properties) {
         ReturnValue return_value = callback_(properties);
+        return FormatResult(return_value);
+    }
+
+    // Format a tool result as the MCP tools/call result object, consuming any owned value
+    static std::string FormatResult(ReturnValue& return_value) {
         // 返回结果
         cJSON* result = cJSON_CreateObject();
         cJSON* content = cJSON_CreateArray();
@@ -309,6 +445,35 @@ public:
         cJSON_Delete(result);
         return result_str;
     }
+
+    // Free a result that will not be sent
+    static void ReleaseResult(ReturnValue& return_value) {
+        if (std::holds_alternative<ImageContent*>(return_value)) {
+            delete std::get<ImageContent*>(return_value);
+        } else if (std::holds_alternative<cJSON*>(return_value)) {
+            cJSON_Delete(std::get<cJSON*>(return_value));
+        }
+        return_value = false;
+    }
+};
+
+struct McpToolCall;
+
+// Responses of a JSON-RPC batch request, sent together once every request has replied
+struct McpBatch {
+    int pending = 1;            // Replies not received yet, plus one while the batch is being dispatched
+    int requests = 0;
+    int replies = 0;
+    int64_t start_time = 0;
+    uint32_t generation = 0;    // McpServer::batch_generation_ when the batch arrived
+    std::string responses;
+};
+
+// Where a reply goes: the request id, plus the batch collecting it for requests sent in a batch.
+// Ids are only unique within a batch, so a batch reply is never matched by id alone.
+struct McpReplyTarget {
+    int id;
+    std::shared_ptr<McpBatch> batch;
 };
 
 class McpServer {
@@ -321,24 +486,76 @@ public:
     void AddCommonTools();
     void AddUserOnlyTools();
     void AddTool(McpTool* tool);
-    void AddTool(const std::string& name, const std::string& description, const PropertyList& properties, std::function<ReturnValue(const PropertyList&)> callback);
-    void AddUserOnlyTool(const std::string& name, const std::string& description, const PropertyList& properties, std::function<ReturnValue(const PropertyList&)> callback);
+    McpTool* AddTool(const std::string& name, const std::string& description, const PropertyList& properties, std::function<ReturnValue(const PropertyList&)> callback);
+    McpTool* AddUserOnlyTool(const std::string& name, const std::string& description, const PropertyList& properties, std::function<ReturnValue(const PropertyList&)> callback);
     void ParseMessage(const cJSON* json);
     void ParseMessage(const std::string& message);
 
+    /**
+     * Drop queued worker tool calls and discard the results of running ones.
+     * Called when the MCP session is closed.
+     */
+    void CancelToolCalls();
+
 private:
     McpServer();
     ~McpServer();
 
     void ParseCapabilities(const cJSON* capabilities);
-
-    void ReplyResult(int id, const std::string& result);
-    void ReplyError(int id, const std::string& message);
-
-    void GetToolsList(int id, const std::string& cursor, bool list_user_only_tools);
-    void DoToolCall(int id, const std::string& tool_name, const cJSON* tool_arguments);
+    void ParseBatch(const cJSON* json);
+    void ParseRequest(const cJSON* json, const std::shared_ptr<McpBatch>& batch);
+
+    void ReplyResult(const McpReplyTarget& target, const std::string& result);
+    void ReplyError(const McpReplyTarget& target, const std::string& message);
+    void SendReply(const McpReplyTarget& target, const std::string& payload);
+    void CompleteBatchReply(const std::shared_ptr<McpBatch>& batch, const std::string* payload);
+    void ReplyToolResult(const McpReplyTarget& target, ReturnValue& return_value);
+
+    void GetToolsList(const McpReplyTarget& target, const std::string& cursor, bool list_user_only_tools);
+    void DoToolCall(const McpReplyTarget& target, std::string_view tool_name, const cJSON* tool_arguments);
+    void BuildToolsListCache();
+    void SubmitToolCall(const McpReplyTarget& target, McpTool* tool, PropertyList&& arguments);
+    void WorkerTask();
+    void CheckToolCallTimeouts();
 
     std::vector<McpTool*> tools_;
+    std::unordered_map<std::string_view, McpTool*> tool_index_;   // Keyed by McpTool::name()
+
+    // tools/list cache: every tool is serialized once into tools_json_arena_,
+    // pages are precomputed for the normal and the user-only variants.
+    struct ToolJsonSpan {
+        uint32_t offset;
+        uint32_t length;
+    };
+    struct ToolsListPage {
+        std::vector<uint16_t> tools;        // Indices into tools_ / tool_json_spans_
+        size_t payload_size = 0;
+        const McpTool* next_tool = nullptr; // First tool of the next page, nullptr if last
+    };
+    struct ToolsListCache {
+        std::vector<ToolsListPage> pages;
+        std::unordered_map<std::string_view, size_t> cursor_pages;
+    };
+
+    std::mutex tools_list_mutex_;
+    bool tools_list_cache_valid_ = false;
+    std::string tools_json_arena_;
+    std::vector<ToolJsonSpan> tool_json_spans_;
+    ToolsListCache tools_list_cache_[2];    // [0] normal, [1] with user-only tools
+
+    // Worker pool for kToolExecutionWorker tools
+    std::mutex worker_mutex_;
+    std::condition_variable worker_cv_;
+    std::deque<std::shared_ptr<McpToolCall>> worker_queue_;
+    std::vector<std::shared_ptr<McpToolCall>> active_tool_calls_;
+    std::vector<const McpTool*> running_tools_;
+    int worker_count_ = 0;
+    esp_timer_handle_t tool_call_timer_ = nullptr;
+
+    // Guards the responses of JSON-RPC batches waiting for replies
+    std::mutex batch_mutex_;
+    // Bumped by CancelToolCalls(), batches from an older session are dropped instead of sent
+    uint32_t batch_generation_ = 0;
 };
 
 #endif // MCP_SERVER_H
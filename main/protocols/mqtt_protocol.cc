@@ -387,3 +387,7 @@ std::string MqttProtocol::DecodeHexString(const std::string& hex_string) {
 bool MqttProtocol::IsAudioChannelOpened() const {
     return udp_ != nullptr && !error_occurred_ && !IsTimeout();
 }
+
+bool MqttProtocol::IsConnected() const {
+    return mqtt_ != nullptr && mqtt_->IsConnected();
+}
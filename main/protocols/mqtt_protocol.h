@@ -33,6 +33,8 @@ public:
     bool OpenAudioChannel() override;
     void CloseAudioChannel(bool send_goodbye = true) override;
     bool IsAudioChannelOpened() const override;
+    // The MQTT control connection stays up between sessions
+    bool IsConnected() const override;
 
 private:
     // Alive flag for safe scheduled callbacks - set to false in destructor
@@ -73,6 +73,12 @@ void Protocol::SendStopListening() {
     SendText(message);
 }
 
+bool Protocol::SendTelemetry(const std::string& data, size_t count) {
+    std::string message = "{\"session_id\":\"" + session_id_ + "\",\"type\":\"telemetry\",\"format\":\"dv1\"";
+    message += ",\"count\":" + std::to_string(count) + ",\"data\":\"" + data + "\"}";
+    return SendText(message);
+}
+
 void Protocol::SendMcpMessage(const std::string& payload) {
     std::string message = "{\"session_id\":\"" + session_id_ + "\",\"type\":\"mcp\",\"payload\":" + payload + "}";
     SendText(message);
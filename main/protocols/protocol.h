@@ -67,12 +67,15 @@ public:
     virtual bool OpenAudioChannel() = 0;
     virtual void CloseAudioChannel(bool send_goodbye = true) = 0;
     virtual bool IsAudioChannelOpened() const = 0;
+    // Whether a message can be sent without opening a connection first
+    virtual bool IsConnected() const { return IsAudioChannelOpened(); }
     virtual bool SendAudio(std::unique_ptr<AudioStreamPacket> packet) = 0;
     virtual void SendWakeWordDetected(const std::string& wake_word);
     virtual void SendStartListening(ListeningMode mode);
     virtual void SendStopListening();
     virtual void SendAbortSpeaking(AbortReason reason);
     virtual void SendMcpMessage(const std::string& message);
+    virtual bool SendTelemetry(const std::string& data, size_t count);
     virtual bool SendText(const std::string& text) = 0;
 
 protected:
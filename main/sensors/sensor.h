@@ -0,0 +1,29 @@
+#ifndef SENSOR_H
+#define SENSOR_H
+
+#define SENSOR_MAX_CHANNELS 4
+
+enum SensorStatus {
+    kSensorStatusReady,  // Result parsed, measurement slot is free again
+    kSensorStatusBusy,   // Conversion still running, poll again later
+    kSensorStatusError,  // Bus failure, CRC mismatch, timeout or nothing pending
+};
+
+// Split-phase measurement interface implemented by every sensor driver.
+// The bus scheduler triggers conversions on several sensors back to back and
+// polls each one when its conversion time has elapsed, so the waits overlap.
+class Sensor {
+public:
+    virtual ~Sensor() = default;
+
+    virtual const char* GetName() const = 0;
+    virtual int GetChannelCount() const = 0;
+    virtual const char* GetChannelName(int channel) const = 0;
+    // Typical time from StartMeasurement() until PollResult() can succeed
+    virtual int GetConversionTimeMs() const = 0;
+    virtual bool StartMeasurement() = 0;
+    // On success writes GetChannelCount() values in channel order
+    virtual SensorStatus PollResult(float* values) = 0;
+};
+
+#endif // SENSOR_H
@@ -0,0 +1,224 @@
+#include "sensor_bus_scheduler.h"
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <algorithm>
+#include <cstring>
+
+#define TAG "SensorBusScheduler"
+
+// Result callbacks run on this stack: filtering, history, telemetry and rule evaluation, with
+// float logging. NVS writes and rule actions are handed to the main task by the callbacks.
+#define SENSOR_BUS_TASK_STACK_SIZE 6144
+#define SENSOR_BUS_TASK_PRIORITY 1
+// Re-poll interval once a conversion takes longer than advertised
+#define SENSOR_BUS_REPOLL_US (10 * 1000)
+#define SENSOR_BUS_STATS_INTERVAL_US (60 * 1000 * 1000)
+// Warn when less than this much of the task stack was ever left unused
+#define SENSOR_BUS_STACK_WARN_BYTES 1024
+
+SensorBusScheduler::SensorBusScheduler(const std::string& name, ResultCallback callback)
+    : name_(name), callback_(callback) {
+    auto ret = esp_pm_lock_create(ESP_PM_APB_FREQ_MAX, 0, "sensor_bus", &pm_lock_);
+    if (ret != ESP_OK) {
+        pm_lock_ = nullptr;
+    }
+}
+
+SensorBusScheduler::~SensorBusScheduler() {
+    if (task_handle_ != nullptr) {
+        vTaskDelete(task_handle_);
+    }
+    if (pm_lock_ != nullptr) {
+        esp_pm_lock_delete(pm_lock_);
+    }
+}
+
+bool SensorBusScheduler::AddSensor(Sensor* sensor, int period_ms) {
+    // Results are copied into fixed arrays of SENSOR_MAX_CHANNELS values
+    int channels = sensor->GetChannelCount();
+    if (channels <= 0 || channels > SENSOR_MAX_CHANNELS) {
+        ESP_LOGE(TAG, "%s: %s has %d channels, at most %d are supported", name_.c_str(), sensor->GetName(),
+            channels, SENSOR_MAX_CHANNELS);
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        int64_t now = esp_timer_get_time();
+        // First result as soon as one conversion allows
+        slots_.push_back(Slot{
+            .sensor = sensor,
+            .period_us = (int64_t)period_ms * 1000,
+            .due_us = now + sensor->GetConversionTimeMs() * 1000,
+            .poll_us = 0,
+            .measuring = false,
+            .failures = 0,
+        });
+    }
+    ESP_LOGI(TAG, "%s: added %s, period %d ms", name_.c_str(), sensor->GetName(), period_ms);
+    if (task_handle_ != nullptr) {
+        xTaskNotifyGive(task_handle_);
+    }
+    return true;
+}
+
+void SensorBusScheduler::SetPeriod(Sensor* sensor, int period_ms) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = std::find_if(slots_.begin(), slots_.end(), [sensor](const Slot& slot) {
+            return slot.sensor == sensor;
+        });
+        if (it == slots_.end() || it->period_us == (int64_t)period_ms * 1000) {
+            return;
+        }
+        // Re-base the next due time on the previous one, a running conversion keeps its result time
+        int64_t period_us = (int64_t)period_ms * 1000;
+        if (!it->measuring) {
+            int64_t earliest = esp_timer_get_time() + it->sensor->GetConversionTimeMs() * 1000;
+            it->due_us = std::max(earliest, it->due_us - it->period_us + period_us);
+        }
+        it->period_us = period_us;
+    }
+    ESP_LOGD(TAG, "%s: %s period set to %d ms", name_.c_str(), sensor->GetName(), period_ms);
+    if (task_handle_ != nullptr) {
+        xTaskNotifyGive(task_handle_);
+    }
+}
+
+void SensorBusScheduler::Start() {
+    stats_start_us_ = esp_timer_get_time();
+    xTaskCreate([](void* arg) {
+        static_cast<SensorBusScheduler*>(arg)->Run();
+    }, "sensor_bus", SENSOR_BUS_TASK_STACK_SIZE, this, SENSOR_BUS_TASK_PRIORITY, &task_handle_);
+}
+
+SensorBusStats SensorBusScheduler::GetStats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    SensorBusStats stats = stats_;
+    stats.window_us = esp_timer_get_time() - stats_start_us_;
+    return stats;
+}
+
+void SensorBusScheduler::Trigger(Slot& slot, int64_t now) {
+    stats_.transactions++;
+    if (!slot.sensor->StartMeasurement()) {
+        Complete(slot, nullptr, now);
+        return;
+    }
+    slot.measuring = true;
+    // Triggered ahead of the due time, so the result is fresh when it is delivered
+    slot.poll_us = std::max(now + slot.sensor->GetConversionTimeMs() * 1000, slot.due_us);
+}
+
+void SensorBusScheduler::Poll(Slot& slot, int64_t now) {
+    float values[SENSOR_MAX_CHANNELS];
+    stats_.transactions++;
+    switch (slot.sensor->PollResult(values)) {
+    case kSensorStatusBusy:
+        stats_.busy_polls++;
+        slot.poll_us = now + SENSOR_BUS_REPOLL_US;
+        break;
+    case kSensorStatusReady:
+        Complete(slot, values, now);
+        break;
+    default:
+        Complete(slot, nullptr, now);
+        break;
+    }
+}
+
+void SensorBusScheduler::Complete(Slot& slot, const float* values, int64_t now) {
+    slot.measuring = false;
+    Result result = {.sensor = slot.sensor, .ok = values != nullptr, .values = {}};
+    if (values != nullptr) {
+        memcpy(result.values, values, slot.sensor->GetChannelCount() * sizeof(float));
+    }
+    results_.push_back(result);
+
+    if (values == nullptr) {
+        stats_.errors++;
+        if (slot.failures++ == 0) {
+            ESP_LOGW(TAG, "%s: failed to read %s, keeping last reading", name_.c_str(), slot.sensor->GetName());
+        }
+    } else if (slot.failures > 0) {
+        ESP_LOGI(TAG, "%s: %s recovered after %d failed reads", name_.c_str(), slot.sensor->GetName(), slot.failures);
+        slot.failures = 0;
+    }
+
+    // Stay on the period grid, but skip missed periods instead of bursting to catch up
+    slot.due_us += slot.period_us;
+    if (slot.due_us <= now) {
+        slot.due_us = now + slot.period_us;
+    }
+}
+
+void SensorBusScheduler::Run() {
+    std::vector<Result> results;
+
+    while (true) {
+        int64_t next_wake = INT64_MAX;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            int64_t now = esp_timer_get_time();
+            int64_t bus_start = now;
+            stats_.wakeups++;
+            if (pm_lock_ != nullptr) {
+                esp_pm_lock_acquire(pm_lock_);
+            }
+
+            // Trigger every sensor whose conversion must start now, so the waits overlap
+            for (auto& slot : slots_) {
+                if (!slot.measuring && now >= slot.due_us - slot.sensor->GetConversionTimeMs() * 1000) {
+                    Trigger(slot, now);
+                }
+            }
+            for (auto& slot : slots_) {
+                if (slot.measuring && now >= slot.poll_us) {
+                    Poll(slot, now);
+                }
+            }
+            if (pm_lock_ != nullptr) {
+                esp_pm_lock_release(pm_lock_);
+            }
+            stats_.bus_time_us += esp_timer_get_time() - bus_start;
+            results.swap(results_);
+
+            for (auto& slot : slots_) {
+                int64_t wake = slot.measuring ? slot.poll_us : slot.due_us - slot.sensor->GetConversionTimeMs() * 1000;
+                next_wake = std::min(next_wake, wake);
+            }
+
+            if (now - stats_start_us_ > SENSOR_BUS_STATS_INTERVAL_US) {
+                int64_t window = now - stats_start_us_;
+                unsigned stack_free = uxTaskGetStackHighWaterMark(nullptr);
+                if (stack_free < SENSOR_BUS_STACK_WARN_BYTES) {
+                    ESP_LOGW(TAG, "%s: only %u bytes of stack left at the deepest point", name_.c_str(), stack_free);
+                }
+                ESP_LOGD(TAG, "%s: %lu transactions, %lu busy polls, %lu errors, bus busy %d.%02d%%, %lu wakeups/hour, "
+                    "stack free %u bytes",
+                    name_.c_str(), (unsigned long)stats_.transactions, (unsigned long)stats_.busy_polls,
+                    (unsigned long)stats_.errors, (int)(stats_.bus_time_us * 100 / window),
+                    (int)(stats_.bus_time_us * 10000 / window % 100),
+                    (unsigned long)(stats_.wakeups * 3600000000LL / window),
+                    stack_free);
+                stats_ = SensorBusStats();
+                stats_start_us_ = now;
+            }
+        }
+
+        // Callbacks run without the lock so they may register sensors or take other locks
+        for (auto& result : results) {
+            callback_(result.sensor, result.ok ? result.values : nullptr);
+        }
+        results.clear();
+
+        TickType_t ticks = portMAX_DELAY;
+        if (next_wake != INT64_MAX) {
+            int64_t delay_us = next_wake - esp_timer_get_time();
+            ticks = delay_us > 0 ? std::max<TickType_t>(1, pdMS_TO_TICKS((delay_us + 999) / 1000)) : 0;
+        }
+        if (ticks > 0) {
+            ulTaskNotifyTake(pdTRUE, ticks);
+        }
+    }
+}
@@ -0,0 +1,76 @@
+#ifndef SENSOR_BUS_SCHEDULER_H
+#define SENSOR_BUS_SCHEDULER_H
+
+#include "sensor.h"
+
+#include <esp_pm.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct SensorBusStats {
+    uint32_t transactions = 0;      // StartMeasurement / PollResult calls
+    uint32_t busy_polls = 0;        // Polls that found the conversion still running
+    uint32_t errors = 0;
+    uint32_t wakeups = 0;           // Times the scheduler task woke up to talk to the bus
+    int64_t bus_time_us = 0;        // Time spent inside driver calls
+    int64_t window_us = 0;          // Wall time the counters above were collected over
+};
+
+// Drives the sensors of one I2C bus from a single task. Conversions of all due
+// sensors are triggered back to back and each sensor is polled once its own
+// conversion time has elapsed, instead of every driver sleeping on its own.
+// Other I2cDevice users (codecs, PMICs, touch) keep talking to the bus directly,
+// the IDF master driver serializes their transactions with ours.
+class SensorBusScheduler {
+public:
+    // values is null when the measurement failed
+    using ResultCallback = std::function<void(Sensor* sensor, const float* values)>;
+
+    SensorBusScheduler(const std::string& name, ResultCallback callback);
+    ~SensorBusScheduler();
+
+    // Fails for sensors with more than SENSOR_MAX_CHANNELS channels
+    bool AddSensor(Sensor* sensor, int period_ms);
+    // Takes effect from the last delivered result, a shorter period can pull the next one in
+    void SetPeriod(Sensor* sensor, int period_ms);
+    void Start();
+    SensorBusStats GetStats();
+
+private:
+    struct Slot {
+        Sensor* sensor;
+        int64_t period_us;
+        int64_t due_us;         // When the next result should be delivered
+        int64_t poll_us;        // When to poll the running conversion
+        bool measuring;
+        int failures;
+    };
+
+    struct Result {
+        Sensor* sensor;
+        bool ok;
+        float values[SENSOR_MAX_CHANNELS];
+    };
+
+    std::string name_;
+    ResultCallback callback_;
+    std::mutex mutex_;
+    std::vector<Slot> slots_;
+    std::vector<Result> results_;   // Completed in this pass, delivered after the lock is released
+    TaskHandle_t task_handle_ = nullptr;
+    // Keeps the APB clock steady during transactions only; conversion waits may light sleep
+    esp_pm_lock_handle_t pm_lock_ = nullptr;
+    SensorBusStats stats_;
+    int64_t stats_start_us_ = 0;
+
+    void Run();
+    void Trigger(Slot& slot, int64_t now);
+    void Poll(Slot& slot, int64_t now);
+    void Complete(Slot& slot, const float* values, int64_t now);
+};
+
+#endif // SENSOR_BUS_SCHEDULER_H
@@ -0,0 +1,95 @@
+#include "sensor_filter.h"
+
+#include <esp_log.h>
+#include <algorithm>
+#include <cstdlib>
+
+#define TAG "SensorFilter"
+
+// Samples rejected in a row before a jump is accepted as a real change
+#define SENSOR_FILTER_MAX_REJECTS 3
+#define SENSOR_FILTER_STATE_SHIFT 8
+
+SensorFilter::SensorFilter(const SensorFilterConfig& config) : config_(config) {
+    config_.median_window = std::clamp(config_.median_window, 1, SENSOR_FILTER_MAX_MEDIAN_WINDOW);
+}
+
+void SensorFilter::Reset() {
+    window_count_ = 0;
+    window_index_ = 0;
+    has_last_ = false;
+    rejects_in_row_ = 0;
+    has_state_ = false;
+}
+
+bool SensorFilter::Process(int32_t value, int64_t time_us, int32_t& output) {
+    if (config_.max_rate > 0 && has_last_) {
+        int64_t elapsed_us = std::max<int64_t>(0, time_us - last_time_us_);
+        int64_t allowed = config_.max_rate * elapsed_us / 1000000 + config_.rate_margin;
+        if (std::abs((int64_t)value - last_value_) > allowed) {
+            if (++rejects_in_row_ <= SENSOR_FILTER_MAX_REJECTS) {
+                rejected_++;
+                output = output_;
+                return false;
+            }
+            ESP_LOGI(TAG, "Accepting a step from %ld to %ld after %d rejected samples",
+                (long)last_value_, (long)value, rejects_in_row_ - 1);
+            Reset();
+        }
+    }
+    rejects_in_row_ = 0;
+    has_last_ = true;
+    last_value_ = value;
+    last_time_us_ = time_us;
+
+    window_[window_index_] = value;
+    window_index_ = (window_index_ + 1) % config_.median_window;
+    window_count_ = std::min(window_count_ + 1, config_.median_window);
+
+    output_ = Smooth(Median());
+    output = output_;
+    return true;
+}
+
+int32_t SensorFilter::Median() const {
+    // Insertion sort of at most 7 values on the stack
+    int32_t sorted[SENSOR_FILTER_MAX_MEDIAN_WINDOW];
+    for (int i = 0; i < window_count_; i++) {
+        int32_t value = window_[i];
+        int j = i;
+        for (; j > 0 && sorted[j - 1] > value; j--) {
+            sorted[j] = sorted[j - 1];
+        }
+        sorted[j] = value;
+    }
+    return sorted[(window_count_ - 1) / 2];
+}
+
+int32_t SensorFilter::Smooth(int32_t value) {
+    int64_t measurement = (int64_t)value << SENSOR_FILTER_STATE_SHIFT;
+    if (!has_state_) {
+        has_state_ = true;
+        state_ = measurement;
+        variance_ = config_.kalman_measurement_noise;
+        return value;
+    }
+
+    switch (config_.smoothing) {
+    case kSensorFilterSmoothingEma:
+        state_ += (measurement - state_) >> config_.ema_shift;
+        break;
+    case kSensorFilterSmoothingKalman: {
+        // Constant-value model: predict, then blend in the reading by the gain (16 fractional bits)
+        variance_ += config_.kalman_process_noise;
+        int64_t gain = (variance_ << 16) / std::max<int64_t>(1, variance_ + config_.kalman_measurement_noise);
+        state_ += (gain * (measurement - state_)) >> 16;
+        variance_ -= (gain * variance_) >> 16;
+        break;
+    }
+    default:
+        state_ = measurement;
+        break;
+    }
+    // Round to nearest, the arithmetic shift alone would round towards negative infinity
+    return (int32_t)((state_ + (1 << (SENSOR_FILTER_STATE_SHIFT - 1))) >> SENSOR_FILTER_STATE_SHIFT);
+}
@@ -0,0 +1,61 @@
+#ifndef SENSOR_FILTER_H
+#define SENSOR_FILTER_H
+
+#include <cstdint>
+
+#define SENSOR_FILTER_MAX_MEDIAN_WINDOW 7
+
+enum SensorFilterSmoothing {
+    kSensorFilterSmoothingNone,
+    kSensorFilterSmoothingEma,
+    kSensorFilterSmoothingKalman,
+};
+
+// All values are fixed point in 0.01 units, the same as the history store
+struct SensorFilterConfig {
+    int median_window = 3;          // 1 disables the median stage
+    SensorFilterSmoothing smoothing = kSensorFilterSmoothingKalman;
+    int ema_shift = 2;              // EMA moves by 1/2^shift of the difference per sample
+    int32_t kalman_process_noise = 5;       // Variance added per sample, 0.01 units squared
+    int32_t kalman_measurement_noise = 100; // Variance of one reading, 0.01 units squared
+    int32_t max_rate = 0;           // Per second; 0 disables the rate check
+    int32_t rate_margin = 20;       // Allowed on top of max_rate for read noise
+};
+
+/*
+ * Filter for one channel: rate check -> median of N -> EMA or 1D Kalman.
+ *
+ * A sample that moved faster than max_rate since the last accepted one is rejected as
+ * an outlier. Several rejections in a row are taken as a real step (e.g. the device
+ * was moved) and restart the filter at the new value. Integer only, no allocation.
+ */
+class SensorFilter {
+public:
+    SensorFilter(const SensorFilterConfig& config = SensorFilterConfig());
+
+    // Returns false if the sample was rejected, output then holds the last filtered value
+    bool Process(int32_t value, int64_t time_us, int32_t& output);
+    // Forget the history, e.g. after the calibration offset changed
+    void Reset();
+    uint32_t rejected() const { return rejected_; }
+
+private:
+    SensorFilterConfig config_;
+    int32_t window_[SENSOR_FILTER_MAX_MEDIAN_WINDOW];
+    int window_count_ = 0;
+    int window_index_ = 0;
+    bool has_last_ = false;
+    int32_t last_value_ = 0;        // Last accepted raw value, for the rate check
+    int64_t last_time_us_ = 0;
+    int rejects_in_row_ = 0;
+    uint32_t rejected_ = 0;
+    bool has_state_ = false;
+    int64_t state_ = 0;             // Smoothed value, 8 fractional bits
+    int64_t variance_ = 0;          // Kalman estimate variance
+    int32_t output_ = 0;
+
+    int32_t Median() const;
+    int32_t Smooth(int32_t value);
+};
+
+#endif // SENSOR_FILTER_H
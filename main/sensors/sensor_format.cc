@@ -0,0 +1,81 @@
+#include "sensor_format.h"
+
+namespace {
+
+// Appends text at offset, keeping room for the terminator. Only whole UTF-8
+// characters are copied, a cut "°" would not render.
+size_t Append(char* buffer, size_t size, size_t offset, const char* text) {
+    if (size == 0) {
+        return 0;
+    }
+    while (*text != '\0') {
+        size_t length = 1;
+        while ((text[length] & 0xC0) == 0x80) {
+            length++;
+        }
+        if (offset + length >= size) {
+            break;
+        }
+        for (size_t i = 0; i < length; i++) {
+            buffer[offset++] = *text++;
+        }
+    }
+    buffer[offset] = '\0';
+    return offset;
+}
+
+} // namespace
+
+size_t FormatFixed(char* buffer, size_t size, int32_t value, int decimals) {
+    if (size == 0) {
+        return 0;
+    }
+
+    decimals = decimals < 0 ? 0 : (decimals > 2 ? 2 : decimals);
+    bool negative = value < 0;
+    uint32_t magnitude = negative ? 0u - (uint32_t)value : (uint32_t)value;
+    uint32_t divisor = decimals == 2 ? 1 : (decimals == 1 ? 10 : 100);
+    magnitude = (magnitude + divisor / 2) / divisor;
+    // No "-0.0" when the value rounds to zero
+    negative &= magnitude != 0;
+
+    // Digits are produced backwards into a scratch buffer, then copied in order
+    char digits[16];
+    int count = 0;
+    do {
+        if (count == decimals && decimals > 0) {
+            digits[count++] = '.';
+        }
+        digits[count++] = '0' + magnitude % 10;
+        magnitude /= 10;
+    } while (magnitude > 0 || count <= decimals);
+    if (negative) {
+        digits[count++] = '-';
+    }
+
+    size_t length = 0;
+    while (count > 0 && length + 1 < size) {
+        buffer[length++] = digits[--count];
+    }
+    buffer[length] = '\0';
+    return length;
+}
+
+size_t FormatTemperature(char* buffer, size_t size, int32_t temperature) {
+    size_t length = FormatFixed(buffer, size, temperature, 1);
+    return Append(buffer, size, length, "°C");
+}
+
+size_t FormatHumidity(char* buffer, size_t size, int32_t humidity) {
+    size_t length = FormatFixed(buffer, size, humidity, 1);
+    return Append(buffer, size, length, "%");
+}
+
+size_t FormatTemperatureHumidity(char* buffer, size_t size, int32_t temperature, int32_t humidity) {
+    size_t length = FormatTemperature(buffer, size, temperature);
+    length = Append(buffer, size, length, " / ");
+    if (length + 1 < size) {
+        length += FormatHumidity(buffer + length, size - length, humidity);
+    }
+    return length;
+}
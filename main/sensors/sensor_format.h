@@ -0,0 +1,20 @@
+#ifndef SENSOR_FORMAT_H
+#define SENSOR_FORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Formatting of 0.01 unit fixed-point readings into caller buffers, without printf's
+// float support or any allocation. Output is always terminated and truncated to fit;
+// the return value is the length written.
+
+// e.g. 2345 -> "23.5" with 1 decimal, "23.45" with 2; rounds half away from zero
+size_t FormatFixed(char* buffer, size_t size, int32_t value, int decimals);
+// "23.5°C"
+size_t FormatTemperature(char* buffer, size_t size, int32_t temperature);
+// "45.2%"
+size_t FormatHumidity(char* buffer, size_t size, int32_t humidity);
+// "23.5°C / 45.2%", the standby screen format
+size_t FormatTemperatureHumidity(char* buffer, size_t size, int32_t temperature, int32_t humidity);
+
+#endif // SENSOR_FORMAT_H
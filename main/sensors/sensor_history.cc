@@ -0,0 +1,414 @@
+#include "sensor_history.h"
+#include "settings.h"
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <esp_heap_caps.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#define TAG "SensorHistory"
+
+// Queries scan at most this many entries; coarser levels are used beyond it
+#define SENSOR_HISTORY_MAX_SCAN 720
+// The snapshot covers the whole hourly level (30 days): the last week at 1 h and the
+// older days merged into 6 h buckets, ~4 KB instead of 11.5 KB, so it fits the 16 KB NVS
+// partition most boards have
+#define SENSOR_HISTORY_SNAPSHOT_HOURS 168
+#define SENSOR_HISTORY_SNAPSHOT_COARSE_HOURS 6
+#define SENSOR_HISTORY_SNAPSHOT_VERSION 1
+
+// Raw samples: 1 h at 1 s; minute: 24 h; quarter: 7 days; hour: 30 days
+const uint32_t SensorHistory::kLevelSpan[kLevelCount] = {1, 60, 15 * 60, 60 * 60};
+const size_t SensorHistory::kLevelCapacity[kLevelCount] = {3600, 24 * 60, 7 * 24 * 4, 30 * 24};
+
+namespace {
+
+struct SnapshotHeader {
+    uint16_t version;
+    uint16_t count;
+    uint32_t base_hour;
+};
+
+struct SnapshotEntry {
+    uint16_t hour_offset;
+    uint16_t count;
+    int16_t temperature_min;
+    int16_t temperature_max;
+    int16_t temperature_mean;
+    uint16_t humidity_min;
+    uint16_t humidity_max;
+    uint16_t humidity_mean;
+};
+
+uint32_t SampleTime(const SensorHistorySample& sample) {
+    return sample.time;
+}
+
+uint32_t BucketStart(const SensorHistoryBucket& bucket) {
+    return bucket.start;
+}
+
+SensorHistoryBucket SampleBucket(const SensorHistorySample& sample) {
+    return SensorHistoryBucket{
+        .start = sample.time,
+        .count = 1,
+        .temperature_min = sample.temperature,
+        .temperature_max = sample.temperature,
+        .humidity_min = sample.humidity,
+        .humidity_max = sample.humidity,
+        .temperature_sum = sample.temperature,
+        .humidity_sum = sample.humidity,
+    };
+}
+
+} // namespace
+
+SensorHistory::SensorHistory() {
+}
+
+SensorHistory::~SensorHistory() {
+    if (memory_ != nullptr) {
+        heap_caps_free(memory_);
+    }
+}
+
+bool SensorHistory::Initialize() {
+    size_t raw_size = kLevelCapacity[kLevelRaw] * sizeof(SensorHistorySample);
+    size_t total_size = raw_size;
+    for (int level = kLevelMinute; level < kLevelCount; level++) {
+        total_size += kLevelCapacity[level] * sizeof(SensorHistoryBucket);
+    }
+
+    memory_ = heap_caps_malloc(total_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (memory_ == nullptr) {
+        ESP_LOGW(TAG, "No PSRAM for sensor history (%u bytes), history disabled", total_size);
+        return false;
+    }
+
+    auto ptr = static_cast<uint8_t*>(memory_);
+    raw_.Attach(reinterpret_cast<SensorHistorySample*>(ptr), kLevelCapacity[kLevelRaw]);
+    ptr += raw_size;
+    for (int level = kLevelMinute; level < kLevelCount; level++) {
+        rollups_[level].Attach(reinterpret_cast<SensorHistoryBucket*>(ptr), kLevelCapacity[level]);
+        ptr += kLevelCapacity[level] * sizeof(SensorHistoryBucket);
+    }
+
+    LoadSnapshot();
+    ESP_LOGI(TAG, "Sensor history initialized, %u bytes in PSRAM", total_size);
+    return true;
+}
+
+void SensorHistory::MergeBucket(SensorHistoryBucket& into, const SensorHistoryBucket& from) {
+    if (into.count == 0) {
+        uint32_t start = into.start;
+        into = from;
+        into.start = start;
+        return;
+    }
+    into.count += from.count;
+    into.temperature_min = std::min(into.temperature_min, from.temperature_min);
+    into.temperature_max = std::max(into.temperature_max, from.temperature_max);
+    into.humidity_min = std::min(into.humidity_min, from.humidity_min);
+    into.humidity_max = std::max(into.humidity_max, from.humidity_max);
+    into.temperature_sum += from.temperature_sum;
+    into.humidity_sum += from.humidity_sum;
+}
+
+void SensorHistory::Ingest(uint32_t time, float temperature, float humidity) {
+    if (memory_ == nullptr) {
+        return;
+    }
+
+    int64_t start_time = esp_timer_get_time();
+    SensorHistorySample sample = {
+        .time = time,
+        .temperature = (int16_t)std::clamp<long>(std::lround(temperature * 100.0f), INT16_MIN, INT16_MAX),
+        .humidity = (uint16_t)std::clamp<long>(std::lround(humidity * 100.0f), 0, 10000),
+    };
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!raw_.empty() && time <= raw_.back().time) {
+        if (time + kLevelSpan[kLevelHour] < raw_.back().time) {
+            // The wall clock moved back by a lot, the stored timeline can no longer be trusted
+            ESP_LOGW(TAG, "Clock moved back from %lu to %lu, clearing history",
+                (unsigned long)raw_.back().time, (unsigned long)time);
+            raw_.clear();
+            for (int level = kLevelMinute; level < kLevelCount; level++) {
+                rollups_[level].clear();
+            }
+        } else {
+            return;
+        }
+    }
+
+    raw_.push_back(sample);
+    auto sample_bucket = SampleBucket(sample);
+    for (int level = kLevelMinute; level < kLevelCount; level++) {
+        auto& ring = rollups_[level];
+        uint32_t start = time - time % kLevelSpan[level];
+        if (ring.empty() || ring.back().start < start) {
+            SensorHistoryBucket bucket = {};
+            bucket.start = start;
+            ring.push_back(bucket);
+        }
+        // A restored snapshot may end after the current time right after a clock jump
+        if (ring.back().start == start) {
+            MergeBucket(ring.back(), sample_bucket);
+        }
+    }
+
+    int64_t cost = esp_timer_get_time() - start_time;
+    ingest_max_us_ = std::max(ingest_max_us_, cost);
+    if (++ingest_count_ % 1024 == 0) {
+        ESP_LOGD(TAG, "Ingested %lu samples, max cost %d us", (unsigned long)ingest_count_, (int)ingest_max_us_);
+        ingest_max_us_ = 0;
+    }
+}
+
+size_t SensorHistory::CountInRange(Level level, uint32_t from, uint32_t to, size_t& first) const {
+    size_t last;
+    if (level == kLevelRaw) {
+        first = raw_.lower_bound(from, SampleTime);
+        last = raw_.lower_bound(to, SampleTime);
+    } else {
+        first = rollups_[level].lower_bound(from, BucketStart);
+        last = rollups_[level].lower_bound(to, BucketStart);
+    }
+    return last - first;
+}
+
+int SensorHistory::SelectLevel(int finest, uint32_t from, uint32_t to, size_t max_count, size_t& first, size_t& count) const {
+    // The finest level that still holds `from` within the budget wins. Otherwise fall back to
+    // the level reaching furthest back, e.g. the hourly buckets restored after a reboot.
+    int best = -1;
+    uint32_t best_oldest = UINT32_MAX;
+    size_t best_first = 0;
+    size_t best_count = 0;
+    for (int level = finest; level < kLevelCount; level++) {
+        bool empty = level == kLevelRaw ? raw_.empty() : rollups_[level].empty();
+        if (empty) {
+            continue;
+        }
+        uint32_t oldest = level == kLevelRaw ? raw_.at(0).time : rollups_[level].at(0).start;
+        size_t level_first;
+        size_t level_count = CountInRange((Level)level, from, to, level_first);
+        if (oldest <= from && level_count <= max_count) {
+            first = level_first;
+            count = level_count;
+            return level;
+        }
+        // Between levels reaching equally far back, a coarser one wins if it cuts an over-budget scan
+        bool smaller = oldest == best_oldest && best_count > max_count && level_count < best_count;
+        if (best < 0 || oldest < best_oldest || smaller) {
+            best = level;
+            best_oldest = oldest;
+            best_first = level_first;
+            best_count = level_count;
+        }
+    }
+    first = best_first;
+    count = best_count;
+    return best;
+}
+
+bool SensorHistory::GetStats(uint32_t from, uint32_t to, SensorHistoryStats& stats) {
+    if (memory_ == nullptr || from >= to) {
+        return false;
+    }
+
+    int64_t start_time = esp_timer_get_time();
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    size_t first, count;
+    int level = SelectLevel(kLevelRaw, from, to, SENSOR_HISTORY_MAX_SCAN, first, count);
+    if (level < 0 || count == 0) {
+        return false;
+    }
+
+    SensorHistoryBucket total = {};
+    for (size_t i = first; i < first + count; i++) {
+        if (level == kLevelRaw) {
+            MergeBucket(total, SampleBucket(raw_.at(i)));
+        } else {
+            MergeBucket(total, rollups_[level].at(i));
+        }
+    }
+
+    if (level == kLevelRaw) {
+        stats.start = raw_.at(first).time;
+        stats.end = raw_.at(first + count - 1).time + 1;
+    } else {
+        stats.start = rollups_[level].at(first).start;
+        stats.end = rollups_[level].at(first + count - 1).start + kLevelSpan[level];
+    }
+    stats.count = total.count;
+    stats.temperature_min = total.temperature_min / 100.0f;
+    stats.temperature_max = total.temperature_max / 100.0f;
+    stats.temperature_mean = total.temperature_sum / 100.0f / total.count;
+    stats.humidity_min = total.humidity_min / 100.0f;
+    stats.humidity_max = total.humidity_max / 100.0f;
+    stats.humidity_mean = total.humidity_sum / 100.0f / total.count;
+
+    ESP_LOGD(TAG, "Stats over %lu s from level %d: %u entries in %d us", (unsigned long)(to - from),
+        level, count, (int)(esp_timer_get_time() - start_time));
+    return true;
+}
+
+size_t SensorHistory::GetSeries(uint32_t from, uint32_t to, SensorHistoryBucket* buckets, size_t max_points) {
+    if (memory_ == nullptr || from >= to || max_points == 0) {
+        return 0;
+    }
+
+    int64_t start_time = esp_timer_get_time();
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    size_t first, count;
+    int level = SelectLevel(kLevelMinute, from, to, max_points, first, count);
+    if (level < 0 || count == 0) {
+        return 0;
+    }
+
+    auto& ring = rollups_[level];
+    size_t group = (count + max_points - 1) / max_points;
+    size_t points = 0;
+    for (size_t i = 0; i < count; i += group) {
+        auto& bucket = buckets[points++];
+        bucket = ring.at(first + i);
+        for (size_t j = i + 1; j < std::min(i + group, count); j++) {
+            MergeBucket(bucket, ring.at(first + j));
+        }
+    }
+
+    ESP_LOGD(TAG, "Series over %lu s from level %d: %u buckets into %u points in %d us",
+        (unsigned long)(to - from), level, count, points, (int)(esp_timer_get_time() - start_time));
+    return points;
+}
+
+void SensorHistory::SaveSnapshot() {
+    if (memory_ == nullptr) {
+        return;
+    }
+
+    std::vector<uint8_t> blob;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& ring = rollups_[kLevelHour];
+        // The newest bucket is still open, only closed hours are persisted
+        if (ring.size() < 2) {
+            return;
+        }
+        size_t closed = ring.size() - 1;
+        uint32_t newest_hour = ring.at(closed - 1).start / kLevelSpan[kLevelHour];
+        if (newest_hour <= last_snapshot_hour_) {
+            return;
+        }
+
+        // Hours before the last week are merged into coarse buckets. Buckets restored from an
+        // earlier snapshot are already aligned to them and map onto themselves.
+        uint32_t coarse_span = SENSOR_HISTORY_SNAPSHOT_COARSE_HOURS * kLevelSpan[kLevelHour];
+        uint32_t fine_start = (newest_hour + 1 - std::min<uint32_t>(newest_hour + 1, SENSOR_HISTORY_SNAPSHOT_HOURS)) *
+            kLevelSpan[kLevelHour];
+        // Restored coarse buckets leave the ring spanning more than 30 days, keep the size bounded
+        uint32_t oldest_start = (newest_hour + 1 - std::min<uint32_t>(newest_hour + 1, kLevelCapacity[kLevelHour])) *
+            kLevelSpan[kLevelHour];
+        std::vector<SensorHistoryBucket> buckets;
+        for (size_t i = 0; i < closed; i++) {
+            auto& bucket = ring.at(i);
+            if (bucket.count == 0 || bucket.start < oldest_start) {
+                continue;
+            }
+            if (bucket.start >= fine_start) {
+                buckets.push_back(bucket);
+                continue;
+            }
+            uint32_t start = bucket.start - bucket.start % coarse_span;
+            if (!buckets.empty() && buckets.back().start == start) {
+                MergeBucket(buckets.back(), bucket);
+            } else {
+                buckets.push_back(bucket);
+                buckets.back().start = start;
+            }
+        }
+        if (buckets.empty()) {
+            return;
+        }
+
+        // 30 days of hours always fit the 16-bit offsets
+        uint32_t base_hour = buckets.front().start / kLevelSpan[kLevelHour];
+        SnapshotHeader header = {
+            .version = SENSOR_HISTORY_SNAPSHOT_VERSION,
+            .count = (uint16_t)buckets.size(),
+            .base_hour = base_hour,
+        };
+        blob.resize(sizeof(header) + header.count * sizeof(SnapshotEntry));
+        memcpy(blob.data(), &header, sizeof(header));
+        auto entries = reinterpret_cast<SnapshotEntry*>(blob.data() + sizeof(header));
+        for (size_t i = 0; i < header.count; i++) {
+            auto& bucket = buckets[i];
+            entries[i] = SnapshotEntry{
+                .hour_offset = (uint16_t)(bucket.start / kLevelSpan[kLevelHour] - base_hour),
+                .count = (uint16_t)std::min<uint32_t>(bucket.count, UINT16_MAX),
+                .temperature_min = bucket.temperature_min,
+                .temperature_max = bucket.temperature_max,
+                .temperature_mean = (int16_t)(bucket.temperature_sum / bucket.count),
+                .humidity_min = bucket.humidity_min,
+                .humidity_max = bucket.humidity_max,
+                .humidity_mean = (uint16_t)(bucket.humidity_sum / bucket.count),
+            };
+        }
+        last_snapshot_hour_ = newest_hour;
+    }
+
+    // NVS spreads writes over its pages itself, the caller only needs to keep saves infrequent
+    Settings settings("sensor_history", true);
+    if (settings.SetBlob("hourly", blob.data(), blob.size())) {
+        ESP_LOGI(TAG, "Saved history snapshot: %u bytes", blob.size());
+    }
+}
+
+void SensorHistory::LoadSnapshot() {
+    Settings settings("sensor_history");
+    auto blob = settings.GetBlob("hourly");
+    if (blob.size() < sizeof(SnapshotHeader)) {
+        return;
+    }
+
+    SnapshotHeader header;
+    memcpy(&header, blob.data(), sizeof(header));
+    if (header.version != SENSOR_HISTORY_SNAPSHOT_VERSION ||
+        blob.size() != sizeof(header) + header.count * sizeof(SnapshotEntry)) {
+        ESP_LOGW(TAG, "Ignoring invalid history snapshot (%u bytes)", blob.size());
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& ring = rollups_[kLevelHour];
+    auto entries = reinterpret_cast<const SnapshotEntry*>(blob.data() + sizeof(header));
+    for (size_t i = 0; i < header.count; i++) {
+        auto& entry = entries[i];
+        if (entry.count == 0) {
+            continue;
+        }
+        uint32_t start = (header.base_hour + entry.hour_offset) * kLevelSpan[kLevelHour];
+        if (!ring.empty() && ring.back().start >= start) {
+            continue;
+        }
+        ring.push_back(SensorHistoryBucket{
+            .start = start,
+            .count = entry.count,
+            .temperature_min = entry.temperature_min,
+            .temperature_max = entry.temperature_max,
+            .humidity_min = entry.humidity_min,
+            .humidity_max = entry.humidity_max,
+            .temperature_sum = (int64_t)entry.temperature_mean * entry.count,
+            .humidity_sum = (int64_t)entry.humidity_mean * entry.count,
+        });
+    }
+    if (!ring.empty()) {
+        last_snapshot_hour_ = ring.back().start / kLevelSpan[kLevelHour];
+    }
+    ESP_LOGI(TAG, "Restored %u hourly buckets from snapshot", ring.size());
+}
@@ -0,0 +1,139 @@
+#ifndef SENSOR_HISTORY_H
+#define SENSOR_HISTORY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+// Fixed-point values: temperature in 0.01°C, humidity in 0.01 %RH
+struct SensorHistorySample {
+    uint32_t time;          // Unix time in seconds
+    int16_t temperature;
+    uint16_t humidity;
+};
+
+struct SensorHistoryBucket {
+    uint32_t start;         // Unix time of the bucket start, aligned to the bucket span
+    uint32_t count;
+    int16_t temperature_min;
+    int16_t temperature_max;
+    uint16_t humidity_min;
+    uint16_t humidity_max;
+    // 64-bit so merged buckets can span the whole 30 days of 1 s samples
+    int64_t temperature_sum;
+    int64_t humidity_sum;
+};
+
+struct SensorHistoryStats {
+    uint32_t start = 0;
+    uint32_t end = 0;
+    uint32_t count = 0;
+    float temperature_min = 0.0f;
+    float temperature_max = 0.0f;
+    float temperature_mean = 0.0f;
+    float humidity_min = 0.0f;
+    float humidity_max = 0.0f;
+    float humidity_mean = 0.0f;
+};
+
+// Ring buffer sorted by time, with the oldest element at logical index 0
+template <typename T>
+class SensorHistoryRing {
+public:
+    void Attach(T* buffer, size_t capacity) {
+        buffer_ = buffer;
+        capacity_ = capacity;
+        head_ = 0;
+        size_ = 0;
+    }
+
+    size_t size() const { return size_; }
+    size_t capacity() const { return capacity_; }
+    bool empty() const { return size_ == 0; }
+    T& at(size_t index) { return buffer_[(head_ + capacity_ - size_ + index) % capacity_]; }
+    const T& at(size_t index) const { return buffer_[(head_ + capacity_ - size_ + index) % capacity_]; }
+    T& back() { return at(size_ - 1); }
+
+    void push_back(const T& value) {
+        buffer_[head_] = value;
+        head_ = (head_ + 1) % capacity_;
+        if (size_ < capacity_) {
+            size_++;
+        }
+    }
+
+    void clear() {
+        head_ = 0;
+        size_ = 0;
+    }
+
+    void pop_front(size_t count) {
+        size_ -= count < size_ ? count : size_;
+    }
+
+    // First logical index whose time is not before `time`
+    template <typename TimeOf>
+    size_t lower_bound(uint32_t time, TimeOf time_of) const {
+        size_t low = 0, high = size_;
+        while (low < high) {
+            size_t mid = (low + high) / 2;
+            if (time_of(at(mid)) < time) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+        return low;
+    }
+
+private:
+    T* buffer_ = nullptr;
+    size_t capacity_ = 0;
+    size_t head_ = 0;
+    size_t size_ = 0;
+};
+
+// 温湿度历史记录：原始采样环形缓冲 + 1分钟/15分钟/1小时三级汇总，存放在 PSRAM 中
+class SensorHistory {
+public:
+    enum Level {
+        kLevelRaw,
+        kLevelMinute,
+        kLevelQuarter,
+        kLevelHour,
+        kLevelCount,
+    };
+
+    SensorHistory();
+    ~SensorHistory();
+
+    bool Initialize();
+    // O(1): appends to the raw ring and updates the open bucket of each rollup level
+    void Ingest(uint32_t time, float temperature, float humidity);
+    bool GetStats(uint32_t from, uint32_t to, SensorHistoryStats& stats);
+    // Downsampled rollup buckets covering [from, to), at most max_points entries
+    size_t GetSeries(uint32_t from, uint32_t to, SensorHistoryBucket* buckets, size_t max_points);
+
+    // Persists the hourly rollups to NVS, the last week at 1 h and the rest of the 30 days at 6 h.
+    // Skipped if nothing new was closed since the last save.
+    void SaveSnapshot();
+    void LoadSnapshot();
+
+private:
+    std::mutex mutex_;
+    void* memory_ = nullptr;
+    SensorHistoryRing<SensorHistorySample> raw_;
+    SensorHistoryRing<SensorHistoryBucket> rollups_[kLevelCount];
+    uint32_t last_snapshot_hour_ = 0;
+    uint32_t ingest_count_ = 0;
+    int64_t ingest_max_us_ = 0;
+
+    static const uint32_t kLevelSpan[kLevelCount];
+    static const size_t kLevelCapacity[kLevelCount];
+
+    int SelectLevel(int finest, uint32_t from, uint32_t to, size_t max_count, size_t& first, size_t& count) const;
+    size_t CountInRange(Level level, uint32_t from, uint32_t to, size_t& first) const;
+    static void MergeBucket(SensorHistoryBucket& into, const SensorHistoryBucket& from);
+};
+
+#endif // SENSOR_HISTORY_H
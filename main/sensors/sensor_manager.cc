@@ -1,17 +1,53 @@
 #include "sensor_manager.h"
+#include "sensor_format.h"
 #include "settings.h"
+#include "board.h"
+#include "application.h"
 #include <esp_log.h>
-#include <sstream>
-#include <iomanip>
+#include <esp_timer.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
 
 #define TAG "SensorManager"
 
+// 超过若干个采样周期没有新数据时，认为读数已失效（采样周期会在最短和最长之间自适应）
+#define SENSOR_READING_STALE_US std::max(CONFIG_DHT20_SAMPLE_INTERVAL_MS * 10LL, CONFIG_DHT20_MAX_SAMPLE_INTERVAL_MS * 3LL) * 1000
+// 相邻两次滤波后读数变化超过该值（0.01 单位）时回到最短采样周期，否则周期逐步加倍
+#define SENSOR_ADAPT_TEMPERATURE_STEP 10
+#define SENSOR_ADAPT_HUMIDITY_STEP 50
+// 历史数据快照写入 NVS 的最小间隔，减少 Flash 磨损
+#define SENSOR_HISTORY_SNAPSHOT_INTERVAL_US (4LL * 3600 * 1000 * 1000)
+
 SensorManager& SensorManager::GetInstance() {
     static SensorManager instance;
     return instance;
 }
 
-SensorManager::SensorManager() {
+namespace {
+
+SensorFilterConfig MakeFilterConfig(int32_t max_rate) {
+    SensorFilterConfig config;
+    config.median_window = CONFIG_SENSOR_FILTER_MEDIAN_WINDOW;
+#if defined(CONFIG_SENSOR_FILTER_SMOOTHING_EMA)
+    config.smoothing = kSensorFilterSmoothingEma;
+    config.ema_shift = CONFIG_SENSOR_FILTER_EMA_SHIFT;
+#elif defined(CONFIG_SENSOR_FILTER_SMOOTHING_KALMAN)
+    config.smoothing = kSensorFilterSmoothingKalman;
+#else
+    config.smoothing = kSensorFilterSmoothingNone;
+#endif
+    config.max_rate = max_rate;
+    return config;
+}
+
+} // namespace
+
+SensorManager::SensorManager()
+    : temperature_filter_(MakeFilterConfig(CONFIG_SENSOR_FILTER_MAX_TEMPERATURE_RATE)),
+      humidity_filter_(MakeFilterConfig(CONFIG_SENSOR_FILTER_MAX_HUMIDITY_RATE)) {
 }
 
 SensorManager::~SensorManager() {
@@ -28,68 +64,356 @@ bool SensorManager::Initialize(i2c_master_bus_handle_t i2c_bus) {
     try {
         // Initialize DHT20 sensor
         ESP_LOGI(TAG, "Creating DHT20 sensor instance");
-        dht20_ = std::make_unique<DHT20>(i2c_bus);
+#ifdef CONFIG_DHT20_SIMULATOR
+        // 模拟传感器：以一天为周期缓慢变化，便于在没有硬件时验证整个数据链路
+        (void)i2c_bus; // Unused parameter
+        dht20_simulator_ = std::make_unique<DHT20Simulator>();
+        dht20_simulator_->SetScript([](int64_t time_us, float& temperature, float& humidity) {
+            float phase = 2.0f * (float)M_PI * (float)(time_us % (24LL * 3600 * 1000000)) / (24.0f * 3600 * 1000000);
+            temperature = 24.0f + 3.0f * sinf(phase);
+            humidity = 50.0f - 10.0f * sinf(phase);
+        });
+        auto dht20 = std::make_unique<DHT20>(dht20_simulator_.get());
+#else
+        auto dht20 = std::make_unique<DHT20>(i2c_bus);
+#endif
         ESP_LOGI(TAG, "DHT20 sensor instance created successfully");
         
-        if (!dht20_->Initialize()) {
+        if (!dht20->Initialize()) {
             ESP_LOGE(TAG, "Failed to initialize DHT20 sensor");
-            dht20_.reset();
             return false;
         }
 
+        dht20_ = dht20.get();
+        sensors_.push_back(RegisteredSensor{.sensor = std::move(dht20)});
         initialized_ = true;
         
         // Load calibration parameters
         LoadCalibration();
+
+        history_available_ = history_.Initialize();
+#ifdef CONFIG_SENSOR_TELEMETRY
+        telemetry_ = std::make_unique<SensorTelemetry>();
+#endif
+        rules_.Load();
+
+        last_snapshot_time_ = esp_timer_get_time();
+
+        // 总线调度任务周期性采样，UI 和主循环只读取缓存的最新值
+        scheduler_ = std::make_unique<SensorBusScheduler>("i2c0", [this](Sensor* sensor, const float* values) {
+            OnSensorResult(sensor, values);
+        });
+        scheduler_->AddSensor(dht20_, CONFIG_DHT20_SAMPLE_INTERVAL_MS);
+        scheduler_->Start();
         
-        ESP_LOGI(TAG, "Sensor manager initialized successfully");
+        ESP_LOGI(TAG, "Sensor manager initialized successfully, sample interval %d-%d ms",
+            CONFIG_DHT20_SAMPLE_INTERVAL_MS, CONFIG_DHT20_MAX_SAMPLE_INTERVAL_MS);
         return true;
     } catch (const std::exception& e) {
         ESP_LOGE(TAG, "Exception during sensor initialization: %s", e.what());
-        dht20_.reset();
         return false;
     } catch (...) {
         ESP_LOGE(TAG, "Unknown exception during sensor initialization");
-        dht20_.reset();
         return false;
     }
 }
 
-bool SensorManager::ReadTemperatureHumidity(float& temperature, float& humidity) {
+bool SensorManager::IsInitialized() const {
     std::lock_guard<std::mutex> lock(mutex_);
+    return initialized_;
+}
 
-    if (!initialized_ || !dht20_) {
+bool SensorManager::RegisterSensor(std::unique_ptr<Sensor> sensor, int period_ms) {
+    if (!scheduler_) {
         ESP_LOGE(TAG, "Sensor manager not initialized");
         return false;
     }
 
-    bool result = dht20_->ReadData(temperature, humidity);
-    if (result) {
-        ESP_LOGI(TAG, "Successfully read temperature: %.2f°C, humidity: %.2f%%", temperature, humidity);
+    // Owned before the scheduler can deliver a result for it
+    Sensor* raw_sensor = sensor.get();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        sensors_.push_back(RegisteredSensor{.sensor = std::move(sensor)});
     }
-    return result;
+    if (!scheduler_->AddSensor(raw_sensor, period_ms)) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        sensors_.erase(std::find_if(sensors_.begin(), sensors_.end(), [raw_sensor](const RegisteredSensor& registered) {
+            return registered.sensor.get() == raw_sensor;
+        }));
+        return false;
+    }
+    return true;
 }
 
-std::string SensorManager::GetTemperatureHumidityString() {
-    float temperature, humidity;
-    if (ReadTemperatureHumidity(temperature, humidity)) {
-        std::stringstream ss;
-        ss << std::fixed << std::setprecision(1);
-        ss << temperature << "°C / " << humidity << "%";
-        return ss.str();
+void SensorManager::OnSensorResult(Sensor* sensor, const float* values) {
+    if (values == nullptr) {
+        return;
+    }
+
+    int64_t now = esp_timer_get_time();
+    float filtered[2];
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (sensor == dht20_) {
+            // 定点滤波：剔除跳变并平滑抖动，被剔除的样本沿用上一次的滤波值
+            int32_t temperature, humidity;
+            bool accepted = temperature_filter_.Process((int32_t)lroundf(values[0] * 100.0f), now, temperature);
+            accepted &= humidity_filter_.Process((int32_t)lroundf(values[1] * 100.0f), now, humidity);
+            if (!accepted) {
+                ESP_LOGD(TAG, "Rejected outlier %.2f°C / %.2f%%, %lu rejected so far", values[0], values[1],
+                    (unsigned long)(temperature_filter_.rejected() + humidity_filter_.rejected()));
+            }
+            filtered[0] = temperature / 100.0f;
+            filtered[1] = humidity / 100.0f;
+            values = filtered;
+            AdaptSamplePeriod(temperature, humidity);
+        }
+
+        for (auto& registered : sensors_) {
+            if (registered.sensor.get() == sensor) {
+                memcpy(registered.values, values, sensor->GetChannelCount() * sizeof(float));
+                registered.timestamp_us = now;
+                break;
+            }
+        }
+    }
+
+    // DHT20 是主温湿度传感器，供待机画面、设备状态和历史记录使用
+    if (sensor == dht20_) {
+        UpdateSamplePeriod();
+        PublishReading(values[0], values[1], now);
+        RecordSample(values[0], values[1]);
+        // 规则使用单调时钟，不依赖网络校时；触发后的动作由回调交给主任务执行
+        rules_.Evaluate((uint32_t)(now / 1000000), values[0], values[1]);
+        ESP_LOGD(TAG, "Sampled temperature: %.2f°C, humidity: %.2f%%", values[0], values[1]);
+
+        // 快照要编码并写入 NVS，放到主任务里做，总线调度任务只保留小栈
+        if (history_available_ && now - last_snapshot_time_ > SENSOR_HISTORY_SNAPSHOT_INTERVAL_US) {
+            last_snapshot_time_ = now;
+            Application::GetInstance().Schedule([this]() {
+                history_.SaveSnapshot();
+            });
+        }
     }
-    return "--.-°C / --.-%";
 }
 
-std::string SensorManager::GetJsonData() {
+void SensorManager::AdaptSamplePeriod(int32_t temperature, int32_t humidity) {
+    // Temperature and humidity drift slowly: sample fast only while they move
+    bool moving = !has_adapt_reference_ ||
+        std::abs(temperature - adapt_temperature_) >= SENSOR_ADAPT_TEMPERATURE_STEP ||
+        std::abs(humidity - adapt_humidity_) >= SENSOR_ADAPT_HUMIDITY_STEP;
+    if (moving) {
+        has_adapt_reference_ = true;
+        adapt_temperature_ = temperature;
+        adapt_humidity_ = humidity;
+        adaptive_period_ms_ = CONFIG_DHT20_SAMPLE_INTERVAL_MS;
+    } else {
+        adaptive_period_ms_ = std::min(adaptive_period_ms_ * 2, CONFIG_DHT20_MAX_SAMPLE_INTERVAL_MS);
+    }
+}
+
+void SensorManager::UpdateSamplePeriod() {
+    int period_ms;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        period_ms = std::min(adaptive_period_ms_, period_cap_ms_);
+        if (requested_period_ms_ > 0) {
+            if (esp_timer_get_time() < requested_until_us_) {
+                period_ms = std::min(period_ms, requested_period_ms_);
+            } else {
+                requested_period_ms_ = 0;
+            }
+        }
+        period_ms = std::max(period_ms, CONFIG_DHT20_SAMPLE_INTERVAL_MS);
+        if (period_ms == applied_period_ms_ || !scheduler_) {
+            return;
+        }
+        applied_period_ms_ = period_ms;
+    }
+    ESP_LOGD(TAG, "DHT20 sample period %d ms", period_ms);
+    scheduler_->SetPeriod(dht20_, period_ms);
+}
+
+void SensorManager::RequestSamplePeriod(int period_ms, int duration_ms) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        int64_t until = esp_timer_get_time() + (int64_t)duration_ms * 1000;
+        if (requested_period_ms_ == 0 || esp_timer_get_time() >= requested_until_us_) {
+            requested_period_ms_ = period_ms;
+            requested_until_us_ = until;
+        } else {
+            // Overlapping requests: the fastest period until the last one ends
+            requested_period_ms_ = std::min(requested_period_ms_, period_ms);
+            requested_until_us_ = std::max(requested_until_us_, until);
+        }
+    }
+    UpdateSamplePeriod();
+}
+
+void SensorManager::SetPowerSaveLevel(PowerSaveLevel level) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        switch (level) {
+        case PowerSaveLevel::LOW_POWER:
+            period_cap_ms_ = CONFIG_DHT20_MAX_SAMPLE_INTERVAL_MS;
+            break;
+        case PowerSaveLevel::BALANCED:
+            period_cap_ms_ = CONFIG_DHT20_MAX_SAMPLE_INTERVAL_MS / 4;
+            break;
+        default:
+            period_cap_ms_ = CONFIG_DHT20_SAMPLE_INTERVAL_MS;
+            break;
+        }
+    }
+    UpdateSamplePeriod();
+}
+
+int SensorManager::GetSamplePeriod() const {
     std::lock_guard<std::mutex> lock(mutex_);
+    return applied_period_ms_;
+}
+
+void SensorManager::RecordSample(float temperature, float humidity) {
+#ifdef CONFIG_SENSOR_TELEMETRY
+    if (!history_available_ && !telemetry_) {
+        return;
+    }
+#else
+    if (!history_available_) {
+        return;
+    }
+#endif
+
+    // History and telemetry are keyed by wall clock time; wait until the time is synced
+    time_t now = time(nullptr);
+    struct tm tm;
+    localtime_r(&now, &tm);
+    if (tm.tm_year < 2025 - 1900) {
+        return;
+    }
+    if (history_available_) {
+        history_.Ingest((uint32_t)now, temperature, humidity);
+    }
+#ifdef CONFIG_SENSOR_TELEMETRY
+    if (telemetry_) {
+        telemetry_->Add((uint32_t)now, temperature, humidity);
+    }
+#endif
+}
+
+void SensorManager::PublishReading(float temperature, float humidity, int64_t timestamp_us) {
+    // Single writer: an odd sequence marks an update in progress
+    uint32_t sequence = reading_sequence_.load(std::memory_order_relaxed);
+    reading_sequence_.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    reading_temperature_.store(temperature, std::memory_order_relaxed);
+    reading_humidity_.store(humidity, std::memory_order_relaxed);
+    reading_timestamp_us_.store(timestamp_us, std::memory_order_relaxed);
+    reading_sequence_.store(sequence + 2, std::memory_order_release);
+}
 
-    if (!initialized_ || !dht20_) {
+bool SensorManager::GetReading(SensorReading& reading) const {
+    uint32_t begin, end;
+    do {
+        begin = reading_sequence_.load(std::memory_order_acquire);
+        reading.temperature = reading_temperature_.load(std::memory_order_relaxed);
+        reading.humidity = reading_humidity_.load(std::memory_order_relaxed);
+        reading.timestamp_us = reading_timestamp_us_.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        end = reading_sequence_.load(std::memory_order_relaxed);
+    } while ((begin & 1) || begin != end);
+
+    const int64_t stale_us = SENSOR_READING_STALE_US;
+    reading.valid = begin != 0 && esp_timer_get_time() - reading.timestamp_us < stale_us;
+    return reading.valid;
+}
+
+bool SensorManager::ReadTemperatureHumidity(float& temperature, float& humidity) {
+    SensorReading reading;
+    if (!GetReading(reading)) {
+        return false;
+    }
+    temperature = reading.temperature;
+    humidity = reading.humidity;
+    return true;
+}
+
+bool SensorManager::GetReadingText(SensorReadingText& text) {
+    // Taken before the reading, so a publish in between only causes one extra re-format
+    uint32_t sequence = reading_sequence_.load(std::memory_order_acquire);
+    SensorReading reading;
+    GetReading(reading);
+    // Stable sequence values are even, 1 stands for "no valid reading"
+    uint32_t key = reading.valid ? sequence : 1;
+
+    std::lock_guard<std::mutex> lock(text_mutex_);
+    if (key != text_cache_sequence_) {
+        text_cache_sequence_ = key;
+        text_cache_.valid = reading.valid;
+        if (reading.valid) {
+            int32_t temperature = (int32_t)lroundf(reading.temperature * 100.0f);
+            int32_t humidity = (int32_t)lroundf(reading.humidity * 100.0f);
+            FormatTemperature(text_cache_.temperature, sizeof(text_cache_.temperature), temperature);
+            FormatHumidity(text_cache_.humidity, sizeof(text_cache_.humidity), humidity);
+            FormatTemperatureHumidity(text_cache_.combined, sizeof(text_cache_.combined), temperature, humidity);
+        } else {
+            strcpy(text_cache_.temperature, "--.-°C");
+            strcpy(text_cache_.humidity, "--.-%");
+            strcpy(text_cache_.combined, "--.-°C / --.-%");
+        }
+    }
+    text = text_cache_;
+    return text.valid;
+}
+
+std::string SensorManager::GetTemperatureHumidityString() {
+    SensorReadingText text;
+    GetReadingText(text);
+    return text.combined;
+}
+
+std::string SensorManager::GetJsonData() {
+    if (!initialized_) {
         ESP_LOGE(TAG, "Sensor manager not initialized");
         return "{\"error\": \"Sensor manager not initialized\"}";
     }
 
-    return dht20_->GetJsonData();
+    SensorReading reading;
+    if (!GetReading(reading)) {
+        return "{\"error\": \"No valid sensor reading\"}";
+    }
+
+    char buffer[64];
+    std::string json;
+    json.reserve(128);
+    json += "{\"temperature\": ";
+    FormatFixed(buffer, sizeof(buffer), (int32_t)lroundf(reading.temperature * 100.0f), 2);
+    json += buffer;
+    json += ", \"humidity\": ";
+    FormatFixed(buffer, sizeof(buffer), (int32_t)lroundf(reading.humidity * 100.0f), 2);
+    json += buffer;
+
+    // Other registered sensors are listed under their own name
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& registered : sensors_) {
+        auto sensor = registered.sensor.get();
+        if (sensor == dht20_ || registered.timestamp_us == 0) {
+            continue;
+        }
+        json += ", \"";
+        json += sensor->GetName();
+        json += "\": {";
+        for (int i = 0; i < sensor->GetChannelCount(); i++) {
+            json += i > 0 ? ", \"" : "\"";
+            json += sensor->GetChannelName(i);
+            json += "\": ";
+            FormatFixed(buffer, sizeof(buffer), (int32_t)lroundf(registered.values[i] * 100.0f), 2);
+            json += buffer;
+        }
+        json += "}";
+    }
+    json += "}";
+    return json;
 }
 
 void SensorManager::SetTemperatureOffset(float offset) {
@@ -97,6 +421,7 @@ void SensorManager::SetTemperatureOffset(float offset) {
 
     if (dht20_) {
         dht20_->SetTemperatureOffset(offset);
+        temperature_filter_.Reset();
         SaveCalibration();
     }
 }
@@ -106,6 +431,7 @@ void SensorManager::SetHumidityOffset(float offset) {
 
     if (dht20_) {
         dht20_->SetHumidityOffset(offset);
+        humidity_filter_.Reset();
         SaveCalibration();
     }
 }
@@ -2,15 +2,70 @@
 #define SENSOR_MANAGER_H
 
 #include "dht20/dht20.h"
+#ifdef CONFIG_DHT20_SIMULATOR
+#include "dht20/dht20_simulator.h"
+#endif
+#include "sensor.h"
+#include "sensor_bus_scheduler.h"
+#include "sensor_filter.h"
+#include "sensor_history.h"
+#include "sensor_rules.h"
+#ifdef CONFIG_SENSOR_TELEMETRY
+#include "sensor_telemetry.h"
+#endif
+#include <atomic>
 #include <memory>
 #include <mutex>
+#include <vector>
+
+enum class PowerSaveLevel;
+
+struct SensorReading {
+    float temperature = 0.0f;
+    float humidity = 0.0f;
+    int64_t timestamp_us = 0;   // esp_timer time of the measurement
+    bool valid = false;         // False until the first successful measurement
+};
+
+// Latest reading formatted for display, "--.-" placeholders without a valid reading
+struct SensorReadingText {
+    char temperature[16];       // "23.5°C"
+    char humidity[16];          // "45.2%"
+    char combined[40];          // "23.5°C / 45.2%"
+    bool valid;
+};
 
 class SensorManager {
 public:
     static SensorManager& GetInstance();
 
     bool Initialize(i2c_master_bus_handle_t i2c_bus);
+    // False when no board sensor was found, sensor MCP tools are only registered if true
+    bool IsInitialized() const;
+    // Adds a sensor on the same bus as the DHT20, sampled by the shared bus scheduler
+    bool RegisterSensor(std::unique_ptr<Sensor> sensor, int period_ms);
+    SensorBusScheduler* GetBusScheduler() { return scheduler_.get(); }
+    // Samples the DHT20 at least every period_ms for the next duration_ms, e.g. for MCP queries
+    void RequestSamplePeriod(int period_ms, int duration_ms);
+    // Low power allows the longest sample period, performance keeps sampling at the shortest
+    void SetPowerSaveLevel(PowerSaveLevel level);
+    int GetSamplePeriod() const;
+    // Latest sample from the background sampler, never touches the I2C bus
+    bool GetReading(SensorReading& reading) const;
+    // Null when the history store could not be allocated
+    SensorHistory* GetHistory() { return history_available_ ? &history_ : nullptr; }
+#ifdef CONFIG_SENSOR_TELEMETRY
+    SensorTelemetry* GetTelemetry() { return telemetry_.get(); }
+#endif
+    // Threshold alert rules, evaluated on every DHT20 sample
+    SensorRules& GetRules() { return rules_; }
+#ifdef CONFIG_DHT20_SIMULATOR
+    // The simulated DHT20, used to script readings and inject faults
+    DHT20Simulator* GetDht20Simulator() { return dht20_simulator_.get(); }
+#endif
     bool ReadTemperatureHumidity(float& temperature, float& humidity);
+    // Copies the cached text, which is only re-formatted after a new reading was published
+    bool GetReadingText(SensorReadingText& text);
     std::string GetTemperatureHumidityString();
     std::string GetJsonData();
     void SetTemperatureOffset(float offset);
@@ -24,9 +79,56 @@ private:
     SensorManager();
     ~SensorManager();
 
-    std::unique_ptr<DHT20> dht20_;
+    struct RegisteredSensor {
+        std::unique_ptr<Sensor> sensor;
+        float values[SENSOR_MAX_CHANNELS] = {};
+        int64_t timestamp_us = 0;   // Zero until the first successful measurement
+    };
+
+    std::vector<RegisteredSensor> sensors_;
+    DHT20* dht20_ = nullptr;    // Owned by sensors_, the primary temperature/humidity source
+    std::unique_ptr<SensorBusScheduler> scheduler_;
+#ifdef CONFIG_DHT20_SIMULATOR
+    std::unique_ptr<DHT20Simulator> dht20_simulator_;
+#endif
+    // DHT20 readings pass through these before any consumer sees them, guarded by mutex_
+    SensorFilter temperature_filter_;
+    SensorFilter humidity_filter_;
+
+    // Adaptive sample period, guarded by mutex_
+    int adaptive_period_ms_ = CONFIG_DHT20_SAMPLE_INTERVAL_MS;
+    int period_cap_ms_ = CONFIG_DHT20_MAX_SAMPLE_INTERVAL_MS;
+    int requested_period_ms_ = 0;
+    int64_t requested_until_us_ = 0;
+    int applied_period_ms_ = CONFIG_DHT20_SAMPLE_INTERVAL_MS;
+    bool has_adapt_reference_ = false;
+    int32_t adapt_temperature_ = 0;
+    int32_t adapt_humidity_ = 0;
     mutable std::mutex mutex_;
     bool initialized_ = false;
+    int64_t last_snapshot_time_ = 0;
+    SensorHistory history_;
+    bool history_available_ = false;
+#ifdef CONFIG_SENSOR_TELEMETRY
+    std::unique_ptr<SensorTelemetry> telemetry_;
+#endif
+    SensorRules rules_;
+
+    // Latest reading, published by the sampler task with a sequence lock
+    std::atomic<uint32_t> reading_sequence_ = 0;
+    std::atomic<float> reading_temperature_ = 0.0f;
+    std::atomic<float> reading_humidity_ = 0.0f;
+    std::atomic<int64_t> reading_timestamp_us_ = 0;
+
+    std::mutex text_mutex_;
+    SensorReadingText text_cache_ = {};
+    uint32_t text_cache_sequence_ = UINT32_MAX;
+
+    void OnSensorResult(Sensor* sensor, const float* values);
+    void PublishReading(float temperature, float humidity, int64_t timestamp_us);
+    void RecordSample(float temperature, float humidity);
+    void AdaptSamplePeriod(int32_t temperature, int32_t humidity);
+    void UpdateSamplePeriod();
 };
 
 #endif // SENSOR_MANAGER_H
@@ -0,0 +1,322 @@
+#include "sensor_rules.h"
+#include "settings.h"
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#define TAG "SensorRules"
+
+// Default window of rise / drop rules, and hysteresis when none is given (0.5 °C or 0.5 %RH)
+#define SENSOR_RULE_DEFAULT_WINDOW_S 600
+#define SENSOR_RULE_DEFAULT_HYSTERESIS 50
+
+namespace {
+
+int32_t ToFixed(float value) {
+    return (int32_t)std::lround(value * 100.0f);
+}
+
+float ParseNumber(const std::string& token) {
+    size_t used = 0;
+    float value = 0.0f;
+    try {
+        value = std::stof(token, &used);
+    } catch (...) {
+        used = 0;
+    }
+    if (used != token.size() || !std::isfinite(value)) {
+        throw std::invalid_argument("Invalid number: " + token);
+    }
+    return value;
+}
+
+uint32_t ParseDuration(const std::string& token) {
+    if (token.empty()) {
+        throw std::invalid_argument("Missing duration");
+    }
+    uint32_t unit = 1;
+    std::string number = token;
+    switch (token.back()) {
+    case 's': unit = 1; number.pop_back(); break;
+    case 'm': unit = 60; number.pop_back(); break;
+    case 'h': unit = 3600; number.pop_back(); break;
+    }
+    float value = ParseNumber(number);
+    if (value <= 0 || value * unit > 86400) {
+        throw std::invalid_argument("Duration must be between 1s and 24h: " + token);
+    }
+    return (uint32_t)(value * unit);
+}
+
+// Splits at runs of spaces and tabs
+std::vector<std::string> SplitWords(const std::string& text) {
+    std::vector<std::string> words;
+    size_t start = 0;
+    while ((start = text.find_first_not_of(" \t", start)) != std::string::npos) {
+        size_t end = text.find_first_of(" \t", start);
+        words.push_back(text.substr(start, end - start));
+        start = end;
+    }
+    return words;
+}
+
+std::string Sanitize(const std::string& text) {
+    std::string result = text;
+    std::replace(result.begin(), result.end(), '\t', ' ');
+    std::replace(result.begin(), result.end(), '\n', ' ');
+    return result;
+}
+
+} // namespace
+
+SensorRules::SensorRules() {
+}
+
+SensorRules::Program SensorRules::Compile(const std::string& expression) {
+    auto tokens = SplitWords(expression);
+    if (tokens.size() < 3) {
+        throw std::invalid_argument("Expected '<channel> <op> <value>'");
+    }
+
+    Program program = {};
+    if (tokens[0] == "temperature") {
+        program.channel = 0;
+    } else if (tokens[0] == "humidity") {
+        program.channel = 1;
+    } else {
+        throw std::invalid_argument("Unknown channel: " + tokens[0]);
+    }
+
+    int32_t value = ToFixed(ParseNumber(tokens[2]));
+    auto& op = tokens[1];
+    if (op == ">" || op == ">=") {
+        program.metric = kMetricValue;
+        program.threshold = op == ">" ? value + 1 : value;
+    } else if (op == "<" || op == "<=") {
+        program.metric = kMetricNegatedValue;
+        program.threshold = op == "<" ? -value + 1 : -value;
+    } else if (op == "rise" || op == "drop") {
+        if (value <= 0) {
+            throw std::invalid_argument("Change must be positive: " + tokens[2]);
+        }
+        program.metric = op == "rise" ? kMetricRise : kMetricDrop;
+        program.threshold = value;
+    } else {
+        throw std::invalid_argument("Unknown operator: " + op);
+    }
+
+    uint32_t window_s = SENSOR_RULE_DEFAULT_WINDOW_S;
+    int32_t hysteresis = SENSOR_RULE_DEFAULT_HYSTERESIS;
+    for (size_t i = 3; i < tokens.size(); i += 2) {
+        if (i + 1 >= tokens.size()) {
+            throw std::invalid_argument("Missing value after " + tokens[i]);
+        }
+        if (tokens[i] == "in" && (program.metric == kMetricRise || program.metric == kMetricDrop)) {
+            window_s = ParseDuration(tokens[i + 1]);
+        } else if (tokens[i] == "hyst") {
+            hysteresis = ToFixed(ParseNumber(tokens[i + 1]));
+            if (hysteresis < 0) {
+                throw std::invalid_argument("Hysteresis must not be negative");
+            }
+        } else {
+            throw std::invalid_argument("Unexpected token: " + tokens[i]);
+        }
+    }
+
+    program.armed = true;
+    program.rearm = program.threshold - hysteresis;
+    if (program.metric == kMetricRise || program.metric == kMetricDrop) {
+        program.slot_span_s = std::max<uint32_t>(1, (window_s + SENSOR_RULE_WINDOW_SLOTS - 1) / SENSOR_RULE_WINDOW_SLOTS);
+        // Slots hold the window minimum for rise rules and the maximum for drop rules
+        std::fill_n(program.slot_extreme, SENSOR_RULE_WINDOW_SLOTS,
+            program.metric == kMetricRise ? INT32_MAX : INT32_MIN);
+    }
+    return program;
+}
+
+int SensorRules::AddRule(const std::string& expression, SensorRuleAction action, const std::string& message) {
+    auto program = Compile(expression);
+
+    std::lock_guard<std::mutex> save_lock(save_mutex_);
+    int id;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (programs_.size() >= SENSOR_RULES_MAX) {
+            throw std::invalid_argument("Too many rules");
+        }
+        id = next_id_++;
+        programs_.push_back(program);
+        infos_.push_back(SensorRuleInfo{
+            .id = id,
+            .action = action,
+            .expression = Sanitize(expression),
+            .message = message.empty() ? Sanitize(expression) : Sanitize(message),
+        });
+    }
+    Save();
+    ESP_LOGI(TAG, "Added rule %d: %s", id, expression.c_str());
+    return id;
+}
+
+bool SensorRules::RemoveRule(int id) {
+    std::lock_guard<std::mutex> save_lock(save_mutex_);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = std::find_if(infos_.begin(), infos_.end(), [id](const SensorRuleInfo& info) {
+            return info.id == id;
+        });
+        if (it == infos_.end()) {
+            return false;
+        }
+        programs_.erase(programs_.begin() + (it - infos_.begin()));
+        infos_.erase(it);
+    }
+    Save();
+    return true;
+}
+
+std::vector<SensorRuleInfo> SensorRules::GetRules() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return infos_;
+}
+
+void SensorRules::OnRuleTriggered(std::function<void(const SensorRuleInfo& rule)> callback) {
+    on_rule_triggered_ = callback;
+}
+
+void SensorRules::Evaluate(uint32_t time_s, float temperature, float humidity) {
+    int64_t start_time = esp_timer_get_time();
+    const int32_t values[2] = {ToFixed(temperature), ToFixed(humidity)};
+    std::vector<SensorRuleInfo> triggered;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (size_t i = 0; i < programs_.size(); i++) {
+            auto& program = programs_[i];
+            int32_t value = values[program.channel];
+            int32_t metric;
+            switch (program.metric) {
+            case kMetricValue:
+                metric = value;
+                break;
+            case kMetricNegatedValue:
+                metric = -value;
+                break;
+            default: {
+                // Advance the slot ring, clearing the slots that fell out of the window
+                uint32_t elapsed = time_s - program.slot_start_s;
+                if (elapsed >= program.slot_span_s) {
+                    uint32_t steps = elapsed / program.slot_span_s;
+                    int32_t empty = program.metric == kMetricRise ? INT32_MAX : INT32_MIN;
+                    for (uint32_t step = 0; step < std::min<uint32_t>(steps, SENSOR_RULE_WINDOW_SLOTS); step++) {
+                        program.slot_index = (program.slot_index + 1) % SENSOR_RULE_WINDOW_SLOTS;
+                        program.slot_extreme[program.slot_index] = empty;
+                    }
+                    program.slot_start_s = time_s - elapsed % program.slot_span_s;
+                }
+
+                int32_t& slot = program.slot_extreme[program.slot_index];
+                if (program.metric == kMetricRise) {
+                    slot = std::min(slot, value);
+                    metric = value - *std::min_element(program.slot_extreme, program.slot_extreme + SENSOR_RULE_WINDOW_SLOTS);
+                } else {
+                    slot = std::max(slot, value);
+                    metric = *std::max_element(program.slot_extreme, program.slot_extreme + SENSOR_RULE_WINDOW_SLOTS) - value;
+                }
+                break;
+            }
+            }
+
+            if (program.armed) {
+                if (metric >= program.threshold) {
+                    program.armed = false;
+                    triggered.push_back(infos_[i]);
+                }
+            } else if (metric < program.rearm) {
+                program.armed = true;
+            }
+        }
+
+        int64_t cost = esp_timer_get_time() - start_time;
+        max_evaluation_us_ = std::max(max_evaluation_us_, cost);
+        if (++evaluations_ % 1024 == 0) {
+            ESP_LOGD(TAG, "%u rules, max evaluation cost %d us", programs_.size(), (int)max_evaluation_us_);
+            max_evaluation_us_ = 0;
+        }
+    }
+
+    for (auto& rule : triggered) {
+        ESP_LOGI(TAG, "Rule %d triggered: %s", rule.id, rule.expression.c_str());
+        if (on_rule_triggered_) {
+            on_rule_triggered_(rule);
+        }
+    }
+}
+
+void SensorRules::Save() {
+    // Encoded from a copy, the NVS write must not hold up Evaluate on the sensor bus task
+    auto infos = GetRules();
+
+    // One rule per line: id, action, expression and message separated by tabs.
+    // Stored as a blob, 100 rules may exceed the NVS string length limit
+    std::string text;
+    for (auto& info : infos) {
+        text += std::to_string(info.id) + "\t" + std::to_string(info.action) + "\t" +
+            info.expression + "\t" + info.message + "\n";
+    }
+    Settings settings("sensor_rules", true);
+    settings.SetBlob("rules", text.data(), text.size());
+}
+
+void SensorRules::Load() {
+    Settings settings("sensor_rules");
+    auto blob = settings.GetBlob("rules");
+    std::string text(blob.begin(), blob.end());
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t line_start = 0;
+    while (line_start < text.size()) {
+        size_t line_end = text.find('\n', line_start);
+        if (line_end == std::string::npos) {
+            line_end = text.size();
+        }
+        std::string line = text.substr(line_start, line_end - line_start);
+        line_start = line_end + 1;
+
+        std::vector<std::string> fields;
+        size_t start = 0, end;
+        while ((end = line.find('\t', start)) != std::string::npos) {
+            fields.push_back(line.substr(start, end - start));
+            start = end + 1;
+        }
+        fields.push_back(line.substr(start));
+        if (fields.size() != 4) {
+            continue;
+        }
+
+        try {
+            // Written by another firmware version or corrupted, the action indexes name tables
+            int action = std::stoi(fields[1]);
+            if (action < kSensorRuleActionAlert || action > kSensorRuleActionReminder) {
+                throw std::invalid_argument("Unknown action " + fields[1]);
+            }
+            SensorRuleInfo info = {
+                .id = std::stoi(fields[0]),
+                .action = (SensorRuleAction)action,
+                .expression = fields[2],
+                .message = fields[3],
+            };
+            programs_.push_back(Compile(info.expression));
+            infos_.push_back(info);
+            next_id_ = std::max(next_id_, info.id + 1);
+        } catch (const std::exception& e) {
+            ESP_LOGW(TAG, "Dropping stored rule '%s': %s", line.c_str(), e.what());
+        }
+    }
+    if (!infos_.empty()) {
+        ESP_LOGI(TAG, "Loaded %u sensor rules", infos_.size());
+    }
+}
@@ -0,0 +1,88 @@
+#ifndef SENSOR_RULES_H
+#define SENSOR_RULES_H
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#define SENSOR_RULES_MAX 100
+#define SENSOR_RULE_WINDOW_SLOTS 8
+
+enum SensorRuleAction {
+    kSensorRuleActionAlert,     // Alert on screen with a sound
+    kSensorRuleActionSound,     // Sound only
+    kSensorRuleActionReminder,  // Reminder entry, spoken by the assistant when possible
+};
+
+struct SensorRuleInfo {
+    int id;
+    SensorRuleAction action;
+    std::string expression;
+    std::string message;
+};
+
+/*
+ * Threshold / rate-of-change rules over the temperature and humidity stream.
+ *
+ * Expression format: <channel> <op> <value> [in <duration>] [hyst <value>]
+ *   channel:  temperature | humidity
+ *   op:       > >= < <= (threshold), rise | drop (change within `in`, default 10m)
+ *   duration: seconds, or with an s / m / h suffix
+ *   hyst:     how far the condition has to recede before the rule can fire again
+ * e.g. "humidity > 70", "temperature drop 3 in 10m", "temperature < 16 hyst 1"
+ *
+ * Rules are compiled into a flat array of fixed-point instructions, so each sample
+ * costs O(rules) integer compares plus an O(1) sliding window update for rate rules.
+ */
+class SensorRules {
+public:
+    SensorRules();
+
+    // Throws std::invalid_argument if the expression does not compile
+    int AddRule(const std::string& expression, SensorRuleAction action, const std::string& message);
+    bool RemoveRule(int id);
+    std::vector<SensorRuleInfo> GetRules();
+    void Evaluate(uint32_t time_s, float temperature, float humidity);
+    void OnRuleTriggered(std::function<void(const SensorRuleInfo& rule)> callback);
+
+    void Load();
+
+private:
+    enum Metric : uint8_t {
+        kMetricValue,           // v
+        kMetricNegatedValue,    // -v, for "below" rules
+        kMetricRise,            // v - min(window)
+        kMetricDrop,            // max(window) - v
+    };
+
+    // One compiled instruction, kept small and contiguous for the evaluation loop
+    struct Program {
+        uint8_t channel;
+        Metric metric;
+        bool armed;
+        uint8_t slot_index;
+        int32_t threshold;      // Fires when metric >= threshold, 0.01 units
+        int32_t rearm;          // Armed again when metric < rearm
+        uint32_t slot_span_s;
+        uint32_t slot_start_s;
+        int32_t slot_extreme[SENSOR_RULE_WINDOW_SLOTS];
+    };
+
+    std::mutex mutex_;
+    // Serializes changes with their NVS write, so the last write has the latest rules
+    std::mutex save_mutex_;
+    std::vector<Program> programs_;
+    std::vector<SensorRuleInfo> infos_;    // Same order as programs_
+    int next_id_ = 1;
+    std::function<void(const SensorRuleInfo& rule)> on_rule_triggered_;
+    uint32_t evaluations_ = 0;
+    int64_t max_evaluation_us_ = 0;
+
+    static Program Compile(const std::string& expression);
+    // Called with save_mutex_ held and mutex_ released
+    void Save();
+};
+
+#endif // SENSOR_RULES_H
@@ -0,0 +1,112 @@
+#include "sensor_telemetry.h"
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <algorithm>
+#include <cmath>
+
+#define TAG "SensorTelemetry"
+
+#define SENSOR_TELEMETRY_FORMAT_VERSION 1
+
+namespace {
+
+void PutVarint(std::string& out, uint32_t value) {
+    while (value >= 0x80) {
+        out.push_back((char)(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back((char)value);
+}
+
+void PutSignedVarint(std::string& out, int32_t value) {
+    PutVarint(out, ((uint32_t)value << 1) ^ (uint32_t)(value >> 31));
+}
+
+} // namespace
+
+SensorTelemetry::SensorTelemetry() {
+    samples_.Attach(buffer_, SENSOR_TELEMETRY_CAPACITY);
+}
+
+void SensorTelemetry::Add(uint32_t time, float temperature, float humidity) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!samples_.empty() && time < samples_.back().time + CONFIG_SENSOR_TELEMETRY_INTERVAL_S) {
+        return;
+    }
+
+    if (samples_.size() == samples_.capacity()) {
+        front_sequence_++;
+        if (dropped_++ == 0) {
+            ESP_LOGW(TAG, "Telemetry buffer full, dropping the oldest samples until the next upload");
+        }
+    }
+    samples_.push_back(SensorHistorySample{
+        .time = time,
+        .temperature = (int16_t)std::clamp<long>(std::lround(temperature * 100.0f), INT16_MIN, INT16_MAX),
+        .humidity = (uint16_t)std::clamp<long>(std::lround(humidity * 100.0f), 0, 10000),
+    });
+}
+
+bool SensorTelemetry::IsFlushDue(uint32_t now) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (samples_.empty()) {
+        return false;
+    }
+    return samples_.size() >= CONFIG_SENSOR_TELEMETRY_BATCH_SIZE ||
+        now >= samples_.at(0).time + CONFIG_SENSOR_TELEMETRY_MAX_AGE_S;
+}
+
+size_t SensorTelemetry::pending() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return samples_.size();
+}
+
+size_t SensorTelemetry::EncodeBatch(std::string& batch, uint32_t& last_sequence) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t count = samples_.size();
+    batch.clear();
+    if (count == 0) {
+        return 0;
+    }
+    last_sequence = front_sequence_ + count - 1;
+
+    // Typically 3 bytes per sample: 1 byte time delta and 1 byte for each value delta
+    batch.reserve(12 + count * 4);
+    batch.push_back(SENSOR_TELEMETRY_FORMAT_VERSION);
+    PutVarint(batch, count);
+
+    auto& first = samples_.at(0);
+    PutVarint(batch, first.time);
+    PutSignedVarint(batch, first.temperature);
+    PutVarint(batch, first.humidity);
+    for (size_t i = 1; i < count; i++) {
+        auto& previous = samples_.at(i - 1);
+        auto& sample = samples_.at(i);
+        PutVarint(batch, sample.time - previous.time);
+        PutSignedVarint(batch, sample.temperature - previous.temperature);
+        PutSignedVarint(batch, (int32_t)sample.humidity - previous.humidity);
+    }
+    return count;
+}
+
+void SensorTelemetry::Commit(uint32_t last_sequence, size_t count, size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // Samples evicted while the batch was in flight already moved front_sequence_ forward,
+    // so only what is left of the batch is removed; the difference wraps like the counter
+    int32_t sent = (int32_t)(last_sequence - front_sequence_) + 1;
+    if (sent > 0) {
+        size_t removed = std::min<size_t>(sent, samples_.size());
+        samples_.pop_front(removed);
+        front_sequence_ += removed;
+    }
+    flushes_++;
+    sent_samples_ += count;
+    sent_bytes_ += bytes;
+    dropped_ = 0;
+
+    // Each upload rides on a connection that was already open, so uploads per hour bound the extra radio use
+    int64_t uptime_s = std::max<int64_t>(1, esp_timer_get_time() / 1000000);
+    ESP_LOGI(TAG, "Uploaded %u samples in %u encoded bytes, average %.2f bytes/sample, %.2f uploads/hour",
+        count, bytes, (float)sent_bytes_ / sent_samples_, flushes_ * 3600.0f / uptime_s);
+}
@@ -0,0 +1,48 @@
+#ifndef SENSOR_TELEMETRY_H
+#define SENSOR_TELEMETRY_H
+
+#include "sensor_history.h"
+
+#include <mutex>
+#include <string>
+
+#define SENSOR_TELEMETRY_CAPACITY 240
+
+/*
+ * Accumulates temperature/humidity samples for upload in batches.
+ *
+ * Batch format "dv1", all integers are LEB128 varints, signed ones zigzag encoded:
+ *   version (1), count,
+ *   first sample: unix time, temperature (0.01 °C, signed), humidity (0.01 %RH),
+ *   following samples: time delta, temperature delta (signed), humidity delta (signed)
+ */
+class SensorTelemetry {
+public:
+    SensorTelemetry();
+
+    // Samples closer than CONFIG_SENSOR_TELEMETRY_INTERVAL_S to the previous one are skipped.
+    // When the buffer is full the oldest sample is dropped.
+    void Add(uint32_t time, float temperature, float humidity);
+    // A batch is due once it is large enough or its oldest sample is old enough
+    bool IsFlushDue(uint32_t now);
+    size_t pending();
+
+    // Encodes the pending samples without removing them, returns the number encoded.
+    // last_sequence is the sequence number of the last sample in the batch.
+    size_t EncodeBatch(std::string& batch, uint32_t& last_sequence);
+    // Removes the samples up to last_sequence after the batch was sent. Samples dropped
+    // from a full buffer in the meantime are not counted twice, newer ones are kept.
+    void Commit(uint32_t last_sequence, size_t count, size_t bytes);
+
+private:
+    std::mutex mutex_;
+    SensorHistorySample buffer_[SENSOR_TELEMETRY_CAPACITY];
+    SensorHistoryRing<SensorHistorySample> samples_;
+    uint32_t front_sequence_ = 0;   // Sequence number of samples_.at(0), counts every sample ever added
+    uint32_t dropped_ = 0;
+    uint32_t flushes_ = 0;
+    uint32_t sent_samples_ = 0;
+    uint32_t sent_bytes_ = 0;
+};
+
+#endif // SENSOR_TELEMETRY_H
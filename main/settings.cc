@@ -88,6 +88,40 @@ void Settings::SetBool(const std::string& key, bool value) {
     }
 }
 
+std::vector<uint8_t> Settings::GetBlob(const std::string& key) {
+    std::vector<uint8_t> value;
+    if (nvs_handle_ == 0) {
+        return value;
+    }
+
+    size_t length = 0;
+    if (nvs_get_blob(nvs_handle_, key.c_str(), nullptr, &length) != ESP_OK) {
+        return value;
+    }
+
+    value.resize(length);
+    if (nvs_get_blob(nvs_handle_, key.c_str(), value.data(), &length) != ESP_OK) {
+        value.clear();
+    }
+    return value;
+}
+
+bool Settings::SetBlob(const std::string& key, const void* data, size_t length) {
+    if (!read_write_) {
+        ESP_LOGW(TAG, "Namespace %s is not open for writing", ns_.c_str());
+        return false;
+    }
+
+    // Blobs can be large, so running out of NVS space is reported instead of aborting
+    esp_err_t err = nvs_set_blob(nvs_handle_, key.c_str(), data, length);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to set blob %s (%u bytes): %s", key.c_str(), length, esp_err_to_name(err));
+        return false;
+    }
+    dirty_ = true;
+    return true;
+}
+
 void Settings::EraseKey(const std::string& key) {
     if (read_write_) {
         auto ret = nvs_erase_key(nvs_handle_, key.c_str());
@@ -2,6 +2,7 @@
 #define SETTINGS_H
 
 #include <string>
+#include <vector>
 #include <nvs_flash.h>
 
 class Settings {
@@ -15,6 +16,8 @@ public:
     void SetInt(const std::string& key, int32_t value);
     bool GetBool(const std::string& key, bool default_value = false);
     void SetBool(const std::string& key, bool value);
+    std::vector<uint8_t> GetBlob(const std::string& key);
+    bool SetBlob(const std::string& key, const void* data, size_t length);
     void EraseKey(const std::string& key);
     void EraseAll();
 
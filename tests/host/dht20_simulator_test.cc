@@ -0,0 +1,133 @@
+// DHT20 driver against the simulated sensor: normal reads and every injected fault,
+// each followed by a read that must succeed again.
+#include "dht20/dht20.h"
+#include "dht20/dht20_simulator.h"
+#include "host_test.h"
+
+#include <atomic>
+
+static void TestReadsEnvironment() {
+    DHT20Simulator simulator;
+    simulator.SetEnvironment(21.37f, 63.2f);
+    DHT20 dht20(&simulator);
+    CHECK(dht20.Initialize());
+
+    float temperature = 0, humidity = 0;
+    CHECK(dht20.ReadData(temperature, humidity));
+    // 20 bits per value, the round trip is far below 0.01
+    CHECK_NEAR(temperature, 21.37, 0.01);
+    CHECK_NEAR(humidity, 63.2, 0.01);
+
+    auto stats = simulator.GetStats();
+    CHECK(stats.conversions == 1);
+    CHECK(stats.faults == 0);
+}
+
+static void TestFollowsScript() {
+    DHT20Simulator simulator;
+    std::atomic<int> calls = 0;
+    simulator.SetScript([&calls](int64_t /* time_us */, float& temperature, float& humidity) {
+        int call = calls++;
+        temperature = -10.0f + call * 5.0f;
+        humidity = 90.0f - call * 10.0f;
+    });
+    DHT20 dht20(&simulator);
+    CHECK(dht20.Initialize());
+
+    for (int i = 0; i < 3; i++) {
+        float temperature = 0, humidity = 0;
+        CHECK(dht20.ReadData(temperature, humidity));
+        CHECK_NEAR(temperature, -10.0 + i * 5.0, 0.01);
+        CHECK_NEAR(humidity, 90.0 - i * 10.0, 0.01);
+    }
+}
+
+static void TestSlowConversionPollsBusy() {
+    DHT20Simulator simulator;
+    simulator.SetConversionTimeMs(DHT20::DHT20_MEASUREMENT_TIME_MS + 60);
+    DHT20 dht20(&simulator);
+    CHECK(dht20.Initialize());
+
+    float temperature, humidity;
+    CHECK(dht20.ReadData(temperature, humidity));
+    CHECK(simulator.GetStats().busy_reads > 0);
+}
+
+static void TestNackFailsThenRecovers() {
+    DHT20Simulator simulator;
+    DHT20 dht20(&simulator);
+
+    simulator.InjectFault(kDht20FaultNack, 1);
+    CHECK(!dht20.Initialize());
+    CHECK(dht20.Initialize());
+
+    float temperature, humidity;
+    simulator.InjectFault(kDht20FaultNack, 2);
+    CHECK(!dht20.ReadData(temperature, humidity));
+    CHECK(!dht20.ReadData(temperature, humidity));
+    CHECK(dht20.ReadData(temperature, humidity));
+    CHECK_NEAR(temperature, 22.5, 0.01);
+    CHECK(simulator.GetStats().faults == 3);
+}
+
+static void TestTimeoutBlocksThenRecovers() {
+    DHT20Simulator simulator;
+    DHT20 dht20(&simulator);
+    CHECK(dht20.Initialize());
+
+    float temperature, humidity;
+    simulator.InjectFault(kDht20FaultTimeout, 1);
+    int64_t start = esp_timer_get_time();
+    CHECK(!dht20.ReadData(temperature, humidity));
+    // The transaction holds the caller for the whole I2C timeout, 100 ms by default
+    CHECK(esp_timer_get_time() - start >= 100 * 1000);
+    CHECK(dht20.ReadData(temperature, humidity));
+    CHECK(simulator.GetStats().faults == 1);
+}
+
+static void TestStuckBusyTimesOut() {
+    DHT20Simulator simulator;
+    DHT20 dht20(&simulator);
+    CHECK(dht20.Initialize());
+
+    float temperature, humidity;
+    simulator.InjectFault(kDht20FaultStuckBusy);
+    int64_t start = esp_timer_get_time();
+    CHECK(!dht20.ReadData(temperature, humidity));
+    CHECK(esp_timer_get_time() - start >= DHT20::DHT20_MEASUREMENT_TIMEOUT_MS * 1000);
+    CHECK(simulator.GetStats().busy_reads > 0);
+
+    // Still stuck on the next conversion, until the fault is cleared
+    CHECK(!dht20.ReadData(temperature, humidity));
+    simulator.InjectFault(kDht20FaultNone);
+    CHECK(dht20.ReadData(temperature, humidity));
+    CHECK_NEAR(humidity, 45.0, 0.01);
+}
+
+static void TestBadCrcIsRejected() {
+    DHT20Simulator simulator;
+    DHT20 dht20(&simulator);
+    CHECK(dht20.Initialize());
+
+    float temperature = 0, humidity = 0;
+    simulator.InjectFault(kDht20FaultBadCrc, 2);
+    CHECK(!dht20.ReadData(temperature, humidity));
+    CHECK(!dht20.ReadData(temperature, humidity));
+    CHECK(dht20.ReadData(temperature, humidity));
+    CHECK_NEAR(temperature, 22.5, 0.01);
+
+    auto stats = simulator.GetStats();
+    CHECK(stats.faults == 2);
+    CHECK(stats.conversions == 3);
+}
+
+int main() {
+    RUN_TEST(TestReadsEnvironment);
+    RUN_TEST(TestFollowsScript);
+    RUN_TEST(TestSlowConversionPollsBusy);
+    RUN_TEST(TestNackFailsThenRecovers);
+    RUN_TEST(TestTimeoutBlocksThenRecovers);
+    RUN_TEST(TestStuckBusyTimesOut);
+    RUN_TEST(TestBadCrcIsRejected);
+    return HostTestFailures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,182 @@
+#ifndef GIF_WRITER_H
+#define GIF_WRITER_H
+
+// Writes GIF89a files for the decoder tests, covering what the emoji GIFs use and
+// the corners of the format: local palettes, transparency, disposal, sub-rectangle
+// and interlaced frames, and code tables that fill up and get cleared.
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+struct GifWriterFrame {
+    uint16_t x = 0, y = 0, width = 0, height = 0;
+    std::vector<uint8_t> indices;           // width * height palette indices
+    std::vector<uint8_t> local_palette;     // RGB triplets, empty for the global palette
+    uint16_t delay = 10;                    // 10 ms units
+    int transparent = -1;                   // Palette index, -1 for none
+    uint8_t disposal = 0;
+    bool interlaced = false;
+};
+
+class GifWriter {
+public:
+    GifWriter(uint16_t width, uint16_t height, const std::vector<uint8_t>& palette, uint8_t background = 0,
+        int loop_count = 0) {
+        Append("GIF89a");
+        Word(width);
+        Word(height);
+        int bits = PaletteBits(palette.size() / 3);
+        global_bits_ = bits;
+        data_.push_back(0x80 | ((bits - 1) << 4) | (bits - 1));
+        data_.push_back(background);
+        data_.push_back(0);
+        Palette(palette, bits);
+        if (loop_count >= 0) {
+            Append("\x21\xFF\x0BNETSCAPE2.0\x03\x01");
+            Word(loop_count);
+            data_.push_back(0);
+        }
+    }
+
+    void AddFrame(const GifWriterFrame& frame) {
+        // Graphic control extension
+        data_.push_back(0x21);
+        data_.push_back(0xF9);
+        data_.push_back(4);
+        data_.push_back((frame.disposal << 2) | (frame.transparent >= 0 ? 1 : 0));
+        Word(frame.delay);
+        data_.push_back(frame.transparent >= 0 ? frame.transparent : 0);
+        data_.push_back(0);
+
+        data_.push_back(0x2C);
+        Word(frame.x);
+        Word(frame.y);
+        Word(frame.width);
+        Word(frame.height);
+        uint8_t flags = frame.interlaced ? 0x40 : 0;
+        int bits = 0;
+        if (!frame.local_palette.empty()) {
+            bits = PaletteBits(frame.local_palette.size() / 3);
+            flags |= 0x80 | (bits - 1);
+        }
+        data_.push_back(flags);
+        if (bits > 0) {
+            Palette(frame.local_palette, bits);
+        }
+
+        std::vector<uint8_t> rows = frame.interlaced ? Interlace(frame) : frame.indices;
+        // As encoders do: codes start one bit wider than the palette, and never below 3 bits
+        Lzw(rows, std::max(2, bits > 0 ? bits : global_bits_));
+    }
+
+    std::vector<uint8_t> Finish() {
+        data_.push_back(0x3B);
+        return data_;
+    }
+
+private:
+    int global_bits_ = 1;
+    std::vector<uint8_t> data_;
+
+    void Append(const char* text) {
+        for (; *text != '\0'; text++) {
+            data_.push_back(*text);
+        }
+    }
+
+    void Word(uint16_t value) {
+        data_.push_back(value & 0xFF);
+        data_.push_back(value >> 8);
+    }
+
+    static int PaletteBits(size_t colors) {
+        int bits = 1;
+        while ((1u << bits) < colors) {
+            bits++;
+        }
+        return bits;
+    }
+
+    void Palette(const std::vector<uint8_t>& palette, int bits) {
+        std::vector<uint8_t> padded = palette;
+        padded.resize((size_t)3 << bits);
+        data_.insert(data_.end(), padded.begin(), padded.end());
+    }
+
+    // Rows in the stored order: every 8th from 0, every 8th from 4, every 4th from 2, every 2nd from 1
+    static std::vector<uint8_t> Interlace(const GifWriterFrame& frame) {
+        std::vector<uint8_t> rows;
+        const int starts[] = {0, 4, 2, 1}, steps[] = {8, 8, 4, 2};
+        for (int pass = 0; pass < 4; pass++) {
+            for (int y = starts[pass]; y < frame.height; y += steps[pass]) {
+                rows.insert(rows.end(), frame.indices.begin() + y * frame.width,
+                    frame.indices.begin() + (y + 1) * frame.width);
+            }
+        }
+        return rows;
+    }
+
+    void Lzw(const std::vector<uint8_t>& pixels, int min_code_size) {
+        data_.push_back(min_code_size);
+        std::vector<uint8_t> out;
+        uint32_t bit_buffer = 0;
+        int bit_count = 0;
+        auto emit = [&](int code, int size) {
+            bit_buffer |= (uint32_t)code << bit_count;
+            bit_count += size;
+            while (bit_count >= 8) {
+                out.push_back(bit_buffer & 0xFF);
+                bit_buffer >>= 8;
+                bit_count -= 8;
+            }
+        };
+
+        const int clear = 1 << min_code_size, end = clear + 1;
+        std::map<std::pair<int, uint8_t>, int> table;
+        int next = end + 1, size = min_code_size + 1;
+        emit(clear, size);
+        int prefix = -1;
+        for (uint8_t pixel : pixels) {
+            if (prefix < 0) {
+                prefix = pixel;
+                continue;
+            }
+            auto it = table.find({prefix, pixel});
+            if (it != table.end()) {
+                prefix = it->second;
+                continue;
+            }
+            emit(prefix, size);
+            if (next < 4096) {
+                table[{prefix, pixel}] = next++;
+                if (next > (1 << size) && size < 12) {
+                    size++;
+                }
+            } else {
+                // Table full: start over, exercises the decoder's reset path
+                emit(clear, size);
+                table.clear();
+                next = end + 1;
+                size = min_code_size + 1;
+            }
+            prefix = pixel;
+        }
+        if (prefix >= 0) {
+            emit(prefix, size);
+        }
+        emit(end, size);
+        if (bit_count > 0) {
+            out.push_back(bit_buffer & 0xFF);
+        }
+
+        for (size_t i = 0; i < out.size(); i += 255) {
+            size_t n = std::min<size_t>(255, out.size() - i);
+            data_.push_back(n);
+            data_.insert(data_.end(), out.begin() + i, out.begin() + i + n);
+        }
+        data_.push_back(0);
+    }
+};
+
+#endif // GIF_WRITER_H
@@ -0,0 +1,112 @@
+// Time per frame (gd_get_frame() and gd_render_frame()) of the GIF decoder against the
+// previous one, see gifdec_reference.c. Pass GIF files to time them, e.g. the emoji GIFs
+// from managed_components/ of a firmware build; without arguments it times generated GIFs
+// of the emoji sizes. Only the ratio carries over to the device, not the values.
+#include "gifdec_reference.h"
+#include "gif_writer.h"
+#include "host_bench.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#define FRAMES_PER_CALL 16
+
+static std::vector<uint8_t> ReadFile(const char* path) {
+    std::vector<uint8_t> data;
+    FILE* file = fopen(path, "rb");
+    if (file == nullptr) {
+        return data;
+    }
+    uint8_t chunk[4096];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        data.insert(data.end(), chunk, chunk + n);
+    }
+    fclose(file);
+    return data;
+}
+
+// Something like a drawn emoji: a moving disc of a few colors on a transparent background
+static std::vector<uint8_t> GenerateGif(int width, int height, int frames) {
+    const int colors = 64;
+    std::mt19937 random(width);
+    std::vector<uint8_t> palette(colors * 3);
+    for (auto& component : palette) {
+        component = random() & 0xFF;
+    }
+    GifWriter writer(width, height, palette);
+    for (int i = 0; i < frames; i++) {
+        GifWriterFrame frame;
+        frame.width = width;
+        frame.height = height;
+        frame.transparent = 0;
+        frame.disposal = 2;
+        frame.indices.resize(width * height);
+        int cx = width / 2 + i * 3 % (width / 4), cy = height / 2, r = std::min(width, height) * 2 / 5;
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                int dx = x - cx, dy = y - cy;
+                frame.indices[y * width + x] = dx * dx + dy * dy < r * r ? 1 + (x / 6 + y / 6 + i) % (colors - 1) : 0;
+            }
+        }
+        writer.AddFrame(frame);
+    }
+    return writer.Finish();
+}
+
+// Decodes and renders FRAMES_PER_CALL frames, looping as the player does
+static double TimeDecoder(const GifDecoderApi& api, const std::string& name, const std::vector<uint8_t>& data) {
+    gd_GIF* gif = api.open_data(data.data());
+    if (gif == nullptr) {
+        printf("%s: not a GIF\n", name.c_str());
+        return 0;
+    }
+    std::string label = name + ", " + api.name;
+    double ns = Benchmark(label.c_str(), 4, [&]() {
+        for (int i = 0; i < FRAMES_PER_CALL; i++) {
+            if (api.get_frame(gif) <= 0) {
+                api.rewind(gif);
+                api.get_frame(gif);
+            }
+            api.render_frame(gif, gif->canvas);
+        }
+        KeepResult(gif->canvas[0]);
+    });
+    api.close(gif);
+    return ns / FRAMES_PER_CALL;
+}
+
+static void Compare(const std::string& name, const std::vector<uint8_t>& data) {
+    double current_ns = TimeDecoder(kCurrentGifDecoder, name, data);
+    double reference_ns = TimeDecoder(kReferenceGifDecoder, name, data);
+    if (current_ns > 0 && reference_ns > 0) {
+        printf("%-48s %7.1f us/frame vs %7.1f us/frame, %.2fx\n\n", name.c_str(), current_ns / 1000,
+            reference_ns / 1000, reference_ns / current_ns);
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1) {
+        for (int i = 1; i < argc; i++) {
+            auto data = ReadFile(argv[i]);
+            if (data.empty()) {
+                printf("%s: cannot read\n", argv[i]);
+                continue;
+            }
+            std::string name = argv[i];
+            size_t slash = name.find_last_of('/');
+            Compare(slash == std::string::npos ? name : name.substr(slash + 1), data);
+        }
+        return 0;
+    }
+
+    const int sizes[][2] = {{160, 160}, {240, 240}, {320, 240}};
+    for (auto& size : sizes) {
+        Compare("generated " + std::to_string(size[0]) + "x" + std::to_string(size[1]),
+            GenerateGif(size[0], size[1], 24));
+    }
+    return 0;
+}
@@ -0,0 +1,42 @@
+#ifndef GIFDEC_REFERENCE_H
+#define GIFDEC_REFERENCE_H
+
+// The previous GIF decoder, see gifdec_reference.c
+#include "gifdec.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+gd_GIF* ref_gd_open_gif_file(const char* fname);
+gd_GIF* ref_gd_open_gif_data(const void* data);
+void ref_gd_render_frame(gd_GIF* gif, uint8_t* buffer);
+int ref_gd_get_frame(gd_GIF* gif);
+void ref_gd_rewind(gd_GIF* gif);
+void ref_gd_close_gif(gd_GIF* gif);
+
+#ifdef __cplusplus
+}
+#endif
+
+// Both decoders behind one set of pointers
+struct GifDecoderApi {
+    const char* name;
+    gd_GIF* (*open_file)(const char* fname);
+    gd_GIF* (*open_data)(const void* data);
+    void (*render_frame)(gd_GIF* gif, uint8_t* buffer);
+    int (*get_frame)(gd_GIF* gif);
+    void (*rewind)(gd_GIF* gif);
+    void (*close)(gd_GIF* gif);
+};
+
+static const GifDecoderApi kCurrentGifDecoder = {
+    "current", gd_open_gif_file, gd_open_gif_data, gd_render_frame, gd_get_frame, gd_rewind, gd_close_gif,
+};
+
+static const GifDecoderApi kReferenceGifDecoder = {
+    "reference", ref_gd_open_gif_file, ref_gd_open_gif_data, ref_gd_render_frame, ref_gd_get_frame, ref_gd_rewind,
+    ref_gd_close_gif,
+};
+
+#endif // GIFDEC_REFERENCE_H
@@ -0,0 +1,324 @@
+// The GIF decoder against the previous one (gifdec_reference.c): every frame of generated
+// GIFs must come out byte for byte the same, over two loops, from memory and from a file.
+// The GIFs cover the corners of the format the LZW reader and the palette kernels touch.
+#include "gifdec_reference.h"
+#include "gif_writer.h"
+#include "host_test.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+struct DecodedGif {
+    bool opened = false;
+    std::vector<int> results;                   // gd_get_frame() results, in order
+    std::vector<std::vector<uint8_t>> canvases; // Canvas after each frame, BGRA
+    std::vector<uint16_t> delays;
+    std::vector<int32_t> loop_counts;
+};
+
+// Plays the GIF as LvglGif does: every frame is rendered onto the canvas it was disposed on
+static DecodedGif Decode(const GifDecoderApi& api, gd_GIF* gif, int max_frames) {
+    DecodedGif decoded;
+    if (gif == nullptr) {
+        return decoded;
+    }
+    decoded.opened = true;
+    size_t canvas_size = (size_t)gif->width * gif->height * 4;
+    decoded.canvases.emplace_back(gif->canvas, gif->canvas + canvas_size);
+    for (int i = 0; i < max_frames; i++) {
+        int result = api.get_frame(gif);
+        decoded.results.push_back(result);
+        decoded.loop_counts.push_back(gif->loop_count);
+        if (result == 0) {
+            // End of a finite loop: start over as Stop() and Start() would
+            api.rewind(gif);
+            continue;
+        }
+        if (result < 0) {
+            break;
+        }
+        api.render_frame(gif, gif->canvas);
+        decoded.canvases.emplace_back(gif->canvas, gif->canvas + canvas_size);
+        decoded.delays.push_back(gif->gce.delay);
+    }
+    api.close(gif);
+    return decoded;
+}
+
+static DecodedGif DecodeData(const GifDecoderApi& api, const std::vector<uint8_t>& data, int max_frames) {
+    return Decode(api, api.open_data(data.data()), max_frames);
+}
+
+static DecodedGif DecodeFile(const GifDecoderApi& api, const std::vector<uint8_t>& data, int max_frames) {
+    std::string path = std::string(P_tmpdir) + "/gifdec_test_" + api.name + ".gif";
+    FILE* file = fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        return DecodedGif();
+    }
+    fwrite(data.data(), 1, data.size(), file);
+    fclose(file);
+    DecodedGif decoded = Decode(api, api.open_file(path.c_str()), max_frames);
+    remove(path.c_str());
+    return decoded;
+}
+
+static bool SameDecoding(const DecodedGif& current, const DecodedGif& reference) {
+    if (current.opened != reference.opened || current.results != reference.results ||
+        current.delays != reference.delays || current.loop_counts != reference.loop_counts ||
+        current.canvases.size() != reference.canvases.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < current.canvases.size(); i++) {
+        if (current.canvases[i] != reference.canvases[i]) {
+            size_t byte = 0;
+            while (current.canvases[i][byte] == reference.canvases[i][byte]) {
+                byte++;
+            }
+            fprintf(stderr, "canvas %u differs at pixel %u\n", (unsigned)i, (unsigned)byte / 4);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Decodes with both decoders, from memory and from a file, and returns the current decoding
+static DecodedGif CheckSameAsReference(const std::vector<uint8_t>& data, int max_frames) {
+    DecodedGif current = DecodeData(kCurrentGifDecoder, data, max_frames);
+    CHECK(SameDecoding(current, DecodeData(kReferenceGifDecoder, data, max_frames)));
+    DecodedGif current_file = DecodeFile(kCurrentGifDecoder, data, max_frames);
+    CHECK(current_file.opened);
+    CHECK(SameDecoding(current_file, DecodeFile(kReferenceGifDecoder, data, max_frames)));
+    CHECK(SameDecoding(current_file, current));
+    return current;
+}
+
+static std::vector<uint8_t> Palette(int colors, uint32_t seed) {
+    std::mt19937 random(seed);
+    std::vector<uint8_t> palette(colors * 3);
+    for (auto& component : palette) {
+        component = random() & 0xFF;
+    }
+    return palette;
+}
+
+static std::vector<uint8_t> RandomIndices(size_t count, int colors, std::mt19937& random) {
+    std::vector<uint8_t> indices(count);
+    for (auto& index : indices) {
+        index = random() % colors;
+    }
+    return indices;
+}
+
+// Runs of one color with some noise, closer to drawn emoji than pure noise
+static std::vector<uint8_t> BlobIndices(int width, int height, int colors, std::mt19937& random) {
+    std::vector<uint8_t> indices(width * height);
+    int cx = random() % width, cy = random() % height, r = 1 + random() % (std::max(width, height) / 2 + 1);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            int dx = x - cx, dy = y - cy;
+            int index = dx * dx + dy * dy < r * r ? 1 + (x / 4 + y / 4) % (colors - 1) : 0;
+            if (random() % 16 == 0) {
+                index = random() % colors;
+            }
+            indices[y * width + x] = index;
+        }
+    }
+    return indices;
+}
+
+// A full opaque frame leaves just its palette colors on the canvas, as B, G, R, A
+static bool CanvasShows(const std::vector<uint8_t>& canvas, const std::vector<uint8_t>& palette,
+    const std::vector<uint8_t>& indices) {
+    for (size_t p = 0; p < indices.size(); p++) {
+        const uint8_t* rgb = &palette[indices[p] * 3];
+        if (canvas[p * 4 + 0] != rgb[2] || canvas[p * 4 + 1] != rgb[1] || canvas[p * 4 + 2] != rgb[0] ||
+            canvas[p * 4 + 3] != 0xFF) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void TestFullFramesMatchPalette() {
+    const int width = 13, height = 7, colors = 6;
+    auto palette = Palette(colors, 1);
+    GifWriter writer(width, height, palette);
+    std::mt19937 random(1);
+    std::vector<std::vector<uint8_t>> frames;
+    for (int i = 0; i < 4; i++) {
+        GifWriterFrame frame;
+        frame.width = width;
+        frame.height = height;
+        frame.indices = RandomIndices(width * height, colors, random);
+        frame.delay = 5 + i;
+        frames.push_back(frame.indices);
+        writer.AddFrame(frame);
+    }
+    auto decoded = CheckSameAsReference(writer.Finish(), 10);
+
+    // Not only the same as before, also right
+    CHECK(decoded.delays.size() >= frames.size());
+    for (size_t i = 0; i < frames.size() && i + 1 < decoded.canvases.size(); i++) {
+        CHECK(CanvasShows(decoded.canvases[i + 1], palette, frames[i]));
+        CHECK(decoded.delays[i] == 5 + i);
+    }
+}
+
+static void TestOddSizes() {
+    // Widths around the 4 pixel unrolling, single rows and columns
+    const int sizes[][2] = {{1, 1}, {1, 9}, {9, 1}, {2, 3}, {3, 2}, {5, 5}, {7, 3}, {4, 4}, {17, 6}};
+    std::mt19937 random(2);
+    for (auto& size : sizes) {
+        int width = size[0], height = size[1];
+        for (int colors : {2, 4, 16, 256}) {
+            GifWriter writer(width, height, Palette(colors, colors), colors / 2);
+            for (int i = 0; i < 3; i++) {
+                GifWriterFrame frame;
+                frame.width = width;
+                frame.height = height;
+                frame.indices = RandomIndices(width * height, colors, random);
+                writer.AddFrame(frame);
+            }
+            CheckSameAsReference(writer.Finish(), 8);
+        }
+    }
+}
+
+static void TestTransparencyAndDisposal() {
+    const int width = 40, height = 30, colors = 16;
+    std::mt19937 random(3);
+    for (int background : {0, 5}) {
+        GifWriter writer(width, height, Palette(colors, 3), background);
+        for (int i = 0; i < 12; i++) {
+            GifWriterFrame frame;
+            frame.x = random() % (width / 2);
+            frame.y = random() % (height / 2);
+            frame.width = 1 + random() % (width - frame.x);
+            frame.height = 1 + random() % (height - frame.y);
+            frame.indices = BlobIndices(frame.width, frame.height, colors, random);
+            frame.transparent = i % 3 == 0 ? -1 : (int)(random() % colors);
+            frame.disposal = i % 4;
+            writer.AddFrame(frame);
+        }
+        CheckSameAsReference(writer.Finish(), 30);
+    }
+}
+
+static void TestLocalPalettes() {
+    const int width = 24, height = 20;
+    std::mt19937 random(4);
+    GifWriter writer(width, height, Palette(4, 4), 1);
+    for (int i = 0; i < 6; i++) {
+        GifWriterFrame frame;
+        int colors = 2 << (i % 8);
+        frame.x = i;
+        frame.y = i / 2;
+        frame.width = width - frame.x;
+        frame.height = height - frame.y;
+        frame.indices = BlobIndices(frame.width, frame.height, colors, random);
+        if (i % 2 == 1) {
+            frame.local_palette = Palette(colors, 40 + i);
+        } else {
+            frame.indices = RandomIndices(frame.width * frame.height, 4, random);
+        }
+        frame.transparent = i == 3 ? 0 : -1;
+        writer.AddFrame(frame);
+    }
+    CheckSameAsReference(writer.Finish(), 15);
+}
+
+static void TestInterlaced() {
+    std::mt19937 random(5);
+    // Heights around the pass boundaries of 8, 4 and 2 rows
+    for (int height = 1; height <= 17; height++) {
+        const int width = 11, colors = 8;
+        auto palette = Palette(colors, 5);
+        GifWriter writer(width, height, palette);
+        std::vector<std::vector<uint8_t>> frames;
+        for (int i = 0; i < 2; i++) {
+            GifWriterFrame frame;
+            frame.width = width;
+            frame.height = height;
+            frame.indices = RandomIndices(width * height, colors, random);
+            frame.interlaced = true;
+            frames.push_back(frame.indices);
+            writer.AddFrame(frame);
+        }
+        auto data = writer.Finish();
+        // The reference puts the rows of frames under 5 lines past the frame, only check those are right
+        auto decoded = height >= 5 ? CheckSameAsReference(data, 2) : DecodeData(kCurrentGifDecoder, data, 2);
+        CHECK(decoded.canvases.size() == 3);
+        for (size_t i = 0; i < frames.size() && i + 1 < decoded.canvases.size(); i++) {
+            CHECK(CanvasShows(decoded.canvases[i + 1], palette, frames[i]));
+        }
+    }
+}
+
+static void TestFullCodeTables() {
+    // Noise fills the 4096 entry code table several times, with 12 bit codes and clears
+    const int width = 320, height = 240;
+    std::mt19937 random(6);
+    for (int colors : {2, 32, 256}) {
+        GifWriter writer(width, height, Palette(colors, 6));
+        for (int i = 0; i < 2; i++) {
+            GifWriterFrame frame;
+            frame.width = width;
+            frame.height = height;
+            frame.indices = RandomIndices(width * height, colors, random);
+            writer.AddFrame(frame);
+        }
+        CheckSameAsReference(writer.Finish(), 5);
+    }
+}
+
+static void TestLoopCount() {
+    const int width = 8, height = 8, colors = 4;
+    std::mt19937 random(7);
+    for (int loop_count : {-1, 0, 1, 3}) {
+        GifWriter writer(width, height, Palette(colors, 7), 0, loop_count);
+        for (int i = 0; i < 3; i++) {
+            GifWriterFrame frame;
+            frame.width = width;
+            frame.height = height;
+            frame.indices = RandomIndices(width * height, colors, random);
+            writer.AddFrame(frame);
+        }
+        auto decoded = CheckSameAsReference(writer.Finish(), 14);
+        // Infinite loops never report the end, finite ones do
+        bool ended = std::find(decoded.results.begin(), decoded.results.end(), 0) != decoded.results.end();
+        CHECK(ended == (loop_count != 0));
+    }
+}
+
+static void TestBadInput() {
+    // Not a GIF, and a frame that does not fit the screen: both refuse the same way
+    std::vector<uint8_t> not_gif = {'P', 'N', 'G', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+    CHECK(!DecodeData(kCurrentGifDecoder, not_gif, 1).opened);
+    CHECK(!DecodeData(kReferenceGifDecoder, not_gif, 1).opened);
+
+    GifWriter writer(8, 8, Palette(4, 8));
+    GifWriterFrame frame;
+    frame.x = 4;
+    frame.width = 8;
+    frame.height = 8;
+    frame.indices.assign(64, 1);
+    writer.AddFrame(frame);
+    auto decoded = CheckSameAsReference(writer.Finish(), 3);
+    CHECK(!decoded.results.empty() && decoded.results[0] < 0);
+}
+
+int main() {
+    RUN_TEST(TestFullFramesMatchPalette);
+    RUN_TEST(TestOddSizes);
+    RUN_TEST(TestTransparencyAndDisposal);
+    RUN_TEST(TestLocalPalettes);
+    RUN_TEST(TestInterlaced);
+    RUN_TEST(TestFullCodeTables);
+    RUN_TEST(TestLoopCount);
+    RUN_TEST(TestBadInput);
+    return HostTestFailures() == 0 ? 0 : 1;
+}
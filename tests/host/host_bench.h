@@ -0,0 +1,32 @@
+#ifndef HOST_BENCH_H
+#define HOST_BENCH_H
+
+#include <chrono>
+#include <cstdio>
+
+// Prevents the compiler from dropping a result that is otherwise unused
+template <typename T>
+inline void KeepResult(const T& value) {
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+// Runs fn iterations times, best of 5 rounds, and prints the time per call.
+// Host numbers only compare implementations, they are not device timings.
+template <typename Fn>
+inline double Benchmark(const char* name, long iterations, Fn&& fn) {
+    double best_ns = 0;
+    for (int round = 0; round < 5; round++) {
+        auto start = std::chrono::steady_clock::now();
+        for (long i = 0; i < iterations; i++) {
+            fn();
+        }
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / iterations;
+        if (round == 0 || ns < best_ns) {
+            best_ns = ns;
+        }
+    }
+    printf("%-48s %10.1f ns\n", name, best_ns);
+    return best_ns;
+}
+
+#endif // HOST_BENCH_H
@@ -0,0 +1,53 @@
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+#include <esp_timer.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <thread>
+
+// Minimal checks for the host tests, a failed check is reported and the test goes on
+inline int& HostTestFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(condition) do {                                                   \
+        if (!(condition)) {                                                     \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            HostTestFailures()++;                                               \
+        }                                                                       \
+    } while (0)
+
+#define CHECK_NEAR(actual, expected, tolerance) do {                            \
+        double actual_ = (actual), expected_ = (expected);                      \
+        if (std::fabs(actual_ - expected_) > (tolerance)) {                     \
+            fprintf(stderr, "%s:%d: CHECK_NEAR(%s, %s) failed: %f vs %f\n",     \
+                __FILE__, __LINE__, #actual, #expected, actual_, expected_);    \
+            HostTestFailures()++;                                               \
+        }                                                                       \
+    } while (0)
+
+#define RUN_TEST(test) do {                                                     \
+        int failures_before_ = HostTestFailures();                              \
+        fprintf(stderr, "[ RUN  ] %s\n", #test);                                \
+        test();                                                                 \
+        fprintf(stderr, "[ %s ] %s\n", HostTestFailures() == failures_before_ ? " OK " : "FAIL", #test); \
+    } while (0)
+
+// Polls until the condition holds or the timeout passes, returns the last result
+inline bool WaitFor(std::function<bool()> condition, int timeout_ms) {
+    int64_t deadline = esp_timer_get_time() + (int64_t)timeout_ms * 1000;
+    while (!condition()) {
+        if (esp_timer_get_time() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return true;
+}
+
+#endif // HOST_TEST_H
@@ -0,0 +1,79 @@
+// Time a caller spends in a display call while the LVGL task renders: taking the display
+// lock as the calls used to, against LvglUiQueue::Defer(). The LVGL task holds its lock
+// for a 25 ms frame every 33 ms, the caller updates the status every 7 ms.
+// Only the shape of the numbers carries over to the device, not the values.
+#include "lvgl_ui_queue.h"
+
+#include <esp_lvgl_port.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define FRAME_MS 25
+#define FRAME_GAP_MS 8
+#define CALL_PERIOD_MS 7
+#define CALLS 300
+
+static std::string status;
+
+static void PrintLatency(const char* name, std::vector<int64_t>& samples) {
+    std::sort(samples.begin(), samples.end());
+    auto at = [&](int percent) { return samples[(samples.size() - 1) * percent / 100]; };
+    printf("%-36s p50 %6lld us   p90 %6lld us   p99 %6lld us   max %6lld us\n", name,
+        (long long)at(50), (long long)at(90), (long long)at(99), (long long)samples.back());
+}
+
+template <typename Fn>
+static std::vector<int64_t> Measure(Fn&& call) {
+    std::atomic<bool> running = true;
+    std::thread lvgl_task([&running]() {
+        while (running) {
+            lvgl_port_lock(0);
+            lv_timer_handler();
+            std::this_thread::sleep_for(std::chrono::milliseconds(FRAME_MS));
+            lvgl_port_unlock();
+            std::this_thread::sleep_for(std::chrono::milliseconds(FRAME_GAP_MS));
+        }
+    });
+
+    std::vector<int64_t> samples;
+    for (int i = 0; i < CALLS; i++) {
+        int64_t start_us = esp_timer_get_time();
+        call(i);
+        samples.push_back(esp_timer_get_time() - start_us);
+        std::this_thread::sleep_for(std::chrono::milliseconds(CALL_PERIOD_MS));
+    }
+    running = false;
+    lvgl_task.join();
+    return samples;
+}
+
+int main() {
+    auto locked = Measure([](int i) {
+        lvgl_port_lock(0);
+        status = "status " + std::to_string(i);
+        lvgl_port_unlock();
+    });
+    PrintLatency("SetStatus, display lock", locked);
+
+    LvglUiQueue queue;
+    lvgl_port_lock(0);
+    queue.Start([](const LvglUiCommand& command) {
+        status = command.text;
+    });
+    lvgl_port_unlock();
+    auto deferred = Measure([&queue](int i) {
+        queue.Defer(kUiCommandStatus, ("status " + std::to_string(i)).c_str());
+    });
+    PrintLatency("SetStatus, LvglUiQueue::Defer", deferred);
+
+    auto stats = queue.GetStats();
+    printf("queue: posted %u, coalesced %u, applied %u, max depth %u\n",
+        (unsigned)stats.posted, (unsigned)stats.coalesced, (unsigned)stats.applied, (unsigned)stats.max_depth);
+    return 0;
+}
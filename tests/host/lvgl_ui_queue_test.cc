@@ -0,0 +1,236 @@
+// LvglUiQueue on its own: synchronous calls before Start(), coalescing, chat order and
+// clears, the queue cap, Flush(), and waking the LVGL task only for the first command.
+// The test's main thread plays the LVGL task.
+#include "lvgl_ui_queue.h"
+#include "host_test.h"
+
+#include <esp_lvgl_port.h>
+
+#include <string>
+#include <vector>
+
+// Matches LVGL_UI_QUEUE_MAX_COMMANDS in lvgl_ui_queue.cc
+#define MAX_COMMANDS 32
+
+static const char* TypeName(LvglUiCommandType type) {
+    switch (type) {
+    case kUiCommandStatus: return "status";
+    case kUiCommandNotification: return "notification";
+    case kUiCommandEmotion: return "emotion";
+    case kUiCommandChatMessage: return "chat";
+    case kUiCommandClearChat: return "clear";
+    case kUiCommandShowStandby: return "show";
+    case kUiCommandHideStandby: return "hide";
+    case kUiCommandUpdateStandby: return "update";
+    }
+    return "?";
+}
+
+// A started queue that records the commands it applies as "type:text"
+struct QueueFixture {
+    LvglUiQueue queue;
+    std::vector<std::string> applied;
+    bool applied_synchronously = true;
+
+    QueueFixture() {
+        lvgl_port_lock(0);
+        queue.Start([this](const LvglUiCommand& command) {
+            applied.push_back(std::string(TypeName(command.type)) + ":" + command.text);
+            // The display method called back must run now, not queue itself again
+            applied_synchronously = applied_synchronously && queue.IsApplying() && !queue.Defer(command.type);
+        });
+        lvgl_port_unlock();
+    }
+
+    // One pass of the LVGL task
+    void RunLvgl() {
+        lvgl_port_lock(0);
+        lv_timer_handler();
+        lvgl_port_unlock();
+    }
+};
+
+static void TestSynchronousBeforeStart() {
+    LvglUiQueue queue;
+    CHECK(!queue.Defer(kUiCommandStatus, "a"));
+    CHECK(queue.GetStats().posted == 0);
+}
+
+static void TestLatestOfAKindWins() {
+    QueueFixture fixture;
+    CHECK(fixture.queue.Defer(kUiCommandStatus, "a"));
+    CHECK(fixture.queue.Defer(kUiCommandChatMessage, "1", "user"));
+    CHECK(fixture.queue.Defer(kUiCommandStatus, "b"));
+    CHECK(fixture.queue.Defer(kUiCommandEmotion, "happy"));
+    CHECK(fixture.queue.Defer(kUiCommandEmotion, "sad"));
+    CHECK(fixture.queue.Defer(kUiCommandNotification, "n"));
+    CHECK(fixture.applied.empty());
+
+    fixture.RunLvgl();
+    // The replacement takes the place of the newest call, after the chat message
+    std::vector<std::string> expected = {"chat:1", "status:b", "emotion:sad", "notification:n"};
+    CHECK(fixture.applied == expected);
+    CHECK(fixture.applied_synchronously);
+
+    auto stats = fixture.queue.GetStats();
+    CHECK(stats.posted == 6);
+    CHECK(stats.coalesced == 2);
+    CHECK(stats.applied == 4);
+    CHECK(stats.max_depth == 4);
+}
+
+static void TestStandbyShowAndHideReplaceEachOther() {
+    QueueFixture fixture;
+    fixture.queue.Defer(kUiCommandShowStandby);
+    fixture.queue.Defer(kUiCommandUpdateStandby);
+    fixture.queue.Defer(kUiCommandHideStandby);
+    fixture.queue.Defer(kUiCommandUpdateStandby);
+    fixture.RunLvgl();
+    std::vector<std::string> expected = {"hide:", "update:"};
+    CHECK(fixture.applied == expected);
+}
+
+static void TestClearDropsEarlierChat() {
+    QueueFixture fixture;
+    fixture.queue.Defer(kUiCommandChatMessage, "1", "user");
+    fixture.queue.Defer(kUiCommandStatus, "s");
+    fixture.queue.Defer(kUiCommandClearChat);
+    fixture.queue.Defer(kUiCommandChatMessage, "2", "assistant");
+    fixture.queue.Defer(kUiCommandChatMessage, "3", "assistant");
+    fixture.queue.Defer(kUiCommandClearChat);
+    fixture.queue.Defer(kUiCommandChatMessage, "4", "assistant");
+    fixture.queue.Defer(kUiCommandChatMessage, "5", "assistant");
+    fixture.RunLvgl();
+    std::vector<std::string> expected = {"status:s", "clear:", "chat:4", "chat:5"};
+    CHECK(fixture.applied == expected);
+    CHECK(fixture.queue.GetStats().coalesced == 4);
+}
+
+static void TestFullQueueDropsOldestChat() {
+    QueueFixture fixture;
+    fixture.queue.Defer(kUiCommandStatus, "s");
+    const int messages = 40;
+    for (int i = 0; i < messages; i++) {
+        CHECK(fixture.queue.Defer(kUiCommandChatMessage, std::to_string(i).c_str(), "assistant"));
+    }
+    auto stats = fixture.queue.GetStats();
+    CHECK(stats.max_depth == MAX_COMMANDS);
+    CHECK(stats.dropped == messages - (MAX_COMMANDS - 1));
+
+    fixture.RunLvgl();
+    CHECK(fixture.applied.size() == MAX_COMMANDS);
+    CHECK(fixture.applied.front() == "status:s");
+    // The newest messages are the ones kept, still in order
+    for (size_t i = 1; i < fixture.applied.size(); i++) {
+        CHECK(fixture.applied[i] == "chat:" + std::to_string(messages - MAX_COMMANDS + i));
+    }
+}
+
+static void TestFlushAppliesInCallingTask() {
+    QueueFixture fixture;
+    fixture.queue.Defer(kUiCommandChatMessage, "1", "user");
+    fixture.queue.Defer(kUiCommandEmotion, "happy");
+
+    // What a display call that is not queued does once it holds the lock
+    lvgl_port_lock(0);
+    fixture.queue.Flush();
+    std::vector<std::string> expected = {"chat:1", "emotion:happy"};
+    CHECK(fixture.applied == expected);
+    CHECK(fixture.applied_synchronously);
+    lvgl_port_unlock();
+
+    // Nothing is left for the LVGL task, and the drain that finds the queue empty is harmless
+    fixture.RunLvgl();
+    CHECK(fixture.applied.size() == 2);
+    CHECK(fixture.queue.GetStats().applied == 2);
+}
+
+static void TestFlushWhileApplyingKeepsOrder() {
+    LvglUiQueue queue;
+    std::vector<std::string> applied;
+    lvgl_port_lock(0);
+    queue.Start([&](const LvglUiCommand& command) {
+        applied.push_back(command.text);
+        if (command.text == "1") {
+            // Another task posts while the batch is applied, then the applied call flushes:
+            // "2" must still wait for "1b"
+            std::thread([&queue]() { queue.Defer(kUiCommandChatMessage, "2", "user"); }).join();
+            queue.Flush();
+        }
+    });
+    queue.Defer(kUiCommandChatMessage, "1", "user");
+    queue.Defer(kUiCommandChatMessage, "1b", "user");
+    lv_timer_handler();
+    lvgl_port_unlock();
+    std::vector<std::string> first_pass = {"1", "1b"};
+    CHECK(applied == first_pass);
+    // "2" goes with the next drain, one timer period later
+    WaitFor([&]() {
+        lvgl_port_lock(0);
+        lv_timer_handler();
+        lvgl_port_unlock();
+        return applied.size() == 3;
+    }, 1000);
+    std::vector<std::string> expected = {"1", "1b", "2"};
+    CHECK(applied == expected);
+}
+
+static void TestOnlyFirstCommandWakesTheLvglTask() {
+    QueueFixture fixture;
+    uint32_t wakes = lvgl_port_task_wakes();
+    fixture.queue.Defer(kUiCommandStatus, "a");
+    CHECK(lvgl_port_task_wakes() == wakes + 1);
+    fixture.queue.Defer(kUiCommandStatus, "b");
+    fixture.queue.Defer(kUiCommandChatMessage, "1", "user");
+    CHECK(lvgl_port_task_wakes() == wakes + 1);
+
+    fixture.RunLvgl();
+    CHECK(fixture.applied.size() == 2);
+    // The drain timer keeps running until a drain finds the queue empty and pauses it
+    fixture.queue.Defer(kUiCommandStatus, "c");
+    CHECK(lvgl_port_task_wakes() == wakes + 1);
+    WaitFor([&]() {
+        fixture.RunLvgl();
+        return fixture.applied.size() == 3;
+    }, 1000);
+    // Once a drain finds nothing, the next command has to wake the LVGL task again
+    int64_t idle_until_us = esp_timer_get_time() + 100 * 1000;
+    while (esp_timer_get_time() < idle_until_us) {
+        fixture.RunLvgl();
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    fixture.queue.Defer(kUiCommandStatus, "d");
+    CHECK(lvgl_port_task_wakes() == wakes + 2);
+}
+
+static void TestWakeRetriesWhileLocked() {
+    QueueFixture fixture;
+    uint32_t wakes = lvgl_port_task_wakes();
+
+    // A frame is rendering: the caller neither waits for it nor loses the wake
+    lvgl_port_lock(0);
+    int64_t start_us = esp_timer_get_time();
+    std::thread([&fixture]() { fixture.queue.Defer(kUiCommandStatus, "a"); }).join();
+    CHECK(esp_timer_get_time() - start_us < 100 * 1000);
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    CHECK(lvgl_port_task_wakes() == wakes);
+    lvgl_port_unlock();
+
+    CHECK(WaitFor([&]() { return lvgl_port_task_wakes() == wakes + 1; }, 1000));
+    fixture.RunLvgl();
+    std::vector<std::string> expected = {"status:a"};
+    CHECK(fixture.applied == expected);
+}
+
+int main() {
+    RUN_TEST(TestSynchronousBeforeStart);
+    RUN_TEST(TestLatestOfAKindWins);
+    RUN_TEST(TestStandbyShowAndHideReplaceEachOther);
+    RUN_TEST(TestClearDropsEarlierChat);
+    RUN_TEST(TestFullQueueDropsOldestChat);
+    RUN_TEST(TestFlushAppliesInCallingTask);
+    RUN_TEST(TestFlushWhileApplyingKeepsOrder);
+    RUN_TEST(TestOnlyFirstCommandWakesTheLvglTask);
+    RUN_TEST(TestWakeRetriesWhileLocked);
+    return HostTestFailures() == 0 ? 0 : 1;
+}
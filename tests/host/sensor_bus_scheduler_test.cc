@@ -0,0 +1,295 @@
+// SensorBusScheduler with several simulated sensors on one fake bus: two DHT20 drivers on
+// their own DHT20Simulator plus scripted sensors with other channel counts and timings.
+#include "sensors/sensor_bus_scheduler.h"
+#include "dht20/dht20.h"
+#include "dht20/dht20_simulator.h"
+#include "host_test.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Every trigger and poll on the fake bus, in order
+struct BusEvent {
+    std::string sensor;
+    char kind;      // 'T' trigger, 'P' poll
+    int64_t time_us;
+};
+
+static std::mutex bus_mutex;
+static std::vector<BusEvent> bus_log;
+
+static void LogBus(const char* sensor, char kind) {
+    std::lock_guard<std::mutex> lock(bus_mutex);
+    bus_log.push_back(BusEvent{sensor, kind, esp_timer_get_time()});
+}
+
+// Passes through to a real driver and records its bus traffic
+class LoggingSensor : public Sensor {
+public:
+    LoggingSensor(const char* name, Sensor* sensor) : name_(name), sensor_(sensor) {}
+
+    const char* GetName() const override { return name_; }
+    int GetChannelCount() const override { return sensor_->GetChannelCount(); }
+    const char* GetChannelName(int channel) const override { return sensor_->GetChannelName(channel); }
+    int GetConversionTimeMs() const override { return sensor_->GetConversionTimeMs(); }
+    bool StartMeasurement() override {
+        LogBus(name_, 'T');
+        return sensor_->StartMeasurement();
+    }
+    SensorStatus PollResult(float* values) override {
+        LogBus(name_, 'P');
+        return sensor_->PollResult(values);
+    }
+
+private:
+    const char* name_;
+    Sensor* sensor_;
+};
+
+// Reports channel i as base + i; the conversion may take longer than advertised
+class FakeSensor : public Sensor {
+public:
+    FakeSensor(const char* name, int channels, int conversion_time_ms, int actual_time_ms, float base)
+        : name_(name), channels_(channels), conversion_time_ms_(conversion_time_ms),
+          actual_time_ms_(actual_time_ms), base_(base) {}
+
+    const char* GetName() const override { return name_; }
+    int GetChannelCount() const override { return channels_; }
+    const char* GetChannelName(int /* channel */) const override { return "value"; }
+    int GetConversionTimeMs() const override { return conversion_time_ms_; }
+    bool StartMeasurement() override {
+        LogBus(name_, 'T');
+        started_us_ = esp_timer_get_time();
+        pending_ = true;
+        return true;
+    }
+    SensorStatus PollResult(float* values) override {
+        LogBus(name_, 'P');
+        if (!pending_) {
+            return kSensorStatusError;
+        }
+        if (esp_timer_get_time() < started_us_ + actual_time_ms_ * 1000) {
+            return kSensorStatusBusy;
+        }
+        pending_ = false;
+        for (int i = 0; i < channels_; i++) {
+            values[i] = base_ + i;
+        }
+        return kSensorStatusReady;
+    }
+
+private:
+    const char* name_;
+    int channels_;
+    int conversion_time_ms_;
+    int actual_time_ms_;
+    float base_;
+    int64_t started_us_ = 0;
+    bool pending_ = false;
+};
+
+struct Delivered {
+    int ok = 0;
+    int failed = 0;
+    float values[SENSOR_MAX_CHANNELS] = {};
+    std::vector<int64_t> times_us;
+};
+
+// Results per sensor, filled by the scheduler task
+class Recorder {
+public:
+    SensorBusScheduler::ResultCallback Callback() {
+        return [this](Sensor* sensor, const float* values) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto& delivered = delivered_[sensor->GetName()];
+            if (values == nullptr) {
+                delivered.failed++;
+                return;
+            }
+            delivered.ok++;
+            memcpy(delivered.values, values, sensor->GetChannelCount() * sizeof(float));
+            delivered.times_us.push_back(esp_timer_get_time());
+        };
+    }
+
+    Delivered Get(const char* name) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return delivered_[name];
+    }
+
+private:
+    std::mutex mutex_;
+    std::map<std::string, Delivered> delivered_;
+};
+
+// The host vTaskDelete cannot stop a thread in the middle of a pass, so every test leaks its
+// scheduler and sensors and they keep running until the process exits
+struct Bus {
+    Recorder recorder;
+    SensorBusScheduler scheduler;
+
+    explicit Bus(const char* name) : scheduler(name, recorder.Callback()) {}
+};
+
+static Bus* NewBus(const char* name) {
+    std::lock_guard<std::mutex> lock(bus_mutex);
+    bus_log.clear();
+    return new Bus(name);
+}
+
+static std::vector<BusEvent> BusLog() {
+    std::lock_guard<std::mutex> lock(bus_mutex);
+    return bus_log;
+}
+
+static DHT20* NewDht20(DHT20Simulator*& simulator, float temperature, float humidity) {
+    simulator = new DHT20Simulator();
+    simulator->SetEnvironment(temperature, humidity);
+    auto dht20 = new DHT20(simulator);
+    CHECK(dht20->Initialize());
+    return dht20;
+}
+
+static void TestSensorsShareTheBus() {
+    auto bus = NewBus("shared");
+    DHT20Simulator* simulator_a;
+    DHT20Simulator* simulator_b;
+    auto dht20_a = new LoggingSensor("dht20_a", NewDht20(simulator_a, 21.0f, 40.0f));
+    auto dht20_b = new LoggingSensor("dht20_b", NewDht20(simulator_b, 30.0f, 70.0f));
+    auto fake = new FakeSensor("fake", 3, 30, 30, 1.0f);
+    CHECK(bus->scheduler.AddSensor(dht20_a, 200));
+    CHECK(bus->scheduler.AddSensor(dht20_b, 300));
+    CHECK(bus->scheduler.AddSensor(fake, 100));
+    int64_t start_us = esp_timer_get_time();
+    bus->scheduler.Start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(1500));
+    double elapsed_ms = (esp_timer_get_time() - start_us) / 1000.0;
+
+    auto a = bus->recorder.Get("dht20_a");
+    auto b = bus->recorder.Get("dht20_b");
+    auto f = bus->recorder.Get("fake");
+    CHECK_NEAR(a.values[0], 21.0, 0.01);
+    CHECK_NEAR(a.values[1], 40.0, 0.01);
+    CHECK_NEAR(b.values[0], 30.0, 0.01);
+    CHECK_NEAR(b.values[1], 70.0, 0.01);
+    CHECK(f.values[0] == 1.0f && f.values[1] == 2.0f && f.values[2] == 3.0f);
+    // Each sensor runs on its own period; allow a couple of results of jitter on the host
+    CHECK_NEAR(a.ok, elapsed_ms / 200, 2);
+    CHECK_NEAR(b.ok, elapsed_ms / 300, 2);
+    CHECK_NEAR(f.ok, elapsed_ms / 100, 3);
+    CHECK(a.failed + b.failed + f.failed == 0);
+
+    // All three were due together: the conversions are started back to back, then polled
+    auto log = BusLog();
+    CHECK(log.size() >= 6);
+    int triggers_before_first_poll = 0;
+    for (auto& event : log) {
+        if (event.kind == 'P') {
+            break;
+        }
+        triggers_before_first_poll++;
+    }
+    CHECK(triggers_before_first_poll == 3);
+
+    // Overlapping waits: the first round takes one DHT20 conversion, not the sum of all three
+    CHECK(a.times_us.size() > 0 && b.times_us.size() > 0);
+    int64_t first_round_us = std::max(a.times_us[0], b.times_us[0]) - start_us;
+    CHECK(first_round_us < (80 + 80 + 30) * 1000);
+
+    auto stats = bus->scheduler.GetStats();
+    CHECK(stats.errors == 0);
+    CHECK(stats.transactions >= (uint32_t)(a.ok + b.ok + f.ok) * 2);
+}
+
+static void TestFailingSensorDoesNotStallOthers() {
+    auto bus = NewBus("faulty");
+    DHT20Simulator* simulator_a;
+    DHT20Simulator* simulator_b;
+    auto dht20_a = NewDht20(simulator_a, 21.0f, 40.0f);
+    auto dht20_b = new LoggingSensor("dht20_b", NewDht20(simulator_b, 30.0f, 70.0f));
+    CHECK(bus->scheduler.AddSensor(dht20_a, 150));
+    CHECK(bus->scheduler.AddSensor(dht20_b, 150));
+    bus->scheduler.Start();
+    CHECK(WaitFor([bus]() { return bus->recorder.Get("DHT20").ok >= 2; }, 3000));
+
+    // Sensor A stops answering, B keeps its rate meanwhile
+    simulator_a->InjectFault(kDht20FaultNack);
+    auto b_before = bus->recorder.Get("dht20_b").ok;
+    CHECK(WaitFor([bus]() { return bus->recorder.Get("DHT20").failed >= 4; }, 3000));
+    auto b_during = bus->recorder.Get("dht20_b").ok - b_before;
+    CHECK(b_during >= 3);
+    CHECK(bus->recorder.Get("dht20_b").failed == 0);
+
+    // A recovers by itself once the bus answers again
+    simulator_a->InjectFault(kDht20FaultNone, 0);
+    int a_ok = bus->recorder.Get("DHT20").ok;
+    CHECK(WaitFor([bus, a_ok]() { return bus->recorder.Get("DHT20").ok > a_ok; }, 3000));
+    CHECK_NEAR(bus->recorder.Get("DHT20").values[0], 21.0, 0.01);
+    CHECK(bus->scheduler.GetStats().errors >= 4);
+}
+
+static void TestChannelCountIsChecked() {
+    auto bus = NewBus("channels");
+    auto too_wide = new FakeSensor("too_wide", SENSOR_MAX_CHANNELS + 1, 10, 10, 0.0f);
+    auto no_channels = new FakeSensor("no_channels", 0, 10, 10, 0.0f);
+    auto widest = new FakeSensor("widest", SENSOR_MAX_CHANNELS, 10, 10, 5.0f);
+    CHECK(!bus->scheduler.AddSensor(too_wide, 50));
+    CHECK(!bus->scheduler.AddSensor(no_channels, 50));
+    CHECK(bus->scheduler.AddSensor(widest, 50));
+    bus->scheduler.Start();
+    CHECK(WaitFor([bus]() { return bus->recorder.Get("widest").ok >= 3; }, 3000));
+
+    auto widest_delivered = bus->recorder.Get("widest");
+    for (int i = 0; i < SENSOR_MAX_CHANNELS; i++) {
+        CHECK(widest_delivered.values[i] == 5.0f + i);
+    }
+    // Earlier tests' buses still run, so only the rejected sensors must be absent
+    for (auto& event : BusLog()) {
+        CHECK(event.sensor != "too_wide" && event.sensor != "no_channels");
+    }
+}
+
+static void TestSlowConversionIsPolledAgain() {
+    auto bus = NewBus("slow");
+    // Advertises 20 ms but needs 70 ms, like a DHT20 that keeps its busy bit set
+    auto slow = new FakeSensor("slow", 1, 20, 70, 7.0f);
+    CHECK(bus->scheduler.AddSensor(slow, 200));
+    bus->scheduler.Start();
+    CHECK(WaitFor([bus]() { return bus->recorder.Get("slow").ok >= 3; }, 3000));
+
+    auto stats = bus->scheduler.GetStats();
+    CHECK(stats.busy_polls >= 3);
+    CHECK(stats.errors == 0);
+    CHECK(bus->recorder.Get("slow").values[0] == 7.0f);
+}
+
+static void TestSetPeriodPullsResultIn() {
+    auto bus = NewBus("period");
+    auto sensor = new FakeSensor("sensor", 1, 10, 10, 0.0f);
+    CHECK(bus->scheduler.AddSensor(sensor, 2000));
+    bus->scheduler.Start();
+    CHECK(WaitFor([bus]() { return bus->recorder.Get("sensor").ok >= 1; }, 1000));
+
+    // The next result would be 2 s out; a 100 ms period brings it in right away
+    int64_t changed_us = esp_timer_get_time();
+    bus->scheduler.SetPeriod(sensor, 100);
+    CHECK(WaitFor([bus]() { return bus->recorder.Get("sensor").ok >= 4; }, 1000));
+    CHECK(esp_timer_get_time() - changed_us < 1000 * 1000);
+}
+
+int main() {
+    RUN_TEST(TestSensorsShareTheBus);
+    RUN_TEST(TestFailingSensorDoesNotStallOthers);
+    RUN_TEST(TestChannelCountIsChecked);
+    RUN_TEST(TestSlowConversionIsPolledAgain);
+    RUN_TEST(TestSetPeriodPullsResultIn);
+
+    // Scheduler tasks keep running, skip the destructors they could race with
+    fflush(stderr);
+    std::_Exit(HostTestFailures() == 0 ? 0 : 1);
+}
@@ -0,0 +1,33 @@
+// Cost of SensorFilter::Process per sample for each smoothing mode over the test trace
+#include "sensor_filter.h"
+#include "host_bench.h"
+#include "sensor_trace.h"
+
+int main() {
+    auto trace = MakeSensorTrace(24 * 3600, 30);
+    const struct {
+        const char* name;
+        int median_window;
+        SensorFilterSmoothing smoothing;
+    } modes[] = {
+        {"Process, rate check only", 1, kSensorFilterSmoothingNone},
+        {"Process, median 3 + EMA", 3, kSensorFilterSmoothingEma},
+        {"Process, median 3 + Kalman", 3, kSensorFilterSmoothingKalman},
+        {"Process, median 7 + Kalman", 7, kSensorFilterSmoothingKalman},
+    };
+    for (auto& mode : modes) {
+        SensorFilterConfig config;
+        config.median_window = mode.median_window;
+        config.smoothing = mode.smoothing;
+        config.max_rate = 100;
+        SensorFilter filter(config);
+        size_t index = 0;
+        Benchmark(mode.name, (long)trace.size(), [&]() {
+            auto& point = trace[index++ % trace.size()];
+            int32_t output;
+            filter.Process(point.value, point.time_us + (int64_t)(index / trace.size()) * 24 * 3600 * 1000000, output);
+            KeepResult(output);
+        });
+    }
+    return 0;
+}
@@ -0,0 +1,209 @@
+// SensorFilter on its own: outlier rejection, step acceptance, EMA and Kalman
+// convergence, Reset, and accuracy over a noisy trace with spikes.
+#include "sensor_filter.h"
+#include "host_test.h"
+#include "sensor_trace.h"
+
+#include <cstdlib>
+
+// Matches SENSOR_FILTER_MAX_REJECTS in sensor_filter.cc
+#define MAX_REJECTS 3
+#define SECOND_US 1000000LL
+
+static SensorFilterConfig RateOnlyConfig() {
+    SensorFilterConfig config;
+    config.median_window = 1;
+    config.smoothing = kSensorFilterSmoothingNone;
+    config.max_rate = 100;
+    config.rate_margin = 20;
+    return config;
+}
+
+static void TestSpikeIsRejected() {
+    SensorFilter filter(RateOnlyConfig());
+    int32_t output = 0;
+    CHECK(filter.Process(2500, 0, output));
+    CHECK(filter.Process(2510, 1 * SECOND_US, output));
+    CHECK(output == 2510);
+
+    // 15°C in one second is far above 1°C/s plus the margin
+    CHECK(!filter.Process(4010, 2 * SECOND_US, output));
+    CHECK(output == 2510);
+    CHECK(filter.rejected() == 1);
+
+    // The spike does not move the reference, the next normal reading is accepted
+    CHECK(filter.Process(2520, 3 * SECOND_US, output));
+    CHECK(output == 2520);
+
+    // The allowed change grows with the time since the last accepted sample
+    CHECK(filter.Process(2520 + 100 * 5 + 20, 8 * SECOND_US, output));
+    CHECK(!filter.Process(3040 + 100 + 21, 9 * SECOND_US, output));
+}
+
+static void TestStepIsAcceptedAfterMaxRejects() {
+    SensorFilter filter(RateOnlyConfig());
+    int32_t output = 0;
+    CHECK(filter.Process(2500, 0, output));
+
+    int64_t time_us = 0;
+    for (int i = 0; i < MAX_REJECTS; i++) {
+        time_us += SECOND_US;
+        CHECK(!filter.Process(3500, time_us, output));
+        CHECK(output == 2500);
+    }
+    CHECK(filter.rejected() == MAX_REJECTS);
+
+    // One more in a row is a real step: the filter restarts at the new value
+    time_us += SECOND_US;
+    CHECK(filter.Process(3500, time_us, output));
+    CHECK(output == 3500);
+    CHECK(filter.rejected() == MAX_REJECTS);
+
+    // The counter starts over, a single spike after the step is rejected again
+    time_us += SECOND_US;
+    CHECK(!filter.Process(1000, time_us, output));
+    CHECK(output == 3500);
+}
+
+static void TestInterruptedRejectsDoNotAcceptStep() {
+    SensorFilter filter(RateOnlyConfig());
+    int32_t output = 0;
+    CHECK(filter.Process(2500, 0, output));
+
+    // Spikes separated by good readings never add up to a step
+    int64_t time_us = 0;
+    for (int i = 0; i < 10; i++) {
+        time_us += SECOND_US;
+        CHECK(!filter.Process(i % 2 ? 500 : 4500, time_us, output));
+        time_us += SECOND_US;
+        CHECK(filter.Process(2500, time_us, output));
+    }
+    CHECK(output == 2500);
+    CHECK(filter.rejected() == 10);
+}
+
+static void TestEmaConverges() {
+    SensorFilterConfig config;
+    config.median_window = 1;
+    config.smoothing = kSensorFilterSmoothingEma;
+    config.ema_shift = 2;
+    SensorFilter filter(config);
+
+    int32_t output = 0;
+    CHECK(filter.Process(0, 0, output));
+    CHECK(output == 0);
+    // A quarter of the remaining difference per sample
+    CHECK(filter.Process(1000, SECOND_US, output));
+    CHECK(output == 250);
+
+    int32_t previous = output;
+    for (int i = 2; i < 40; i++) {
+        CHECK(filter.Process(1000, i * SECOND_US, output));
+        CHECK(output >= previous && output <= 1000);
+        previous = output;
+    }
+    CHECK_NEAR(output, 1000, 1);
+
+    // Negative values round to nearest as well
+    SensorFilter negative(config);
+    CHECK(negative.Process(0, 0, output));
+    for (int i = 1; i < 40; i++) {
+        CHECK(negative.Process(-1000, i * SECOND_US, output));
+    }
+    CHECK_NEAR(output, -1000, 1);
+}
+
+static void TestKalmanConverges() {
+    SensorFilterConfig config;
+    config.median_window = 1;
+    config.smoothing = kSensorFilterSmoothingKalman;
+    SensorFilter filter(config);
+
+    // Constant 25.00°C with ±0.50°C noise
+    uint32_t seed = 1;
+    int32_t output = 0;
+    double error_sum = 0;
+    int error_count = 0;
+    for (int i = 0; i < 600; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        int32_t noise = (int32_t)((seed >> 8) % 101) - 50;
+        CHECK(filter.Process(2500 + noise, i * SECOND_US, output));
+        if (i >= 300) {
+            error_sum += std::abs(output - 2500);
+            error_count++;
+        }
+    }
+    // Uniform ±50 noise has a mean absolute error of 25, the settled filter far less
+    CHECK(error_sum / error_count < 8);
+    CHECK_NEAR(output, 2500, 15);
+}
+
+static void TestResetRestartsAtNewValue() {
+    SensorFilterConfig config = RateOnlyConfig();
+    config.smoothing = kSensorFilterSmoothingKalman;
+    config.median_window = 3;
+    SensorFilter filter(config);
+
+    int32_t output = 0;
+    for (int i = 0; i < 20; i++) {
+        CHECK(filter.Process(2500, i * SECOND_US, output));
+    }
+    CHECK(output == 2500);
+
+    // What SensorManager does when the calibration offset changes by +5°C
+    filter.Reset();
+    CHECK(filter.Process(3000, 20 * SECOND_US, output));
+    CHECK(output == 3000);
+    CHECK(filter.Process(3000, 21 * SECOND_US, output));
+    CHECK(output == 3000);
+    CHECK(filter.rejected() == 0);
+}
+
+static void TestTraceAccuracy() {
+    SensorFilterConfig config;
+    config.median_window = 3;
+    config.smoothing = kSensorFilterSmoothingKalman;
+    config.max_rate = 100;
+    auto trace = MakeSensorTrace(4 * 3600, 30, 2 * 3600, 800);
+
+    SensorFilter filter(config);
+    double raw_error = 0, filtered_error = 0;
+    int compared = 0, spikes = 0, spikes_passed = 0;
+    int64_t step_time_us = 2LL * 3600 * SECOND_US;
+    int64_t step_settled_us = -1;
+    for (auto& point : trace) {
+        int32_t output = 0;
+        bool accepted = filter.Process(point.value, point.time_us, output);
+        if (point.spike) {
+            spikes++;
+            spikes_passed += accepted;
+        }
+        if (point.time_us >= step_time_us && step_settled_us < 0 && std::abs(output - point.truth) < 50) {
+            step_settled_us = point.time_us - step_time_us;
+        }
+        // Skip the warm-up and the seconds right after the step
+        bool settling = point.time_us < 60 * SECOND_US ||
+            (point.time_us >= step_time_us && point.time_us < step_time_us + 60 * SECOND_US);
+        if (!settling && !point.spike) {
+            raw_error += std::abs(point.value - point.truth);
+            filtered_error += std::abs(output - point.truth);
+            compared++;
+        }
+    }
+    printf("trace: %d spikes, %d passed; mean error raw %.1f, filtered %.1f (0.01°C); step settled after %lld s\n",
+        spikes, spikes_passed, raw_error / compared, filtered_error / compared, (long long)(step_settled_us / SECOND_US));
+    CHECK(spikes_passed == 0);
+    CHECK(filtered_error < raw_error / 2);
+    CHECK(step_settled_us >= 0 && step_settled_us <= 30 * SECOND_US);
+}
+
+int main() {
+    RUN_TEST(TestSpikeIsRejected);
+    RUN_TEST(TestStepIsAcceptedAfterMaxRejects);
+    RUN_TEST(TestInterruptedRejectsDoNotAcceptStep);
+    RUN_TEST(TestEmaConverges);
+    RUN_TEST(TestKalmanConverges);
+    RUN_TEST(TestResetRestartsAtNewValue);
+    RUN_TEST(TestTraceAccuracy);
+    return HostTestFailures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,41 @@
+// One standby string "23.5°C / 45.2%" built the ways the standby screens used to and do now
+#include "sensor_format.h"
+#include "host_bench.h"
+
+#include <cstdio>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+int main() {
+    int32_t temperature = 2345, humidity = 4520;
+    int step = 0;
+    auto next = [&]() {
+        // Vary the input a little so nothing is folded at compile time
+        step = (step + 1) & 63;
+        return step;
+    };
+
+    Benchmark("std::stringstream", 200000, [&]() {
+        int n = next();
+        std::stringstream stream;
+        stream << std::fixed << std::setprecision(1) << (temperature + n) / 100.0f << "°C / "
+            << (humidity + n) / 100.0f << "%";
+        std::string text = stream.str();
+        KeepResult(text);
+    });
+    Benchmark("snprintf into a std::string", 1000000, [&]() {
+        int n = next();
+        char buffer[40];
+        snprintf(buffer, sizeof(buffer), "%.1f°C / %.1f%%", (temperature + n) / 100.0f, (humidity + n) / 100.0f);
+        std::string text = buffer;
+        KeepResult(text);
+    });
+    Benchmark("FormatTemperatureHumidity", 5000000, [&]() {
+        int n = next();
+        char buffer[40];
+        FormatTemperatureHumidity(buffer, sizeof(buffer), temperature + n, humidity + n);
+        KeepResult(buffer);
+    });
+    return 0;
+}
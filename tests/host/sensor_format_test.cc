@@ -0,0 +1,130 @@
+// Fixed-point formatters: rounding, negative values and truncation to the buffer size
+#include "sensor_format.h"
+#include "host_test.h"
+
+#include <climits>
+#include <cstring>
+#include <string>
+
+static std::string Fixed(int32_t value, int decimals) {
+    char buffer[32];
+    size_t length = FormatFixed(buffer, sizeof(buffer), value, decimals);
+    CHECK(length == strlen(buffer));
+    return buffer;
+}
+
+// Reference: exact decimal rounding, half away from zero, on the integer value
+static std::string Reference(int32_t value, int decimals) {
+    int64_t divisor = decimals == 2 ? 1 : (decimals == 1 ? 10 : 100);
+    int64_t magnitude = value < 0 ? -(int64_t)value : value;
+    magnitude = (magnitude + divisor / 2) / divisor;
+    std::string text = std::to_string(magnitude);
+    if (decimals > 0) {
+        text.insert(0, decimals + 1 - std::min<size_t>(text.size(), decimals + 1), '0');
+        text.insert(text.size() - decimals, ".");
+    }
+    return (value < 0 && magnitude != 0 ? "-" : "") + text;
+}
+
+static void TestRounding() {
+    CHECK(Fixed(2345, 2) == "23.45");
+    CHECK(Fixed(2345, 1) == "23.5");
+    CHECK(Fixed(2344, 1) == "23.4");
+    CHECK(Fixed(2345, 0) == "23");
+    CHECK(Fixed(2350, 0) == "24");
+    CHECK(Fixed(9995, 1) == "100.0");
+    CHECK(Fixed(5, 1) == "0.1");
+    CHECK(Fixed(4, 1) == "0.0");
+    CHECK(Fixed(0, 2) == "0.00");
+    CHECK(Fixed(7, 2) == "0.07");
+    // Out of range decimals are clamped to 0..2
+    CHECK(Fixed(2345, 5) == "23.45");
+    CHECK(Fixed(2345, -1) == "23");
+}
+
+static void TestNegative() {
+    CHECK(Fixed(-2345, 1) == "-23.5");
+    CHECK(Fixed(-2344, 1) == "-23.4");
+    CHECK(Fixed(-5, 1) == "-0.1");
+    CHECK(Fixed(-7, 2) == "-0.07");
+    // Values that round to zero print without a sign
+    CHECK(Fixed(-4, 1) == "0.0");
+    CHECK(Fixed(-49, 0) == "0");
+    CHECK(Fixed(INT32_MIN, 2) == "-21474836.48");
+    CHECK(Fixed(INT32_MIN, 0) == "-21474836");
+    CHECK(Fixed(INT32_MAX, 1) == "21474836.5");
+}
+
+static void TestMatchesReference() {
+    // Every sensor value from -50.00 to 150.00 at each precision
+    int mismatches = 0;
+    for (int32_t value = -5000; value <= 15000; value++) {
+        for (int decimals = 0; decimals <= 2; decimals++) {
+            if (Fixed(value, decimals) != Reference(value, decimals)) {
+                if (mismatches++ < 5) {
+                    fprintf(stderr, "%d/%d: %s vs %s\n", (int)value, decimals,
+                        Fixed(value, decimals).c_str(), Reference(value, decimals).c_str());
+                }
+            }
+        }
+    }
+    CHECK(mismatches == 0);
+}
+
+static void TestBufferBounds() {
+    char buffer[16];
+
+    // Size 0 writes nothing at all
+    memset(buffer, 'x', sizeof(buffer));
+    CHECK(FormatFixed(buffer, 0, 2345, 1) == 0);
+    CHECK(FormatTemperature(buffer, 0, 2345) == 0);
+    CHECK(FormatTemperatureHumidity(buffer, 0, 2345, 4520) == 0);
+    CHECK(buffer[0] == 'x');
+
+    // Size 1 only has room for the terminator
+    CHECK(FormatFixed(buffer, 1, 2345, 1) == 0);
+    CHECK(buffer[0] == '\0');
+
+    // Truncated output keeps the leading digits and never passes size
+    for (size_t size = 1; size <= 8; size++) {
+        memset(buffer, 'x', sizeof(buffer));
+        size_t length = FormatFixed(buffer, size, -2345, 2);
+        CHECK(length == size - 1 || length == 6);
+        CHECK(length < size);
+        CHECK(buffer[length] == '\0');
+        CHECK(strncmp(buffer, "-23.45", length) == 0);
+        for (size_t i = size; i < sizeof(buffer); i++) {
+            CHECK(buffer[i] == 'x');
+        }
+    }
+}
+
+static void TestUnits() {
+    char buffer[40];
+    CHECK(FormatTemperature(buffer, sizeof(buffer), 2345) == strlen("23.5°C"));
+    CHECK(strcmp(buffer, "23.5°C") == 0);
+    CHECK(FormatHumidity(buffer, sizeof(buffer), 4520) == 5);
+    CHECK(strcmp(buffer, "45.2%") == 0);
+    CHECK(FormatTemperatureHumidity(buffer, sizeof(buffer), -512, 4520) == strlen("-5.1°C / 45.2%"));
+    CHECK(strcmp(buffer, "-5.1°C / 45.2%") == 0);
+
+    // "°" is two bytes, a buffer ending inside it drops the whole character
+    char small[16];
+    memset(small, 'x', sizeof(small));
+    CHECK(FormatTemperature(small, 6, 2345) == 4);
+    CHECK(strcmp(small, "23.5") == 0);
+    CHECK(FormatTemperature(small, 7, 2345) == 6);
+    CHECK(strcmp(small, "23.5°") == 0);
+    CHECK(FormatTemperatureHumidity(small, 12, 2345, 4520) == 11);
+    CHECK(strcmp(small, "23.5°C / 4") == 0);
+    CHECK(small[12] == 'x');
+}
+
+int main() {
+    RUN_TEST(TestRounding);
+    RUN_TEST(TestNegative);
+    RUN_TEST(TestMatchesReference);
+    RUN_TEST(TestBufferBounds);
+    RUN_TEST(TestUnits);
+    return HostTestFailures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,52 @@
+// SensorHistory: ingest cost and query latency with 30 days of 2 s samples, the default
+// DHT20 cadence, plus the size and encode time of the NVS snapshot
+#include "sensors/sensor_history.h"
+#include "host_bench.h"
+#include "settings.h"
+
+#define T0 1699984800u
+#define DAY (24 * 3600u)
+
+int main() {
+    SensorHistory history;
+    if (!history.Initialize()) {
+        return 1;
+    }
+    uint32_t time = T0;
+    auto ingest = [&]() {
+        history.Ingest(time, 20.0f + (time % 3600) * 0.001f, 50.0f);
+        time += 2;
+    };
+    Benchmark("Ingest, 2 s samples", 30 * DAY / 2 / 5, ingest);
+
+    const struct {
+        const char* name;
+        uint32_t span;
+    } ranges[] = {
+        {"GetStats, 1 h", 3600},
+        {"GetStats, 24 h", DAY},
+        {"GetStats, 7 days", 7 * DAY},
+        {"GetStats, 30 days", 30 * DAY},
+    };
+    for (auto& range : ranges) {
+        Benchmark(range.name, 20000, [&]() {
+            SensorHistoryStats stats;
+            history.GetStats(time - range.span, time, stats);
+            KeepResult(stats);
+        });
+    }
+    Benchmark("GetSeries, 30 days into 24 points", 20000, [&]() {
+        SensorHistoryBucket buckets[24];
+        KeepResult(history.GetSeries(time - 30 * DAY, time, buckets, 24));
+    });
+
+    // Forces a new closed hour before every save so none is skipped
+    Benchmark("SaveSnapshot, 30 days", 200, [&]() {
+        for (int i = 0; i < 1800; i++) {
+            ingest();
+        }
+        history.SaveSnapshot();
+    });
+    printf("Snapshot size: %zu bytes\n", Settings("sensor_history").GetBlob("hourly").size());
+    return 0;
+}
@@ -0,0 +1,137 @@
+// SensorHistory: level selection for stats and series, and the NVS snapshot that has to
+// bring back 30 days of hourly data across reboots without growing.
+#include "sensors/sensor_history.h"
+#include "host_test.h"
+#include "settings.h"
+
+#include <vector>
+
+// 2023-11-14 18:00 UTC, aligned to the 6 h snapshot buckets
+#define T0 1699984800u
+#define HOUR 3600u
+#define DAY (24 * HOUR)
+
+// 20.00°C plus 0.1°C per hour of the day, 50 %RH, every `step` seconds
+static void Fill(SensorHistory& history, uint32_t from, uint32_t to, uint32_t step) {
+    for (uint32_t time = from; time < to; time += step) {
+        history.Ingest(time, 20.0f + ((time - T0) / HOUR % 24) * 0.1f, 50.0f);
+    }
+}
+
+static size_t SnapshotSize() {
+    return Settings("sensor_history").GetBlob("hourly").size();
+}
+
+static void TestRecentStatsUseRawSamples() {
+    Settings("sensor_history", true).EraseAll();
+    SensorHistory history;
+    CHECK(history.Initialize());
+    Fill(history, T0, T0 + 2 * HOUR, 2);
+
+    SensorHistoryStats stats;
+    CHECK(history.GetStats(T0 + HOUR + 600, T0 + HOUR + 1200, stats));
+    CHECK(stats.count == 300);
+    CHECK(stats.start == T0 + HOUR + 600);
+    CHECK(stats.end == T0 + HOUR + 1199);
+    CHECK_NEAR(stats.temperature_mean, 20.1, 0.001);
+    CHECK(!history.GetStats(T0 + 3 * HOUR, T0 + 4 * HOUR, stats));
+}
+
+static void TestLongRangesUseCoarserLevels() {
+    Settings("sensor_history", true).EraseAll();
+    SensorHistory history;
+    CHECK(history.Initialize());
+    Fill(history, T0, T0 + 3 * DAY, 10);
+    uint32_t now = T0 + 3 * DAY;
+
+    // Older than the raw ring and minute level: the stats come from 15 min or hour buckets
+    SensorHistoryStats stats;
+    CHECK(history.GetStats(now - 2 * DAY, now, stats));
+    CHECK(stats.start == now - 2 * DAY);
+    CHECK(stats.count == 2 * DAY / 10);
+    CHECK_NEAR(stats.temperature_min, 20.0, 0.001);
+    CHECK_NEAR(stats.temperature_max, 22.3, 0.001);
+    CHECK_NEAR(stats.temperature_mean, 21.15, 0.001);
+
+    // Nothing reaches 30 days back: the levels holding the oldest data tie, and the one
+    // whose scan fits the 24 point budget best is used, not the finest
+    SensorHistoryBucket buckets[24];
+    size_t points = history.GetSeries(now - 30 * DAY, now, buckets, 24);
+    CHECK(points > 0 && points <= 24);
+    CHECK(buckets[0].start == T0);
+    uint32_t total = 0;
+    for (size_t i = 0; i < points; i++) {
+        total += buckets[i].count;
+    }
+    CHECK(total == 3 * DAY / 10);
+    CHECK(history.GetStats(now - 30 * DAY, now, stats));
+    CHECK(stats.start == T0);
+    CHECK(stats.count == 3 * DAY / 10);
+}
+
+static void TestSnapshotKeepsThirtyDays() {
+    Settings("sensor_history", true).EraseAll();
+    uint32_t now = T0 + 30 * DAY;
+    {
+        SensorHistory history;
+        CHECK(history.Initialize());
+        Fill(history, T0, now + 1, 60);
+        history.SaveSnapshot();
+    }
+    // A week at 1 h, the 23 days before at 6 h
+    CHECK(SnapshotSize() > 0);
+    CHECK(SnapshotSize() <= 8 + (168 + 23 * 4 + 1) * 16);
+
+    SensorHistory restored;
+    CHECK(restored.Initialize());
+    SensorHistoryStats stats;
+    CHECK(restored.GetStats(now - 30 * DAY, now, stats));
+    CHECK(stats.start == T0);
+    CHECK(stats.end == now);
+    // The hourly ring holds 720 buckets including the open one, so the first hour was dropped
+    // and its 6 h bucket starts at T0 with five hours in it
+    CHECK(stats.count == 30 * DAY / 60 - 60);
+    CHECK_NEAR(stats.temperature_min, 20.0, 0.001);
+    CHECK_NEAR(stats.temperature_max, 22.3, 0.001);
+    // Means are stored rounded to 0.01 per bucket
+    CHECK_NEAR(stats.temperature_mean, 21.15, 0.01);
+
+    // The last week is still hourly
+    CHECK(restored.GetStats(now - 2 * HOUR, now - HOUR, stats));
+    CHECK(stats.count == 60);
+    CHECK_NEAR(stats.temperature_mean, 20.0 + ((now - 2 * HOUR - T0) / HOUR % 24) * 0.1, 0.001);
+}
+
+static void TestSnapshotDoesNotGrowAcrossReboots() {
+    Settings("sensor_history", true).EraseAll();
+    uint32_t time = T0;
+    size_t largest = 0;
+    for (int boot = 0; boot < 8; boot++) {
+        SensorHistory history;
+        CHECK(history.Initialize());
+        Fill(history, time, time + 10 * DAY, 300);
+        time += 10 * DAY;
+        history.SaveSnapshot();
+        largest = std::max(largest, SnapshotSize());
+
+        // Never more than 30 days back from the newest closed hour
+        SensorHistoryStats stats;
+        CHECK(history.GetStats(0, time, stats));
+        CHECK(stats.end == time);
+    }
+    SensorHistory history;
+    CHECK(history.Initialize());
+    SensorHistoryStats stats;
+    CHECK(history.GetStats(0, time, stats));
+    CHECK(stats.start >= time - 30 * DAY - 6 * HOUR);
+    CHECK(stats.end == time - HOUR);
+    CHECK(largest <= 8 + (168 + 23 * 4 + 1) * 16);
+}
+
+int main() {
+    RUN_TEST(TestRecentStatsUseRawSamples);
+    RUN_TEST(TestLongRangesUseCoarserLevels);
+    RUN_TEST(TestSnapshotKeepsThirtyDays);
+    RUN_TEST(TestSnapshotDoesNotGrowAcrossReboots);
+    return HostTestFailures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,158 @@
+// SensorManager on the simulated DHT20: the bus scheduler task samples it, injected faults
+// must show up in the statistics, keep the last reading and recover on their own.
+#include "sensors/sensor_manager.h"
+#include "host_test.h"
+
+#include <atomic>
+#include <cstdlib>
+
+#define TEST_TEMPERATURE 22.5f
+#define TEST_HUMIDITY 45.0f
+// Long enough for several sample periods plus a stuck conversion
+#define TEST_WAIT_MS 5000
+
+static SensorManager& manager = SensorManager::GetInstance();
+static DHT20Simulator* simulator = nullptr;
+// Remaining conversions that read as a temperature spike, for the outlier test
+static std::atomic<int> spikes = 0;
+
+static SensorReading Reading() {
+    SensorReading reading;
+    manager.GetReading(reading);
+    return reading;
+}
+
+// Waits for a successful sample newer than `after_us`
+static bool WaitForFreshReading(int64_t after_us) {
+    return WaitFor([after_us]() {
+        auto reading = Reading();
+        return reading.valid && reading.timestamp_us > after_us;
+    }, TEST_WAIT_MS);
+}
+
+// Runs `fault` and checks that the reading kept its value meanwhile
+static void CheckReadingHeldDuring(std::function<void()> fault) {
+    std::atomic<bool> done = false;
+    std::atomic<float> max_error = 0.0f;
+    std::thread watcher([&]() {
+        while (!done) {
+            auto reading = Reading();
+            if (reading.valid) {
+                max_error = std::max<float>(max_error, std::fabs(reading.temperature - TEST_TEMPERATURE));
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    });
+    fault();
+    done = true;
+    watcher.join();
+    CHECK(max_error < 0.05f);
+}
+
+static void TestInitialize() {
+    CHECK(manager.Initialize(nullptr));
+    simulator = manager.GetDht20Simulator();
+    CHECK(simulator != nullptr);
+    // Replace the daily cycle with a fixed climate plus on-demand spikes
+    simulator->SetScript([](int64_t /* time_us */, float& temperature, float& humidity) {
+        temperature = TEST_TEMPERATURE;
+        if (spikes > 0) {
+            spikes--;
+            temperature += 10.0f;
+        }
+        humidity = TEST_HUMIDITY;
+    });
+    // Keep sampling at the shortest period instead of backing off while nothing changes
+    manager.RequestSamplePeriod(CONFIG_DHT20_SAMPLE_INTERVAL_MS, 10 * 60 * 1000);
+
+    // The first samples came from the daily cycle; the rate check accepts the step
+    // to the scripted climate after a few rejected samples
+    CHECK(WaitFor([]() {
+        auto reading = Reading();
+        return reading.valid && std::fabs(reading.temperature - TEST_TEMPERATURE) < 0.01f &&
+            std::fabs(reading.humidity - TEST_HUMIDITY) < 0.01f;
+    }, TEST_WAIT_MS));
+    CHECK(manager.GetBusScheduler()->GetStats().transactions > 0);
+}
+
+static void TestOutlierIsFiltered() {
+    auto conversions = simulator->GetStats().conversions;
+    auto errors = manager.GetBusScheduler()->GetStats().errors;
+    CheckReadingHeldDuring([&]() {
+        spikes = 1;
+        CHECK(WaitFor([&]() { return simulator->GetStats().conversions >= conversions + 3; }, TEST_WAIT_MS));
+    });
+    CHECK(spikes == 0);
+    // A rejected sample is not a bus error
+    CHECK(manager.GetBusScheduler()->GetStats().errors == errors);
+}
+
+static void TestNackIsCountedAndRecovers() {
+    auto faults = simulator->GetStats().faults;
+    auto errors = manager.GetBusScheduler()->GetStats().errors;
+    int64_t start = esp_timer_get_time();
+    CheckReadingHeldDuring([&]() {
+        simulator->InjectFault(kDht20FaultNack, 3);
+        CHECK(WaitFor([&]() { return simulator->GetStats().faults == faults + 3; }, TEST_WAIT_MS));
+        CHECK(WaitForFreshReading(esp_timer_get_time()));
+    });
+    // Every NACK fails exactly one measurement
+    CHECK(manager.GetBusScheduler()->GetStats().errors == errors + 3);
+    CHECK(Reading().timestamp_us > start);
+}
+
+static void TestTimeoutIsCountedAndRecovers() {
+    auto faults = simulator->GetStats().faults;
+    auto errors = manager.GetBusScheduler()->GetStats().errors;
+    CheckReadingHeldDuring([&]() {
+        simulator->InjectFault(kDht20FaultTimeout, 1);
+        CHECK(WaitFor([&]() { return simulator->GetStats().faults == faults + 1; }, TEST_WAIT_MS));
+        CHECK(WaitForFreshReading(esp_timer_get_time()));
+    });
+    CHECK(manager.GetBusScheduler()->GetStats().errors == errors + 1);
+}
+
+static void TestStuckBusyIsCountedAndRecovers() {
+    auto bus_stats = manager.GetBusScheduler()->GetStats();
+    CheckReadingHeldDuring([&]() {
+        simulator->InjectFault(kDht20FaultStuckBusy);
+        // At least one conversion runs into the driver's measurement timeout
+        CHECK(WaitFor([&]() {
+            return manager.GetBusScheduler()->GetStats().errors > bus_stats.errors;
+        }, TEST_WAIT_MS));
+        int64_t cleared_us = esp_timer_get_time();
+        simulator->InjectFault(kDht20FaultNone);
+        CHECK(WaitForFreshReading(cleared_us));
+    });
+    CHECK(manager.GetBusScheduler()->GetStats().busy_polls > bus_stats.busy_polls);
+}
+
+static void TestBadCrcIsCountedAndRecovers() {
+    auto faults = simulator->GetStats().faults;
+    auto errors = manager.GetBusScheduler()->GetStats().errors;
+    CheckReadingHeldDuring([&]() {
+        simulator->InjectFault(kDht20FaultBadCrc, 2);
+        CHECK(WaitFor([&]() { return simulator->GetStats().faults == faults + 2; }, TEST_WAIT_MS));
+        CHECK(WaitForFreshReading(esp_timer_get_time()));
+    });
+    CHECK(manager.GetBusScheduler()->GetStats().errors == errors + 2);
+    auto reading = Reading();
+    CHECK(reading.valid);
+    CHECK_NEAR(reading.humidity, TEST_HUMIDITY, 0.01);
+}
+
+int main() {
+    RUN_TEST(TestInitialize);
+    if (simulator == nullptr) {
+        return 1;
+    }
+    RUN_TEST(TestOutlierIsFiltered);
+    RUN_TEST(TestNackIsCountedAndRecovers);
+    RUN_TEST(TestTimeoutIsCountedAndRecovers);
+    RUN_TEST(TestStuckBusyIsCountedAndRecovers);
+    RUN_TEST(TestBadCrcIsCountedAndRecovers);
+
+    // The sampler task keeps running, skip the destructors of the singletons it uses
+    fflush(stderr);
+    std::_Exit(HostTestFailures() == 0 ? 0 : 1);
+}
@@ -0,0 +1,27 @@
+// Cost of SensorRules::Evaluate per sample with SENSOR_RULES_MAX rules of every kind
+#include "sensors/sensor_rules.h"
+#include "host_bench.h"
+#include "settings.h"
+
+#include <string>
+
+int main() {
+    Settings("sensor_rules", true).EraseAll();
+    static const char* const templates[] = {
+        "temperature > %d", "humidity < %d", "temperature rise %d in 10m", "humidity drop %d in 1h",
+    };
+    SensorRules rules;
+    for (int i = 0; i < SENSOR_RULES_MAX; i++) {
+        char expression[48];
+        // High thresholds: nothing fires, the benchmark measures evaluation only
+        snprintf(expression, sizeof(expression), templates[i % 4], i % 2 ? 5 : 90 + i % 10);
+        rules.AddRule(expression, kSensorRuleActionAlert, "");
+    }
+
+    uint32_t time_s = 0;
+    Benchmark("Evaluate, 100 rules", 200000, [&]() {
+        time_s++;
+        rules.Evaluate(time_s, 22.0f + (time_s % 10) * 0.01f, 50.0f + (time_s % 7) * 0.01f);
+    });
+    return 0;
+}
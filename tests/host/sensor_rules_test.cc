@@ -0,0 +1,163 @@
+// SensorRules: expression parsing, thresholds with hysteresis, rise / drop windows, and
+// loading stored rules, including entries from other firmware versions.
+#include "sensors/sensor_rules.h"
+#include "host_test.h"
+#include "settings.h"
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Rules fired by Evaluate, by id
+static std::vector<int> fired;
+
+static void Watch(SensorRules& rules) {
+    fired.clear();
+    rules.OnRuleTriggered([](const SensorRuleInfo& rule) {
+        fired.push_back(rule.id);
+    });
+}
+
+static bool Rejects(SensorRules& rules, const char* expression) {
+    try {
+        rules.AddRule(expression, kSensorRuleActionAlert, "");
+    } catch (const std::invalid_argument&) {
+        return true;
+    }
+    return false;
+}
+
+static void TestParse() {
+    Settings("sensor_rules", true).EraseAll();
+    SensorRules rules;
+    CHECK(Rejects(rules, ""));
+    CHECK(Rejects(rules, "temperature >"));
+    CHECK(Rejects(rules, "pressure > 1000"));
+    CHECK(Rejects(rules, "temperature == 20"));
+    CHECK(Rejects(rules, "temperature > warm"));
+    CHECK(Rejects(rules, "temperature > 20abc"));
+    CHECK(Rejects(rules, "temperature rise -1"));
+    CHECK(Rejects(rules, "temperature rise 2 in 25h"));
+    CHECK(Rejects(rules, "temperature rise 2 in"));
+    CHECK(Rejects(rules, "temperature > 20 hyst -1"));
+    // `in` only applies to rise / drop
+    CHECK(Rejects(rules, "temperature > 20 in 10m"));
+    CHECK(rules.GetRules().empty());
+
+    // Any run of spaces and tabs separates words
+    int id = rules.AddRule("  humidity\t>=  70   hyst 2 ", kSensorRuleActionSound, "Too humid");
+    auto stored = rules.GetRules();
+    CHECK(stored.size() == 1);
+    CHECK(stored[0].id == id);
+    CHECK(stored[0].action == kSensorRuleActionSound);
+    // Tabs would break the stored format and are replaced
+    CHECK(stored[0].expression == "  humidity >=  70   hyst 2 ");
+    CHECK(stored[0].message == "Too humid");
+    CHECK(rules.AddRule("temperature drop 3 in 10m", kSensorRuleActionAlert, "") == id + 1);
+}
+
+static void TestThresholdWithHysteresis() {
+    Settings("sensor_rules", true).EraseAll();
+    SensorRules rules;
+    Watch(rules);
+    int id = rules.AddRule("temperature > 30 hyst 1", kSensorRuleActionAlert, "");
+
+    rules.Evaluate(0, 30.0f, 50.0f);
+    CHECK(fired.empty());
+    rules.Evaluate(1, 30.01f, 50.0f);
+    CHECK(fired.size() == 1 && fired[0] == id);
+    // Stays disarmed until the value recedes below 29.01
+    rules.Evaluate(2, 35.0f, 50.0f);
+    rules.Evaluate(3, 29.5f, 50.0f);
+    rules.Evaluate(4, 31.0f, 50.0f);
+    CHECK(fired.size() == 1);
+    rules.Evaluate(5, 29.0f, 50.0f);
+    rules.Evaluate(6, 31.0f, 50.0f);
+    CHECK(fired.size() == 2);
+
+    int below = rules.AddRule("humidity <= 30", kSensorRuleActionAlert, "");
+    rules.Evaluate(7, 20.0f, 30.01f);
+    CHECK(fired.size() == 2);
+    rules.Evaluate(8, 20.0f, 30.0f);
+    CHECK(fired.size() == 3 && fired[2] == below);
+}
+
+static void TestRiseWithinWindow() {
+    Settings("sensor_rules", true).EraseAll();
+    SensorRules rules;
+    Watch(rules);
+    // 80 s window in 8 slots of 10 s
+    rules.AddRule("temperature rise 2 in 80s", kSensorRuleActionAlert, "");
+
+    // 1.9 in 60 s does not fire
+    for (uint32_t t = 0; t <= 60; t += 5) {
+        rules.Evaluate(t, 20.0f + 1.9f * t / 60, 50.0f);
+    }
+    CHECK(fired.empty());
+    // 2.1 above the minimum 65 s ago fires
+    rules.Evaluate(65, 22.1f, 50.0f);
+    CHECK(fired.size() == 1);
+
+    // A slow rise of 2 over 10 minutes never does
+    Settings("sensor_rules", true).EraseAll();
+    SensorRules slow;
+    Watch(slow);
+    slow.AddRule("temperature rise 2 in 80s", kSensorRuleActionAlert, "");
+    for (uint32_t t = 0; t <= 600; t += 5) {
+        slow.Evaluate(t, 20.0f + 2.0f * t / 600, 50.0f);
+    }
+    CHECK(fired.empty());
+}
+
+static void TestSaveAndLoad() {
+    Settings("sensor_rules", true).EraseAll();
+    {
+        SensorRules rules;
+        rules.AddRule("temperature > 30", kSensorRuleActionAlert, "Hot");
+        int removed = rules.AddRule("humidity > 80", kSensorRuleActionSound, "");
+        rules.AddRule("humidity drop 10 in 1h", kSensorRuleActionReminder, "Dry");
+        CHECK(rules.RemoveRule(removed));
+        CHECK(!rules.RemoveRule(removed));
+    }
+
+    SensorRules loaded;
+    loaded.Load();
+    auto stored = loaded.GetRules();
+    CHECK(stored.size() == 2);
+    CHECK(stored.size() == 2 && stored[0].id == 1 && stored[0].message == "Hot");
+    CHECK(stored.size() == 2 && stored[1].id == 3 && stored[1].action == kSensorRuleActionReminder);
+    // Ids are not reused after a restart
+    CHECK(loaded.AddRule("temperature < 10", kSensorRuleActionAlert, "") == 4);
+}
+
+static void TestLoadDropsInvalidEntries() {
+    std::string text =
+        "1\t0\ttemperature > 30\tok\n"
+        "2\t3\ttemperature > 31\tunknown action\n"
+        "3\t-1\ttemperature > 32\tnegative action\n"
+        "4\tx\ttemperature > 33\tnot a number\n"
+        "5\t1\ttemperature ~ 34\tdoes not compile\n"
+        "6\t2\ttemperature > 35\n"
+        "7\t2\thumidity > 70\tlast line without newline";
+    Settings settings("sensor_rules", true);
+    settings.EraseAll();
+    settings.SetBlob("rules", text.data(), text.size());
+
+    SensorRules rules;
+    rules.Load();
+    auto stored = rules.GetRules();
+    CHECK(stored.size() == 2);
+    CHECK(stored.size() == 2 && stored[0].id == 1 && stored[1].id == 7);
+    for (auto& rule : stored) {
+        CHECK(rule.action >= kSensorRuleActionAlert && rule.action <= kSensorRuleActionReminder);
+    }
+}
+
+int main() {
+    RUN_TEST(TestParse);
+    RUN_TEST(TestThresholdWithHysteresis);
+    RUN_TEST(TestRiseWithinWindow);
+    RUN_TEST(TestSaveAndLoad);
+    RUN_TEST(TestLoadDropsInvalidEntries);
+    return HostTestFailures() == 0 ? 0 : 1;
+}
@@ -0,0 +1,45 @@
+#ifndef SENSOR_TRACE_H
+#define SENSOR_TRACE_H
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// A DHT20 temperature trace in 0.01°C at 1 s: a slow drift, read noise, single-sample
+// spikes every few minutes and one real step, the shapes the filter has to tell apart.
+// Deterministic, so accuracy checks and benchmark runs see the same input.
+struct SensorTracePoint {
+    int64_t time_us;
+    int32_t truth;      // Value without noise or spikes
+    int32_t value;      // What the sensor reported
+    bool spike;
+};
+
+inline std::vector<SensorTracePoint> MakeSensorTrace(int seconds, int noise, int step_at = -1, int step = 0) {
+    std::vector<SensorTracePoint> trace;
+    trace.reserve(seconds);
+    uint32_t seed = 12345;
+    auto next = [&seed]() {
+        seed = seed * 1664525u + 1013904223u;
+        return seed >> 8;
+    };
+    for (int i = 0; i < seconds; i++) {
+        SensorTracePoint point;
+        point.time_us = (int64_t)i * 1000000;
+        point.truth = 2400 + (int32_t)lround(150.0 * sin(2.0 * M_PI * i / 3600.0));
+        if (step_at >= 0 && i >= step_at) {
+            point.truth += step;
+        }
+        // Sum of two uniforms, roughly bell shaped within ±noise
+        int32_t n = (int32_t)(next() % (noise + 1)) + (int32_t)(next() % (noise + 1)) - noise;
+        point.value = point.truth + n;
+        point.spike = i > 10 && i % 197 == 0;
+        if (point.spike) {
+            point.value += (next() & 1) ? 1500 : -1500;
+        }
+        trace.push_back(point);
+    }
+    return trace;
+}
+
+#endif // SENSOR_TRACE_H
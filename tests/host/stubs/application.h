@@ -0,0 +1,19 @@
+#ifndef APPLICATION_H
+#define APPLICATION_H
+
+#include <functional>
+
+// The main task is the caller's thread: scheduled work runs at once
+class Application {
+public:
+    static Application& GetInstance() {
+        static Application instance;
+        return instance;
+    }
+
+    void Schedule(std::function<void()>&& callback) {
+        callback();
+    }
+};
+
+#endif // APPLICATION_H
@@ -0,0 +1,11 @@
+#ifndef BOARD_H
+#define BOARD_H
+
+// Only the power save levels are used by the sensor code
+enum class PowerSaveLevel {
+    LOW_POWER,
+    BALANCED,
+    PERFORMANCE,
+};
+
+#endif // BOARD_H
@@ -0,0 +1,19 @@
+#ifndef CJSON_H
+#define CJSON_H
+
+// Stats output is not checked on the host: objects are never built and adding to them does nothing
+#include <stddef.h>
+
+typedef struct cJSON cJSON;
+
+static inline cJSON* cJSON_CreateObject(void) { return NULL; }
+static inline cJSON* cJSON_CreateArray(void) { return NULL; }
+static inline cJSON* cJSON_CreateNumber(double) { return NULL; }
+static inline cJSON* cJSON_AddNumberToObject(cJSON*, const char*, double) { return NULL; }
+static inline cJSON* cJSON_AddStringToObject(cJSON*, const char*, const char*) { return NULL; }
+static inline cJSON* cJSON_AddBoolToObject(cJSON*, const char*, int) { return NULL; }
+static inline int cJSON_AddItemToObject(cJSON*, const char*, cJSON*) { return 1; }
+static inline int cJSON_AddItemToArray(cJSON*, cJSON*) { return 1; }
+static inline void cJSON_Delete(cJSON*) {}
+
+#endif // CJSON_H
@@ -0,0 +1,42 @@
+#ifndef DRIVER_I2C_MASTER_H
+#define DRIVER_I2C_MASTER_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#include "esp_err.h"
+
+typedef struct i2c_master_bus_t* i2c_master_bus_handle_t;
+typedef struct i2c_master_dev_t* i2c_master_dev_handle_t;
+
+typedef enum {
+    I2C_ADDR_BIT_LEN_7,
+    I2C_ADDR_BIT_LEN_10,
+} i2c_addr_bit_len_t;
+
+typedef struct {
+    i2c_addr_bit_len_t dev_addr_length;
+    uint16_t device_address;
+    uint32_t scl_speed_hz;
+    uint32_t scl_wait_us;
+    struct {
+        uint32_t disable_ack_check : 1;
+    } flags;
+} i2c_device_config_t;
+
+// There is no bus on the host, devices must be built on an I2cTransport
+inline esp_err_t i2c_master_bus_add_device(i2c_master_bus_handle_t, const i2c_device_config_t*, i2c_master_dev_handle_t*) {
+    return ESP_ERR_NOT_SUPPORTED;
+}
+inline esp_err_t i2c_master_transmit(i2c_master_dev_handle_t, const uint8_t*, size_t, int) {
+    return ESP_ERR_NOT_SUPPORTED;
+}
+inline esp_err_t i2c_master_receive(i2c_master_dev_handle_t, uint8_t*, size_t, int) {
+    return ESP_ERR_NOT_SUPPORTED;
+}
+inline esp_err_t i2c_master_transmit_receive(i2c_master_dev_handle_t, const uint8_t*, size_t, uint8_t*, size_t, int) {
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+#endif // DRIVER_I2C_MASTER_H
@@ -0,0 +1,25 @@
+#ifndef ESP_LOG_H
+#define ESP_LOG_H
+
+#include <stdarg.h>
+#include <stdio.h>
+
+// Not format-checked: main/ logs size_t with %u, which matches on the 32-bit targets.
+// Plain C as well, for the GIF decoder
+static inline void host_log(char level, const char* tag, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    fprintf(stderr, "%c (%s) ", level, tag);
+    vfprintf(stderr, format, args);
+    fputc('\n', stderr);
+    va_end(args);
+}
+
+// Errors, warnings and info go to stderr so a failing test shows what the driver saw
+#define ESP_LOGE(tag, format, ...) host_log('E', tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) host_log('W', tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) host_log('I', tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) do { if (0) host_log('D', tag, format, ##__VA_ARGS__); } while (0)
+#define ESP_LOGV(tag, format, ...) do { if (0) host_log('V', tag, format, ##__VA_ARGS__); } while (0)
+
+#endif // ESP_LOG_H
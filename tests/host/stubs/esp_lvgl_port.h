@@ -0,0 +1,22 @@
+#ifndef ESP_LVGL_PORT_H
+#define ESP_LVGL_PORT_H
+
+#include "esp_err.h"
+
+#include <cstdint>
+
+// The LVGL lock, recursive as on the device. Tests hold it around lv_timer_handler()
+bool lvgl_port_lock(uint32_t timeout_ms);
+void lvgl_port_unlock(void);
+
+typedef enum {
+    LVGL_PORT_EVENT_DISPLAY = 0x01,
+    LVGL_PORT_EVENT_TOUCH = 0x02,
+    LVGL_PORT_EVENT_USER = 0x80,
+} lvgl_port_event_type_t;
+
+// Counted, the host has no LVGL task to wake
+esp_err_t lvgl_port_task_wake(lvgl_port_event_type_t event, void* param);
+uint32_t lvgl_port_task_wakes();
+
+#endif // ESP_LVGL_PORT_H
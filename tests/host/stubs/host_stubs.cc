@@ -0,0 +1,149 @@
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+struct HostTask {
+    std::string name;
+    std::mutex mutex;
+    std::condition_variable notified;
+    uint32_t notify_count = 0;
+    bool deleted = false;
+};
+
+static thread_local HostTask* current_task = nullptr;
+
+int64_t esp_timer_get_time() {
+    static const auto start = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Like tasks, timers are never freed: a sleeping thread may still look at a deleted one
+struct esp_timer {
+    esp_timer_cb_t callback;
+    void* arg;
+    std::mutex mutex;
+    uint64_t armed = 0;       // Bumped by every start and stop, a thread only fires its own arming
+    bool running = false;
+};
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t* args, esp_timer_handle_t* out_handle) {
+    auto timer = new esp_timer();
+    timer->callback = args->callback;
+    timer->arg = args->arg;
+    *out_handle = timer;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us) {
+    uint64_t armed;
+    {
+        std::lock_guard<std::mutex> lock(timer->mutex);
+        if (timer->running) {
+            return ESP_ERR_INVALID_STATE;
+        }
+        timer->running = true;
+        armed = ++timer->armed;
+    }
+    std::thread([timer, armed, timeout_us]() {
+        std::this_thread::sleep_for(std::chrono::microseconds(timeout_us));
+        {
+            std::lock_guard<std::mutex> lock(timer->mutex);
+            if (timer->armed != armed) {
+                return;
+            }
+            timer->running = false;
+        }
+        timer->callback(timer->arg);
+    }).detach();
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer) {
+    std::lock_guard<std::mutex> lock(timer->mutex);
+    if (!timer->running) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    timer->running = false;
+    timer->armed++;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer) {
+    std::lock_guard<std::mutex> lock(timer->mutex);
+    timer->running = false;
+    timer->armed++;
+    return ESP_OK;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t function, const char* name, uint32_t /* stack_depth */, void* arg,
+    UBaseType_t /* priority */, TaskHandle_t* handle) {
+    // Tasks live as long as the process, like most tasks on the device
+    auto task = new HostTask();
+    task->name = name;
+    if (handle != nullptr) {
+        *handle = task;
+    }
+    std::thread([task, function, arg]() {
+        current_task = task;
+        function(arg);
+    }).detach();
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task) {
+    if (task == nullptr) {
+        task = xTaskGetCurrentTaskHandle();
+    }
+    std::lock_guard<std::mutex> lock(task->mutex);
+    task->deleted = true;
+}
+
+void vTaskDelay(TickType_t ticks) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ticks * 1000 / configTICK_RATE_HZ));
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+    if (current_task == nullptr) {
+        // Threads not started by xTaskCreate, e.g. the test's main thread
+        current_task = new HostTask();
+    }
+    return current_task;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    {
+        std::lock_guard<std::mutex> lock(task->mutex);
+        task->notify_count++;
+    }
+    task->notified.notify_one();
+    return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks) {
+    auto task = xTaskGetCurrentTaskHandle();
+    std::unique_lock<std::mutex> lock(task->mutex);
+    auto ready = [task]() { return task->notify_count > 0; };
+    if (ticks == portMAX_DELAY) {
+        task->notified.wait(lock, ready);
+    } else {
+        task->notified.wait_for(lock, std::chrono::milliseconds(ticks * 1000 / configTICK_RATE_HZ), ready);
+    }
+    // A deleted task must not touch its owner again, park it until the process exits
+    task->notified.wait(lock, [task]() { return !task->deleted; });
+    uint32_t count = task->notify_count;
+    if (count > 0) {
+        task->notify_count = clear_on_exit ? 0 : count - 1;
+    }
+    return count;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t /* task */) {
+    // Host threads have megabytes of stack, report it as plenty
+    return 64 * 1024;
+}
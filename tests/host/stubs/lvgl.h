@@ -0,0 +1,79 @@
+#ifndef LVGL_H
+#define LVGL_H
+
+// The LVGL timers the display code schedules its work with, run by lv_timer_handler()
+// from whichever thread the test treats as the LVGL task, and what the GIF decoder uses:
+// memory, lv_fs on top of stdio, and the lv_conf.h switches it is built with
+#include <limits.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LV_DRAW_SW_ASM_NONE         0
+#define LV_DRAW_SW_ASM_NEON         1
+#define LV_DRAW_SW_ASM_HELIUM       2
+#define LV_USE_DRAW_SW_ASM          LV_DRAW_SW_ASM_NONE
+#define LV_GIF_CACHE_DECODE_DATA    0
+
+typedef struct lv_timer_t lv_timer_t;
+typedef struct lv_obj_t lv_obj_t;
+typedef struct lv_display_t lv_display_t;
+typedef struct lv_event_t lv_event_t;
+typedef void (*lv_timer_cb_t)(lv_timer_t* timer);
+
+lv_timer_t* lv_timer_create(lv_timer_cb_t timer_cb, uint32_t period, void* user_data);
+void lv_timer_delete(lv_timer_t* timer);
+void lv_timer_pause(lv_timer_t* timer);
+void lv_timer_resume(lv_timer_t* timer);
+void lv_timer_ready(lv_timer_t* timer);
+void lv_timer_reset(lv_timer_t* timer);
+bool lv_timer_get_paused(lv_timer_t* timer);
+void* lv_timer_get_user_data(lv_timer_t* timer);
+// Runs the timers that are due, returns the milliseconds until the next one
+uint32_t lv_timer_handler(void);
+
+uint32_t lv_tick_get(void);
+uint32_t lv_tick_elaps(uint32_t prev_tick);
+
+void* lv_malloc(size_t size);
+void* lv_realloc(void* data, size_t new_size);
+void lv_free(void* data);
+
+typedef enum {
+    LV_FS_RES_OK = 0,
+    LV_FS_RES_HW_ERR,
+    LV_FS_RES_NOT_EX = 3,
+    LV_FS_RES_UNKNOWN = 12,
+} lv_fs_res_t;
+
+typedef enum {
+    LV_FS_MODE_WR = 0x01,
+    LV_FS_MODE_RD = 0x02,
+} lv_fs_mode_t;
+
+typedef enum {
+    LV_FS_SEEK_SET = 0x00,
+    LV_FS_SEEK_CUR = 0x01,
+    LV_FS_SEEK_END = 0x02,
+} lv_fs_whence_t;
+
+// Paths are host paths, without a drive letter
+typedef struct {
+    void* file;
+} lv_fs_file_t;
+
+lv_fs_res_t lv_fs_open(lv_fs_file_t* file_p, const char* path, lv_fs_mode_t mode);
+lv_fs_res_t lv_fs_close(lv_fs_file_t* file_p);
+lv_fs_res_t lv_fs_read(lv_fs_file_t* file_p, void* buf, uint32_t btr, uint32_t* br);
+lv_fs_res_t lv_fs_seek(lv_fs_file_t* file_p, uint32_t pos, lv_fs_whence_t whence);
+lv_fs_res_t lv_fs_tell(lv_fs_file_t* file_p, uint32_t* pos);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LVGL_H
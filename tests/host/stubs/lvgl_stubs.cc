@@ -0,0 +1,158 @@
+#include <lvgl.h>
+#include <esp_lvgl_port.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct lv_timer_t {
+    lv_timer_cb_t callback;
+    uint32_t period;
+    void* user_data;
+    uint32_t last_run;
+    bool paused;
+};
+
+// Only touched with the LVGL lock held, as on the device
+static std::vector<lv_timer_t*> timers;
+static std::recursive_mutex lvgl_mutex;
+static std::atomic<uint32_t> task_wakes = 0;
+
+uint32_t lv_tick_get(void) {
+    static const auto start = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+uint32_t lv_tick_elaps(uint32_t prev_tick) {
+    return lv_tick_get() - prev_tick;
+}
+
+lv_timer_t* lv_timer_create(lv_timer_cb_t timer_cb, uint32_t period, void* user_data) {
+    auto timer = new lv_timer_t{timer_cb, period, user_data, lv_tick_get(), false};
+    timers.push_back(timer);
+    return timer;
+}
+
+void lv_timer_delete(lv_timer_t* timer) {
+    timers.erase(std::remove(timers.begin(), timers.end(), timer), timers.end());
+    delete timer;
+}
+
+void lv_timer_pause(lv_timer_t* timer) {
+    timer->paused = true;
+}
+
+void lv_timer_resume(lv_timer_t* timer) {
+    timer->paused = false;
+}
+
+void lv_timer_ready(lv_timer_t* timer) {
+    timer->last_run = lv_tick_get() - timer->period - 1;
+}
+
+void lv_timer_reset(lv_timer_t* timer) {
+    timer->last_run = lv_tick_get();
+}
+
+bool lv_timer_get_paused(lv_timer_t* timer) {
+    return timer->paused;
+}
+
+void* lv_timer_get_user_data(lv_timer_t* timer) {
+    return timer->user_data;
+}
+
+uint32_t lv_timer_handler(void) {
+    uint32_t next = UINT32_MAX;
+    // A callback may create or delete timers, walk a copy
+    auto due = timers;
+    for (auto timer : due) {
+        if (std::find(timers.begin(), timers.end(), timer) == timers.end() || timer->paused) {
+            continue;
+        }
+        uint32_t elapsed = lv_tick_elaps(timer->last_run);
+        if (elapsed >= timer->period) {
+            timer->last_run = lv_tick_get();
+            timer->callback(timer);
+            elapsed = 0;
+        }
+        next = std::min(next, timer->period - elapsed);
+    }
+    return next;
+}
+
+bool lvgl_port_lock(uint32_t timeout_ms) {
+    if (timeout_ms == 0) {
+        lvgl_mutex.lock();
+        return true;
+    }
+    // Polled rather than a timed mutex, which the thread sanitizer does not follow
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (!lvgl_mutex.try_lock()) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    return true;
+}
+
+void lvgl_port_unlock(void) {
+    lvgl_mutex.unlock();
+}
+
+esp_err_t lvgl_port_task_wake(lvgl_port_event_type_t /* event */, void* /* param */) {
+    task_wakes++;
+    return ESP_OK;
+}
+
+uint32_t lvgl_port_task_wakes() {
+    return task_wakes;
+}
+
+void* lv_malloc(size_t size) {
+    return malloc(size);
+}
+
+void* lv_realloc(void* data, size_t new_size) {
+    return realloc(data, new_size);
+}
+
+void lv_free(void* data) {
+    free(data);
+}
+
+lv_fs_res_t lv_fs_open(lv_fs_file_t* file_p, const char* path, lv_fs_mode_t mode) {
+    file_p->file = fopen(path, mode == LV_FS_MODE_RD ? "rb" : "r+b");
+    return file_p->file != nullptr ? LV_FS_RES_OK : LV_FS_RES_NOT_EX;
+}
+
+lv_fs_res_t lv_fs_close(lv_fs_file_t* file_p) {
+    fclose((FILE*)file_p->file);
+    file_p->file = nullptr;
+    return LV_FS_RES_OK;
+}
+
+lv_fs_res_t lv_fs_read(lv_fs_file_t* file_p, void* buf, uint32_t btr, uint32_t* br) {
+    size_t read = fread(buf, 1, btr, (FILE*)file_p->file);
+    if (br != nullptr) {
+        *br = read;
+    }
+    return read == btr || feof((FILE*)file_p->file) ? LV_FS_RES_OK : LV_FS_RES_HW_ERR;
+}
+
+lv_fs_res_t lv_fs_seek(lv_fs_file_t* file_p, uint32_t pos, lv_fs_whence_t whence) {
+    // Like LVGL, SEEK_CUR and SEEK_END take an unsigned offset
+    int origin = whence == LV_FS_SEEK_CUR ? SEEK_CUR : whence == LV_FS_SEEK_END ? SEEK_END : SEEK_SET;
+    return fseek((FILE*)file_p->file, pos, origin) == 0 ? LV_FS_RES_OK : LV_FS_RES_UNKNOWN;
+}
+
+lv_fs_res_t lv_fs_tell(lv_fs_file_t* file_p, uint32_t* pos) {
+    *pos = ftell((FILE*)file_p->file);
+    return LV_FS_RES_OK;
+}
@@ -0,0 +1,54 @@
+#ifndef SETTINGS_H
+#define SETTINGS_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+// In-memory NVS: values live for the lifetime of the test process
+class Settings {
+public:
+    Settings(const std::string& ns, bool /* read_write */ = false) : ns_(ns) {}
+
+    std::string GetString(const std::string& key, const std::string& default_value = "") {
+        auto it = Store().find(ns_ + "/" + key);
+        return it == Store().end() ? default_value : std::string(it->second.begin(), it->second.end());
+    }
+    void SetString(const std::string& key, const std::string& value) {
+        Store()[ns_ + "/" + key].assign(value.begin(), value.end());
+    }
+    int32_t GetInt(const std::string& key, int32_t default_value = 0) {
+        auto it = Store().find(ns_ + "/" + key);
+        return it == Store().end() ? default_value : std::stoi(std::string(it->second.begin(), it->second.end()));
+    }
+    void SetInt(const std::string& key, int32_t value) { SetString(key, std::to_string(value)); }
+    bool GetBool(const std::string& key, bool default_value = false) { return GetInt(key, default_value) != 0; }
+    void SetBool(const std::string& key, bool value) { SetInt(key, value); }
+    std::vector<uint8_t> GetBlob(const std::string& key) {
+        auto it = Store().find(ns_ + "/" + key);
+        return it == Store().end() ? std::vector<uint8_t>() : it->second;
+    }
+    bool SetBlob(const std::string& key, const void* data, size_t length) {
+        auto bytes = static_cast<const uint8_t*>(data);
+        Store()[ns_ + "/" + key].assign(bytes, bytes + length);
+        return true;
+    }
+    void EraseKey(const std::string& key) { Store().erase(ns_ + "/" + key); }
+    void EraseAll() {
+        auto prefix = ns_ + "/";
+        for (auto it = Store().begin(); it != Store().end();) {
+            it = it->first.compare(0, prefix.size(), prefix) == 0 ? Store().erase(it) : std::next(it);
+        }
+    }
+
+private:
+    std::string ns_;
+
+    static std::map<std::string, std::vector<uint8_t>>& Store() {
+        static std::map<std::string, std::vector<uint8_t>> store;
+        return store;
+    }
+};
+
+#endif // SETTINGS_H